@@ -37,6 +37,7 @@ message("Linking ${PROJNAME} to ${PLUGIN_INTERNAL_DEPS}")
 # add library dependencies here; leave ${PLUGIN_INTERNAL_DEPS} there unless you know what you're doing!
 target_link_libraries(${PROJNAME}
     ${PLUGIN_INTERNAL_DEPS}
+    ${ZLIB_LIBRARIES}
     )
 
 add_dependencies(${PROJNAME}
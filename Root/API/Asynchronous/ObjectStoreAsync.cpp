@@ -0,0 +1,91 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <memory>
+#include <boost/bind.hpp>
+#include "ObjectStoreAsync.h"
+#include "../Synchronized/ObjectStoreSync.h"
+#include "../DatabaseException.h"
+#include "../../Implementation/ImplementationException.h"
+#include "../../Support/Convert.h"
+
+using std::string;
+using boost::optional;
+
+namespace BrandonHaynes {
+namespace IndexedDB { 
+
+using Implementation::Key;
+using Implementation::Data;
+using Implementation::ImplementationException;
+using Implementation::TransactionContext;
+
+namespace API { 
+
+ObjectStoreAsync::ObjectStoreAsync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, const ObjectStoreSyncPtr& objectStore, Support::WorkerPool& workers)
+	: host(host), database(database), objectStore(objectStore), strand(new Support::WorkerPool::Strand(workers))
+	{
+	registerMethod("get", make_method(this, &ObjectStoreAsync::get));
+	registerMethod("put", make_method(this, &ObjectStoreAsync::put));
+	registerMethod("remove", make_method(this, &ObjectStoreAsync::remove));
+	registerProperty("name", make_property(this, &ObjectStoreAsync::getName));
+	}
+
+string ObjectStoreAsync::getName() const
+	{ return objectStore->getName(); }
+
+RequestAsyncPtr ObjectStoreAsync::get(const FB::variant& key)
+	{ return schedule(boost::bind(&ObjectStoreAsync::getValue, objectStore, Convert::toKey(host, key)), FB::variant()); }
+
+RequestAsyncPtr ObjectStoreAsync::put(const FB::variant& value, const FB::variant& inKey, const optional<bool> noOverwrite)
+	{
+	// Keys are generated (and validated) up front, since generation reads the value in the user agent
+	const FB::variant key = objectStore->resolveKey(value, inKey);
+
+	return schedule(boost::bind(&ObjectStoreAsync::putValue, objectStore, Convert::toKey(host, key), 
+		Convert::toData(host, value), noOverwrite.get_value_or(false)), key);
+	}
+
+RequestAsyncPtr ObjectStoreAsync::remove(const FB::variant& key)
+	{ return schedule(boost::bind(&ObjectStoreAsync::removeValue, objectStore, Convert::toKey(host, key)), FB::variant()); }
+
+RequestAsyncPtr ObjectStoreAsync::schedule(const RequestAsync::Operation& operation, const FB::variant& result)
+	{
+	RequestAsyncPtr request(new RequestAsync(host, shared_from_this(), operation, result));
+
+	// The worker holds no reference of its own; this one is handed on to the browser thread once the request executes
+	std::auto_ptr<RequestAsyncPtr> reference(new RequestAsyncPtr(request));
+	strand->schedule(boost::bind(&RequestAsync::execute, reference.get()));
+	reference.release();
+
+	return request;
+	}
+
+optional<Data> ObjectStoreAsync::getValue(const ObjectStoreSyncPtr& objectStore, const Key& key)
+	{
+	const Data data = objectStore->getImplementation().get(key, TransactionContext());
+
+	if(data.getType() == Data::Undefined)
+		throw ImplementationException("NOT_FOUND_ERR", ImplementationException::NOT_FOUND_ERR);
+	else
+		return data;
+	}
+
+optional<Data> ObjectStoreAsync::putValue(const ObjectStoreSyncPtr& objectStore, const Key& key, const Data& data, const bool noOverwrite)
+	{
+	objectStore->getImplementation().put(key, data, noOverwrite, TransactionContext());
+	return optional<Data>();
+	}
+
+optional<Data> ObjectStoreAsync::removeValue(const ObjectStoreSyncPtr& objectStore, const Key& key)
+	{
+	objectStore->getImplementation().remove(key, TransactionContext());
+	return optional<Data>();
+	}
+
+}
+}
+}
@@ -0,0 +1,71 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_API_ASYNC_OBJECTSTOREASYNC_H
+#define BRANDONHAYNES_INDEXEDDB_API_ASYNC_OBJECTSTOREASYNC_H
+
+#include <string>
+#include <boost/optional.hpp>
+#include <JSAPIAuto.h>
+#include <BrowserHost.h>
+#include "RequestAsync.h"
+#include "../../Support/WorkerPool.h"
+#include "../../Implementation/Key.h"
+#include "../../Implementation/Data.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB { 
+namespace API { 
+
+FB_FORWARD_PTR(DatabaseSync);
+FB_FORWARD_PTR(ObjectStoreSync);
+FB_FORWARD_PTR(ObjectStoreAsync);
+
+///<summary>
+/// This class represents an asynchronous object store in the Indexed Database API.  Each operation returns a
+/// request at once; keys and values are converted on the browser thread, while the operation itself runs on
+/// the worker pool of the database (so that the browser thread never waits on the disk).  Requests on an object
+/// store execute one at a time, in the order in which they were made, and each commits on its own (outside
+/// of any transaction current on the database).  Requests on different object stores of the database may
+/// execute in parallel (with each other, and with synchronous operations on the browser thread).
+///</summary>
+class ObjectStoreAsync : public FB::JSAPIAuto
+	{
+	public:
+		// Create an asynchronous object store over the given (open) object store, executing on the given pool of its database
+		ObjectStoreAsync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, const ObjectStoreSyncPtr& objectStore, Support::WorkerPool& workers);
+
+		// Request the value identified by the given key
+		RequestAsyncPtr get(const FB::variant& key);
+		// Request that the given value be put into the object store (generating its key if none is given)
+		RequestAsyncPtr put(const FB::variant& value, const FB::variant& key, const boost::optional<bool> noOverwrite);
+		// Request that the value identified by the given key be removed
+		RequestAsyncPtr remove(const FB::variant& key);
+
+		std::string getName() const;
+
+	private:
+		FB::BrowserHostPtr host;
+		// We keep our database (and so its worker pool) alive for as long as we may schedule requests
+		const DatabaseSyncPtr database;
+		// The object store on which requests operate, and the strand on which they are executed
+		const ObjectStoreSyncPtr objectStore;
+		const boost::shared_ptr<Support::WorkerPool::Strand> strand;
+
+		// Creates a request for the given operation (completing with the given result) and schedules it
+		RequestAsyncPtr schedule(const RequestAsync::Operation& operation, const FB::variant& result);
+
+		// Operations executed on the worker pool
+		static boost::optional<Implementation::Data> getValue(const ObjectStoreSyncPtr& objectStore, const Implementation::Key& key);
+		static boost::optional<Implementation::Data> putValue(const ObjectStoreSyncPtr& objectStore, const Implementation::Key& key, const Implementation::Data& data, const bool noOverwrite);
+		static boost::optional<Implementation::Data> removeValue(const ObjectStoreSyncPtr& objectStore, const Implementation::Key& key);
+	};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,116 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <memory>
+#include <exception>
+#include <variant_list.h>
+#include "RequestAsync.h"
+#include "../DatabaseException.h"
+#include "../../Support/Convert.h"
+
+using boost::optional;
+using boost::mutex;
+using boost::lock_guard;
+
+namespace BrandonHaynes {
+namespace IndexedDB { 
+
+using Implementation::Data;
+using Implementation::ImplementationException;
+
+namespace API { 
+
+RequestAsync::RequestAsync(const FB::BrowserHostPtr& host, const FB::JSAPIPtr& source, const Operation& operation, const FB::variant& result)
+	: host(host), source(source), operation(operation), readyState(LOADING), result(result)
+	{
+	registerProperty("readyState", make_property(this, &RequestAsync::getReadyState));
+	registerProperty("result", make_property(this, &RequestAsync::getResult));
+	registerProperty("errorCode", make_property(this, &RequestAsync::getErrorCode));
+	registerProperty("errorMessage", make_property(this, &RequestAsync::getErrorMessage));
+	registerProperty("source", make_property(this, &RequestAsync::getSource));
+	registerProperty("onsuccess", make_property(this, &RequestAsync::getOnSuccess, &RequestAsync::setOnSuccess));
+	registerProperty("onerror", make_property(this, &RequestAsync::getOnError, &RequestAsync::setOnError));
+	}
+
+void RequestAsync::execute(RequestAsyncPtr* request)
+	{
+	RequestAsync& self = **request;
+
+		{
+		lock_guard<mutex> guard(self.synchronization);
+
+		// Every outcome completes the request; anything we let escape would be discarded by the pool
+		try
+			{ self.data = self.operation(); }
+		catch(ImplementationException& e)
+			{ 
+			self.failure = DatabaseException(e).get_code(); 
+			self.errorMessage = e.message;
+			}
+		catch(std::exception& e)
+			{
+			self.failure = DatabaseException::UNKNOWN_ERR;
+			self.errorMessage = e.what();
+			}
+		catch(...)
+			{
+			self.failure = DatabaseException::UNKNOWN_ERR;
+			self.errorMessage = "UNKNOWN_ERR";
+			}
+		}
+
+	// The browser thread owns our reference to this request until it has completed.  Should the browser no longer
+	// run calls (as it shuts down), the reference is abandoned rather than released here.
+	self.host->ScheduleAsyncCall(&RequestAsync::completeOnBrowserThread, request);
+	}
+
+void RequestAsync::completeOnBrowserThread(void* request)
+	{ 
+	std::auto_ptr<RequestAsyncPtr> pointer(static_cast<RequestAsyncPtr*>(request));
+	(*pointer)->complete();
+	}
+
+void RequestAsync::complete()
+	{
+		{
+		lock_guard<mutex> guard(synchronization);
+
+		readyState = DONE;
+		errorCode = failure;
+		if(data.is_initialized())
+			result = Convert::toVariant(host, data.get());
+		}
+
+	const FB::JSObjectPtr callback = errorCode.is_initialized() ? onError : onSuccess;
+	if(callback)
+		callback->Invoke("", FB::variant_list_of(shared_from_this()));
+	}
+
+FB::variant RequestAsync::getErrorCode() const
+	{ return errorCode.is_initialized() ? FB::variant(errorCode.get()) : FB::variant(); }
+
+FB::variant RequestAsync::getErrorMessage() const
+	{ return errorCode.is_initialized() ? FB::variant(errorMessage) : FB::variant(); }
+
+void RequestAsync::setOnSuccess(const FB::variant& callback)
+	{ onSuccess = toCallback(callback); }
+
+void RequestAsync::setOnError(const FB::variant& callback)
+	{ onError = toCallback(callback); }
+
+FB::JSObjectPtr RequestAsync::toCallback(const FB::variant& callback)
+	{
+	if(callback.empty() || callback.is_of_type<FB::FBNull>())
+		return FB::JSObjectPtr();
+	else if(callback.can_be_type<FB::JSObjectPtr>())
+		return callback.convert_cast<FB::JSObjectPtr>();
+	else
+		throw FB::invalid_arguments();
+	}
+
+}
+}
+}
@@ -0,0 +1,88 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_API_ASYNC_REQUESTASYNC_H
+#define BRANDONHAYNES_INDEXEDDB_API_ASYNC_REQUESTASYNC_H
+
+#include <string>
+#include <boost/optional.hpp>
+#include <boost/function.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <JSAPIAuto.h>
+#include <BrowserHost.h>
+#include "../../Implementation/Data.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB { 
+namespace API { 
+
+FB_FORWARD_PTR(RequestAsync);
+
+///<summary>
+/// This class represents an asynchronous request in the Indexed Database API.  A request is returned as soon as
+/// its operation is scheduled; the operation executes on a worker thread, and the request completes (setting its
+/// result or error code, and then calling its onsuccess or onerror callback) back on the browser thread.
+///</summary>
+class RequestAsync : public FB::JSAPIAuto
+	{
+	public:
+		// The states through which a request passes
+		enum ReadyState { LOADING = 1, DONE = 2 };
+		// An operation executed on a worker thread; it returns the data with which the request completes (if any),
+		// and reports failure by throwing an ImplementationException
+		typedef boost::function<boost::optional<Implementation::Data> ()> Operation;
+
+		// Create a request for the given operation on the given source, which (unless the operation returns data)
+		// completes with the given result
+		RequestAsync(const FB::BrowserHostPtr& host, const FB::JSAPIPtr& source, const Operation& operation, const FB::variant& result);
+
+		// Executes the operation of the referenced request (on the calling worker thread), then schedules completion on
+		// the browser thread.  Takes ownership of the given reference, which passes to the browser thread along with the
+		// completion: a worker must never release the last reference to a request, since that may close its database
+		// (and so join the pool on which the worker runs).
+		static void execute(RequestAsyncPtr* request);
+
+	private:
+		FB::BrowserHostPtr host;
+		// Our source is held weakly, so that a worker never holds the last reference to it (or its database)
+		const boost::weak_ptr<FB::JSAPI> source;
+		// The operation holds its object store (and so the database), and is released with us on the browser thread
+		const Operation operation;
+		ReadyState readyState;
+		FB::variant result;
+		boost::optional<int> errorCode;
+		std::string errorMessage;
+		FB::JSObjectPtr onSuccess;
+		FB::JSObjectPtr onError;
+
+		// The outcome of the operation, recorded on the worker thread and published on the browser thread
+		boost::optional<Implementation::Data> data;
+		boost::optional<int> failure;
+		boost::mutex synchronization;
+
+		// Publishes the outcome of the operation and calls back into the user agent (on the browser thread)
+		void complete();
+		static void completeOnBrowserThread(void* request);
+
+		// Accessors that expose this request to the user agent
+		int getReadyState() const { return readyState; }
+		FB::variant getResult() const { return result; }
+		FB::variant getErrorCode() const;
+		FB::variant getErrorMessage() const;
+		FB::JSAPIPtr getSource() const { return source.lock(); }
+		FB::variant getOnSuccess() const { return onSuccess; }
+		void setOnSuccess(const FB::variant& callback);
+		FB::variant getOnError() const { return onError; }
+		void setOnError(const FB::variant& callback);
+		static FB::JSObjectPtr toCallback(const FB::variant& callback);
+	};
+
+}
+}
+}
+
+#endif
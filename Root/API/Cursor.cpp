@@ -26,6 +26,20 @@ void Cursor::initializeMethods()
 	registerProperty("NEXT_NO_DUPLICATE", make_property(this, &Cursor::getNextNoDuplicate));
 	registerProperty("PREV", make_property(this, &Cursor::getPrevious));
 	registerProperty("PREV_NO_DUPLICATE", make_property(this, &Cursor::getPreviousNoDuplicate));
+
+	registerProperty("SERIALIZABLE", make_property(this, &Cursor::getSerializable));
+	registerProperty("READ_COMMITTED", make_property(this, &Cursor::getReadCommitted));
+	registerProperty("READ_UNCOMMITTED", make_property(this, &Cursor::getReadUncommitted));
+	}
+
+Cursor::Isolation Cursor::toIsolation(const boost::optional<int>& isolation)
+	{
+	if(!isolation.is_initialized())
+		return SERIALIZABLE;
+	else if(isolation.get() == SERIALIZABLE || isolation.get() == READ_COMMITTED || isolation.get() == READ_UNCOMMITTED)
+		return static_cast<Cursor::Isolation>(isolation.get());
+	else
+		throw FB::invalid_arguments();
 	}
 
 }
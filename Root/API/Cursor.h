@@ -7,6 +7,7 @@ GNU Lesser General Public License
 #ifndef BRANDONHAYNES_INDEXEDDB_API_CURSOR_H
 #define BRANDONHAYNES_INDEXEDDB_API_CURSOR_H
 
+#include <boost/optional.hpp>
 #include <JSAPIAuto.h>
 
 namespace BrandonHaynes {
@@ -21,6 +22,8 @@ class Cursor : public FB::JSAPIAuto
 public:
 	// The direction of a cursor
 	enum Direction { NEXT = 0, NEXT_NO_DUPLICATE = 1, PREV = 2, PREV_NO_DUPLICATE = 3 };
+	// The isolation with which a cursor reads (these match those of the implementation)
+	enum Isolation { SERIALIZABLE = 0, READ_COMMITTED = 1, READ_UNCOMMITTED = 2 };
 
 	// Returns a stub instance of this interface so clients may access the direction enum
 	static const boost::shared_ptr<Cursor> getInstance()
@@ -29,6 +32,9 @@ public:
 	// Gets the direction associated with this cursor
 	Cursor::Direction getDirection() { return direction; }
 
+	// Validates an isolation given by a user agent; a cursor is serializable unless another isolation is given
+	static Cursor::Isolation toIsolation(const boost::optional<int>& isolation);
+
 protected:
 	// Creates a cursor with the given direction
 	Cursor(const Cursor::Direction direction);
@@ -40,6 +46,9 @@ protected:
 	int getNextNoDuplicate() const { return NEXT_NO_DUPLICATE; }
 	int getPrevious() const { return PREV; }
 	int getPreviousNoDuplicate() const { return PREV_NO_DUPLICATE; }
+	int getSerializable() const { return SERIALIZABLE; }
+	int getReadCommitted() const { return READ_COMMITTED; }
+	int getReadUncommitted() const { return READ_UNCOMMITTED; }
 
 private:
 	const Cursor::Direction direction;
@@ -24,15 +24,27 @@ IndexedDatabase::IndexedDatabase(FB::BrowserHostPtr host)
 DatabasePtr IndexedDatabase::open(const string& name, const string& description, const FB::CatchAll& args)
 	{
 	const FB::VariantList& values = args.value;
-	if(values.size() > 1)
+	if(values.size() > 2)
 		throw FB::invalid_arguments();
-	else if(values.size() == 1 && !values[0].is_of_type<bool>())
+	else if(values.size() >= 1 && !values[0].is_of_type<bool>())
 		throw FB::invalid_arguments();
 
-	bool modifyDatabase = values.size() == 1 ? values[0].cast<bool>() : true;
+	bool modifyDatabase = values.size() >= 1 ? values[0].cast<bool>() : true;
+	// Either the storage engine backing the database (e.g. "memory") or an object of engine settings
+	// (e.g. { engine: "berkeleydb", cacheSize: "16MB", durability: "writeNoSync", compression: true })
+	FB::VariantMap options;
 
 	try
-		{ return DatabaseSync::create(host, name, description, modifyDatabase); }
+		{
+		if(values.size() == 2 && values[1].is_of_type<string>())
+			options["engine"] = values[1];
+		else if(values.size() == 2)
+			options = values[1].convert_cast<FB::VariantMap>();
+
+		return DatabaseSync::create(host, name, description, modifyDatabase, options);
+		}
+	catch(FB::bad_variant_cast&)
+		{ throw FB::invalid_arguments(); }
 	catch(ImplementationException& e)
 		{ throw DatabaseException(e); }
 	}
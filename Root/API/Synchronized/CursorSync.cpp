@@ -19,7 +19,6 @@ namespace BrandonHaynes {
 namespace IndexedDB { 
 
 using Implementation::Key;
-using Implementation::AbstractDatabaseFactory;
 using Implementation::ImplementationException;
 
 namespace API { 
@@ -34,12 +33,12 @@ void CursorSync::removeLifeCycleObserver( const LifeCycleObserverPtr& observer )
     _observable->removeLifeCycleObserver(observer);
 }
 
-CursorSync::CursorSync(FB::BrowserHostPtr host, const ObjectStoreSyncPtr& objectStore, TransactionFactory& transactionFactory, const KeyRangePtr& range, const Cursor::Direction direction)
+CursorSync::CursorSync(FB::BrowserHostPtr host, const ObjectStoreSyncPtr& objectStore, TransactionFactory& transactionFactory, const KeyRangePtr& range, const Cursor::Direction direction, const Cursor::Isolation isolation)
 	: Cursor(direction), 
 	  transactionFactory(transactionFactory),
 	  readOnly(objectStore->getMode() != Implementation::ObjectStore::READ_WRITE),
 	  host(host), range(range),
-	  implementation(AbstractDatabaseFactory::getInstance().openCursor(
+	  implementation(transactionFactory.getFactory().openCursor(
 		objectStore->getImplementation(), 
 		range ? Convert::toKey(host, range->getLeft()) : Key::getUndefinedKey(),
 		range ? Convert::toKey(host, range->getRight()) : Key::getUndefinedKey(),
@@ -47,16 +46,17 @@ CursorSync::CursorSync(FB::BrowserHostPtr host, const ObjectStoreSyncPtr& object
 		range ? range->getFlags() & KeyRange::RIGHT_OPEN : false,
 		direction == Cursor::PREV || direction == Cursor::PREV_NO_DUPLICATE,
 		direction == Cursor::NEXT_NO_DUPLICATE || direction == Cursor::PREV_NO_DUPLICATE, 
+		static_cast<Implementation::Cursor::Isolation>(isolation),
 		transactionFactory.getTransactionContext()))
 	{
 	initializeMethods();
 	}
 
-CursorSync::CursorSync(FB::BrowserHostPtr host, const IndexSyncPtr& index, TransactionFactory& transactionFactory, const KeyRangePtr& range, const Cursor::Direction direction, const bool returnKeys)
+CursorSync::CursorSync(FB::BrowserHostPtr host, const IndexSyncPtr& index, TransactionFactory& transactionFactory, const KeyRangePtr& range, const Cursor::Direction direction, const bool returnKeys, const Cursor::Isolation isolation)
 	: Cursor(direction), readOnly(false),
 	  transactionFactory(transactionFactory),
 	  host(host), range(range),
-	  implementation(AbstractDatabaseFactory::getInstance().openCursor(
+	  implementation(transactionFactory.getFactory().openCursor(
 		*(index->implementation), 
 		range ? Convert::toKey(host, range->getLeft()) : Key::getUndefinedKey(),
 		range ? Convert::toKey(host, range->getRight()) : Key::getUndefinedKey(),
@@ -65,6 +65,7 @@ CursorSync::CursorSync(FB::BrowserHostPtr host, const IndexSyncPtr& index, Trans
 		direction == Cursor::PREV || direction == Cursor::PREV_NO_DUPLICATE,
 		direction == Cursor::NEXT_NO_DUPLICATE || direction == Cursor::PREV_NO_DUPLICATE,
 		returnKeys,
+		static_cast<Implementation::Cursor::Isolation>(isolation),
 		transactionFactory.getTransactionContext()))
 	{
 	initializeMethods();
@@ -31,9 +31,9 @@ class CursorSync : public Cursor
         boost::shared_ptr<Support::LifeCycleObservable<CursorSync> > _observable;
 	public:
 		// This constructor creates a cursor over the given object store
-		CursorSync(FB::BrowserHostPtr host, const ObjectStoreSyncPtr& objectStore, TransactionFactory& transactionFactory, const KeyRangePtr& range, const Cursor::Direction direction);
+		CursorSync(FB::BrowserHostPtr host, const ObjectStoreSyncPtr& objectStore, TransactionFactory& transactionFactory, const KeyRangePtr& range, const Cursor::Direction direction, const Cursor::Isolation isolation);
 		// This constructor creates a cursor over the given index
-		CursorSync(FB::BrowserHostPtr host, const IndexSyncPtr& index, TransactionFactory& transactionFactory, const KeyRangePtr& range, const Cursor::Direction direction, const bool returnKeys);
+		CursorSync(FB::BrowserHostPtr host, const IndexSyncPtr& index, TransactionFactory& transactionFactory, const KeyRangePtr& range, const Cursor::Direction direction, const bool returnKeys, const Cursor::Isolation isolation);
 		virtual ~CursorSync(void);
 
 		// Gets the key associated with the current cursor position
@@ -7,8 +7,10 @@ GNU Lesser General Public License
 #include <DOM/Document.h>
 #include "DatabaseSync.h"
 #include "TransactionSync.h"
+#include "../Asynchronous/ObjectStoreAsync.h"
 #include "../DatabaseException.h"
 #include "../../Implementation/Database.h"
+#include "../../Implementation/DatabaseConfiguration.h"
 #include "../../Implementation/Data.h"
 #include "../../Support/Convert.h"
 
@@ -24,9 +26,11 @@ namespace API {
 using Implementation::TransactionContext;
 using Implementation::Data;
 
-BrandonHaynes::IndexedDB::API::DatabaseSyncPtr DatabaseSync::create( FB::BrowserHostPtr host, const std::string& name, const std::string& description, const bool modifyDatabase )
+const size_t DatabaseSync::workerCount = 2;
+
+BrandonHaynes::IndexedDB::API::DatabaseSyncPtr DatabaseSync::create( FB::BrowserHostPtr host, const std::string& name, const std::string& description, const bool modifyDatabase, const FB::VariantMap& options )
     {
-    DatabaseSyncPtr ptr(new DatabaseSync(host, name, description, modifyDatabase));
+    DatabaseSyncPtr ptr(new DatabaseSync(host, name, description, modifyDatabase, options));
     ptr->init();
     return ptr;
     }
@@ -36,13 +40,12 @@ void DatabaseSync::init()
     transactionFactory.setDatabaseSync(FB::ptr_cast<DatabaseSync>(shared_from_this()));
     }
 
-DatabaseSync::DatabaseSync(FB::BrowserHostPtr host, const string& name, const string& description, const bool modifyDatabase)
+DatabaseSync::DatabaseSync(FB::BrowserHostPtr host, const string& name, const string& description, const bool modifyDatabase, const FB::VariantMap& options)
 	: Database(name, description),
 	  host(host), 
 	  modifyDatabase(modifyDatabase),
       openObjectStores(boost::make_shared<Support::Container<ObjectStoreSync> >()),
-	  implementation(Implementation::AbstractDatabaseFactory::getInstance()
-		.createDatabase(getOrigin(), name, description, modifyDatabase)),
+	  implementation(createImplementation(name, description, modifyDatabase, options)),
 	  metadata(implementation->getMetadata(), Metadata::Database, name),
 	  #pragma warning(push)
 	  #pragma warning(disable: 4355)
@@ -51,15 +54,24 @@ DatabaseSync::DatabaseSync(FB::BrowserHostPtr host, const string& name, const st
 	{
 	registerMethod("createObjectStore", make_method(this, &DatabaseSync::createObjectStore)); 
 	registerMethod("openObjectStore", make_method(this, static_cast<FB::JSAPIPtr (DatabaseSync::*)(const string&, const FB::CatchAll &)>(&DatabaseSync::openObjectStore))); 
+	registerMethod("openObjectStoreAsync", make_method(this, &DatabaseSync::openObjectStoreAsync)); 
 	registerMethod("removeObjectStore", FB::make_method(this, &DatabaseSync::removeObjectStore));
 	registerMethod("setVersion", FB::make_method(this, &DatabaseSync::setVersion));
-	registerMethod("transaction", FB::make_method(this, static_cast<TransactionSyncPtr (DatabaseSync::*)(const FB::variant&, const boost::optional<unsigned int>)>(&DatabaseSync::transaction))); 
+	registerMethod("transaction", FB::make_method(this, static_cast<TransactionSyncPtr (DatabaseSync::*)(const FB::variant&, const boost::optional<unsigned int>, const boost::optional<string>, const boost::optional<int>, const boost::optional<bool>, const boost::optional<bool>)>(&DatabaseSync::transaction))); 
+	registerProperty("lastCheckpoint", make_property(this, &DatabaseSync::getLastCheckpoint));
+	registerMethod("checkpoint", make_method(this, &DatabaseSync::checkpoint));
+	registerProperty("openFiles", make_property(this, &DatabaseSync::getOpenFiles));
 	}
 
 DatabaseSync::~DatabaseSync()
 	{
+	// Outstanding asynchronous requests finish before the object stores they use are closed
+	workers.reset();
+
 	if(currentTransaction)
 		currentTransaction->close();
+	for(std::list<TransactionSyncPtr>::const_iterator iterator = transactions.begin(); iterator != transactions.end(); iterator++)
+		(*iterator)->close();
 
 	openObjectStores->release();
 	}
@@ -95,10 +107,41 @@ optional<string> DatabaseSync::getVersion() const
 void DatabaseSync::setVersion(const string& version)
 	{ metadata.putMetadata("version", Data(version), transactionFactory.getTransactionContext()); }
 
-ObjectStoreSyncPtr DatabaseSync::createObjectStore(const string& name, const boost::optional<string>& keyPath, boost::optional<bool> autoIncrement)
+FB::variant DatabaseSync::getLastCheckpoint()
+	{
+	try
+		{
+		const optional<string> checkpoint = implementation->getLastCheckpoint();
+		return checkpoint.is_initialized() ? checkpoint.get() : FB::variant();
+		}
+	catch(Implementation::ImplementationException& e)
+		{ throw DatabaseException(e); }
+	}
+
+void DatabaseSync::checkpoint()
+	{
+	try
+		{ implementation->checkpoint(); }
+	catch(Implementation::ImplementationException& e)
+		{ throw DatabaseException(e); }
+	}
+
+FB::variant DatabaseSync::getOpenFiles()
+	{
+	try
+		{
+		const optional<size_t> count = implementation->getOpenFileCount();
+		return count.is_initialized() ? static_cast<int>(count.get()) : FB::variant();
+		}
+	catch(Implementation::ImplementationException& e)
+		{ throw DatabaseException(e); }
+	}
+
+ObjectStoreSyncPtr DatabaseSync::createObjectStore(const string& name, const boost::optional<string>& keyPath, boost::optional<bool> autoIncrement, const boost::optional<string>& accessMethod)
 	{ 
 	ensureCanCreateObjectStore(name);
     bool ai = autoIncrement ? *autoIncrement : false;
+	const Implementation::ObjectStore::AccessMethod method = toAccessMethod(accessMethod);
     try
         {
         if (keyPath) 
@@ -113,7 +156,8 @@ ObjectStoreSyncPtr DatabaseSync::createObjectStore(const string& name, const boo
                     metadata,
                     name,
                     *keyPath,
-                    ai));
+                    ai,
+                    method));
         	openObjectStores->add(objectStore);
             return objectStore;
             }
@@ -130,7 +174,8 @@ ObjectStoreSyncPtr DatabaseSync::createObjectStore(const string& name, const boo
                     *transaction,
                     metadata,
                     name,
-                    ai
+                    ai,
+                    method
                 ));
     		openObjectStores->add(objectStore);
 
@@ -143,6 +188,45 @@ ObjectStoreSyncPtr DatabaseSync::createObjectStore(const string& name, const boo
     		{ throw DatabaseException(e); }
 	}
 
+Implementation::ObjectStore::AccessMethod DatabaseSync::toAccessMethod(const boost::optional<string>& accessMethod)
+	{
+	// Stores are btrees unless a hash is requested (record-numbered access methods do not fit our typed keys)
+	if(!accessMethod.is_initialized() || accessMethod.get() == "btree")
+		return Implementation::ObjectStore::ORDERED;
+	else if(accessMethod.get() == "hash")
+		return Implementation::ObjectStore::HASHED;
+	else
+		throw FB::invalid_arguments();
+	}
+
+Implementation::ObjectStore::Mode DatabaseSync::toMode(const optional<int>& mode)
+	{
+	if(!mode.is_initialized())
+		return Implementation::ObjectStore::READ_WRITE;
+	else if(mode.get() == Implementation::ObjectStore::READ_WRITE 
+	   || mode.get() == Implementation::ObjectStore::READ_ONLY 
+	   || mode.get() == Implementation::ObjectStore::SNAPSHOT_READ)
+		return static_cast<Implementation::ObjectStore::Mode>(mode.get());
+	else
+		throw FB::invalid_arguments();
+	}
+
+optional<Implementation::DatabaseConfiguration::Durability> DatabaseSync::toDurability(const boost::optional<string>& durability)
+	{
+	if(!durability.is_initialized())
+		return optional<Implementation::DatabaseConfiguration::Durability>();
+	else if(durability.get() == "durable")
+		return Implementation::DatabaseConfiguration::DURABLE;
+	else if(durability.get() == "writeNoSync")
+		return Implementation::DatabaseConfiguration::WRITE_NO_SYNC;
+	else if(durability.get() == "noSync")
+		return Implementation::DatabaseConfiguration::NO_SYNC;
+	else if(durability.get() == "groupCommit")
+		return Implementation::DatabaseConfiguration::GROUP_COMMIT;
+	else
+		throw FB::invalid_arguments();
+	}
+
 void DatabaseSync::ensureCanCreateObjectStore(const string& name)
 	{
 	StringVector objectStoreNames = this->getObjectStoreNames();
@@ -154,6 +238,22 @@ void DatabaseSync::ensureCanCreateObjectStore(const string& name)
 	}
 
 boost::shared_ptr<ObjectStoreSync> DatabaseSync::openObjectStore(const string& name, Implementation::ObjectStore::Mode mode)
+	{  
+	boost::shared_ptr<ObjectStoreSync> objectStore(openObjectStore(name, mode, transactionFactory, TransactionPtr()));
+	openObjectStores->add(objectStore);
+	return objectStore;
+	}
+
+ObjectStoreAsyncPtr DatabaseSync::openObjectStoreAsync(const string& name, const optional<int> mode)
+	{
+	ObjectStoreSyncPtr objectStore = openObjectStore(name, toMode(mode));
+
+	if(workers.get() == NULL)
+		workers.reset(new Support::WorkerPool(workerCount));
+	return ObjectStoreAsyncPtr(new ObjectStoreAsync(host, FB::ptr_cast<DatabaseSync>(shared_from_this()), objectStore, *workers));
+	}
+
+boost::shared_ptr<ObjectStoreSync> DatabaseSync::openObjectStore(const string& name, Implementation::ObjectStore::Mode mode, TransactionFactory& transactionFactory, const TransactionPtr& transaction)
 	{  
 	if(mode != Implementation::ObjectStore::READ_ONLY 
 	   && mode != Implementation::ObjectStore::READ_WRITE 
@@ -162,7 +262,7 @@ boost::shared_ptr<ObjectStoreSync> DatabaseSync::openObjectStore(const string& n
 
 	try
 		{
-		boost::shared_ptr<ObjectStoreSync> objectStore(
+		return boost::shared_ptr<ObjectStoreSync>(
             new ObjectStoreSync(
                 host,
                 FB::ptr_cast<DatabaseSync>(shared_from_this()),
@@ -170,9 +270,8 @@ boost::shared_ptr<ObjectStoreSync> DatabaseSync::openObjectStore(const string& n
                 transactionFactory.getTransactionContext(),
                 metadata,
                 name,
-                mode));
-		openObjectStores->add(objectStore);
-		return objectStore;
+                mode,
+                transaction));
 		}
 	catch(Implementation::ImplementationException& e)
 		{ throw DatabaseException(e); }
@@ -213,63 +312,68 @@ StringVector DatabaseSync::getIndexNames()
 	return indexes;
 	}
 
-TransactionSyncPtr DatabaseSync::transaction(const string& objectStoreName, const optional<unsigned int>& timeout)
-	{ return transaction(StringVector(1, objectStoreName), timeout); }
+TransactionSyncPtr DatabaseSync::transaction(const string& objectStoreName, const Implementation::ObjectStore::Mode mode, const optional<unsigned int>& timeout, const optional<Implementation::DatabaseConfiguration::Durability>& durability, const bool buffered, const bool optimistic)
+	{ return transaction(StringVector(1, objectStoreName), mode, timeout, durability, buffered, optimistic); }
 
-TransactionSyncPtr DatabaseSync::transaction(const FB::variant& objStoreName, const boost::optional<unsigned int> timeout)
+TransactionSyncPtr DatabaseSync::transaction(const FB::variant& objStoreName, const boost::optional<unsigned int> timeout, const boost::optional<string> durabilityName, const boost::optional<int> modeValue, const boost::optional<bool> bufferedValue, const boost::optional<bool> optimisticValue)
 	{
+	const optional<Implementation::DatabaseConfiguration::Durability> durability = toDurability(durabilityName);
+	const Implementation::ObjectStore::Mode mode = toMode(modeValue);
+	const bool optimistic = optimisticValue ? *optimisticValue : false;
+	const bool buffered = optimistic || (bufferedValue ? *bufferedValue : false);
+
 	// We allow a single string, an array, or nothing as possible object store names
 	// (Believe spec disallows a single string, but that's silly)
 	if(objStoreName.empty())
-		transaction(StringVector(), timeout);
+		return transaction(StringVector(), mode, timeout, durability, buffered, optimistic);
 	else if(objStoreName.can_be_type<FB::JSObjectPtr>())
 		try
-			{ transaction(objStoreName.convert_cast<StringVector>(), timeout); }
+			{ return transaction(objStoreName.convert_cast<StringVector>(), mode, timeout, durability, buffered, optimistic); }
 		catch(FB::bad_variant_cast)
 			{ throw FB::invalid_arguments(); }
 	else if(objStoreName.can_be_type<string>())
-		transaction(objStoreName.convert_cast<string>(), timeout);
+		return transaction(objStoreName.convert_cast<string>(), mode, timeout, durability, buffered, optimistic);
 	else
 		throw FB::invalid_arguments();
-	
-	if(!currentTransaction)
-		throw DatabaseException("UNKNOWN_ERR", DatabaseException::UNKNOWN_ERR );
-	else
-		return currentTransaction;
 	}
 
-boost::shared_ptr<TransactionSync> DatabaseSync::transaction(const StringVector& inStoreNames, const optional<unsigned int>& timeout)
+boost::shared_ptr<TransactionSync> DatabaseSync::transaction(const StringVector& inStoreNames, const Implementation::ObjectStore::Mode mode, const optional<unsigned int>& timeout, const optional<Implementation::DatabaseConfiguration::Durability>& durability, const bool buffered, const bool optimistic)
 	{
-	if(getCurrentTransaction())
-		throw DatabaseException("NOT_ALLOWED_ERR", DatabaseException::NOT_ALLOWED_ERR);
-	else if(inStoreNames.size())
+	TransactionSyncPtr transaction;
+
+	if(inStoreNames.size())
 		{
 		StringVector objectStoreNames = getObjectStoreNames();
         StringVector storeNames(inStoreNames);
 		sort(storeNames.begin(), storeNames.end());
 		sort(objectStoreNames.begin(), objectStoreNames.end());
 
-		// Ensure that the passed-in object store names actually exist in our database
-		if(!std::includes(storeNames.begin(), storeNames.end(), objectStoreNames.begin(), objectStoreNames.end()))
+		// Ensure that the passed-in object store names actually exist in our database (a transaction need not name them all)
+		if(!std::includes(objectStoreNames.begin(), objectStoreNames.end(), storeNames.begin(), storeNames.end()))
 			throw DatabaseException("NOT_FOUND_ERR", DatabaseException::NOT_FOUND_ERR);
 
 		ObjectStoreSyncList objectStores;
 		for_each(storeNames.begin(), storeNames.end(), 
-			MapObjectStoreNameToObjectStoreFunctor(FB::ptr_cast<DatabaseSync>(shared_from_this()), objectStores));
+			MapObjectStoreNameToObjectStoreFunctor(FB::ptr_cast<DatabaseSync>(shared_from_this()), mode, objectStores));
 		
-		currentTransaction = boost::shared_ptr<TransactionSync>(
-            new TransactionSync(FB::ptr_cast<DatabaseSync>(shared_from_this()), transactionFactory, objectStores, timeout)
+		// Our scope is scheduled (and we may wait) as the transaction begins; see Implementation::BerkeleyDB::BerkeleyScopeLocks
+		transaction = boost::shared_ptr<TransactionSync>(
+            new TransactionSync(FB::ptr_cast<DatabaseSync>(shared_from_this()), transactionFactory, objectStores, mode, timeout, durability, buffered, optimistic)
             );
 		}
 	else
-		currentTransaction = boost::shared_ptr<TransactionSync>(
-            new TransactionSync(FB::ptr_cast<DatabaseSync>(shared_from_this()), transactionFactory, ObjectStoreSyncList(), timeout)
+		transaction = boost::shared_ptr<TransactionSync>(
+            new TransactionSync(FB::ptr_cast<DatabaseSync>(shared_from_this()), transactionFactory, ObjectStoreSyncList(), mode, timeout, durability, buffered, optimistic)
             );
 
-	if(!getCurrentTransaction())
+	if(!transaction)
 		throw DatabaseException("UNKNOWN_ERR", DatabaseException::UNKNOWN_ERR );
+	else if(!currentTransaction)
+		currentTransaction = transaction;
 	else
-		return FB::ptr_cast<TransactionSync>(getCurrentTransaction());
+		transactions.push_back(transaction);
+
+	return transaction;
 	}
 
 TransactionPtr DatabaseSync::getCurrentTransaction() const
@@ -279,14 +383,36 @@ TransactionPtr DatabaseSync::getCurrentTransaction() const
 
 void DatabaseSync::onTransactionCommitted(const TransactionPtr& transaction)
 	{ 
-	openObjectStores->raiseTransactionCommitted(transaction);
-	this->currentTransaction.reset(); 
+	// Only the current transaction spans the object stores opened through this database
+	if(transaction == currentTransaction)
+		{
+		openObjectStores->raiseTransactionCommitted(transaction);
+		this->currentTransaction.reset(); 
+		}
+	else
+		transactions.remove(FB::ptr_cast<TransactionSync>(transaction));
 	}
 
 void DatabaseSync::onTransactionAborted(const TransactionPtr& transaction)
 	{ 
-	openObjectStores->raiseTransactionAborted(transaction);
-	this->currentTransaction.reset(); 
+	if(transaction == currentTransaction)
+		{
+		openObjectStores->raiseTransactionAborted(transaction);
+		this->currentTransaction.reset(); 
+		}
+	else
+		transactions.remove(FB::ptr_cast<TransactionSync>(transaction));
+	}
+
+auto_ptr<Implementation::Database> DatabaseSync::createImplementation(const string& name, const string& description, const bool modifyDatabase, const FB::VariantMap& options)
+	{
+	// Options given when the database is opened override those in the configuration file for the origin
+	Implementation::DatabaseConfiguration configuration = Implementation::DatabaseConfiguration::load(getOrigin(), name);
+	for(FB::VariantMap::const_iterator option = options.begin(); option != options.end(); option++)
+		configuration.set(option->first, option->second.convert_cast<string>());
+
+	return Implementation::AbstractDatabaseFactory::getInstance(configuration.getEngine())
+		.createDatabase(getOrigin(), name, description, modifyDatabase, configuration);
 	}
 
 std::string DatabaseSync::getOrigin()
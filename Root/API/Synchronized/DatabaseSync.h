@@ -7,12 +7,15 @@ GNU Lesser General Public License
 #ifndef BRANDONHAYNES_INDEXEDDB_API_SYNC_DATABASESYNC_H
 #define BRANDONHAYNES_INDEXEDDB_API_SYNC_DATABASESYNC_H
 
+#include <list>
 #include <boost/optional.hpp>
 #include <APITypes.h>
 #include "../Database.h"
 #include "../../Support/Metadata.h"
 #include "../../Support/Container.h"
 #include "../../Support/RootTransactionFactory.h"
+#include "../../Support/WorkerPool.h"
+#include "../../Implementation/DatabaseConfiguration.h"
 #include "ObjectStoreSync.h"
 
 namespace BrandonHaynes {
@@ -26,18 +29,20 @@ namespace API {
 FB_FORWARD_PTR(DatabaseSync);
 FB_FORWARD_PTR(TransactionSync);
 FB_FORWARD_PTR(ObjectStoreSync);
+FB_FORWARD_PTR(ObjectStoreAsync);
 
 using std::string;
 
 class DatabaseSync : public Database
 	{
     protected:
-		DatabaseSync(FB::BrowserHostPtr host, const std::string& name, const std::string& description, const bool modifyDatabase);
+		DatabaseSync(FB::BrowserHostPtr host, const std::string& name, const std::string& description, const bool modifyDatabase, const FB::VariantMap& options);
         void init();
 
 	public:
-		static DatabaseSyncPtr create(FB::BrowserHostPtr host, const std::string& name, const std::string& description, const bool modifyDatabase);
-		// Creates or opens a synchronized database with the given attributes
+		static DatabaseSyncPtr create(FB::BrowserHostPtr host, const std::string& name, const std::string& description, const bool modifyDatabase, const FB::VariantMap& options);
+		// Creates or opens a synchronized database with the given attributes; options (e.g. { engine: "memory" }) override
+		// the configuration file for the origin (see Implementation::DatabaseConfiguration)
 		~DatabaseSync();
 
 		// Gets the origin of this database
@@ -50,6 +55,10 @@ class DatabaseSync : public Database
 
 		// Creates or opens an object store within this database
 		boost::shared_ptr<ObjectStoreSync> openObjectStore(const std::string& name, Implementation::ObjectStore::Mode mode);
+		// Opens an object store whose operations are executed asynchronously, on this database's worker pool
+		ObjectStoreAsyncPtr openObjectStoreAsync(const std::string& name, const boost::optional<int> mode);
+		// Opens an object store bound to the given transaction (which is also its transaction factory)
+		boost::shared_ptr<ObjectStoreSync> openObjectStore(const std::string& name, Implementation::ObjectStore::Mode mode, TransactionFactory& transactionFactory, const TransactionPtr& transaction);
 
 		// Removes an object store with the given name
 		long removeObjectStore(const std::string& storeName);
@@ -60,9 +69,22 @@ class DatabaseSync : public Database
 		// Manipulate this database's version
 		virtual boost::optional<std::string> getVersion() const;
 		virtual void setVersion(const std::string& version);
+
+		// Gets the position in the log of the most recent checkpoint (e.g. "3/1024"; undefined if there is none)
+		FB::variant getLastCheckpoint();
+		// Takes a checkpoint now, blocking the calling thread until it is complete (does nothing if the engine keeps no log)
+		void checkpoint();
+		// Gets the number of database files held open by the engine (undefined if it does not track them)
+		FB::variant getOpenFiles();
 	    
-		// Initiate a transaction on this database (the API supports exactly one such transaction at a time)
-		TransactionSyncPtr transaction(const StringVector& inStoreNames, const boost::optional<unsigned int>& timeout);
+		// Initiate a transaction on this database, committed with the given durability (or that configured for the
+		// database); its object stores are opened (and its scope locked) in the given mode.  A transaction whose scope
+		// conflicts with that of another waits (first come, first served) until it may begin, or until its timeout.
+		// The first transaction begun while no other is current becomes the current transaction, within which
+		// operations on this database and its object stores implicitly run; the rest are used explicitly.  A buffered
+		// transaction defers its writes until it commits, and an optimistic one (which is also buffered) its locks
+		// as well (see TransactionSync).
+		TransactionSyncPtr transaction(const StringVector& inStoreNames, const Implementation::ObjectStore::Mode mode, const boost::optional<unsigned int>& timeout, const boost::optional<Implementation::DatabaseConfiguration::Durability>& durability, const bool buffered, const bool optimistic);
 
 	protected:
 		// This is undefined in the spec, but required
@@ -73,13 +95,14 @@ class DatabaseSync : public Database
         ObjectStoreSyncPtr createObjectStore(
             const string& name,
             const boost::optional<string>& keyPath,
-            boost::optional<bool> autoIncrement);
+            boost::optional<bool> autoIncrement,
+            const boost::optional<string>& accessMethod);
 		FB::JSAPIPtr openObjectStore(const std::string& name, const FB::CatchAll& args);
-		TransactionSyncPtr transaction(const std::string& objectStoreName, const boost::optional<unsigned int>& timeout);
+		TransactionSyncPtr transaction(const std::string& objectStoreName, const Implementation::ObjectStore::Mode mode, const boost::optional<unsigned int>& timeout, const boost::optional<Implementation::DatabaseConfiguration::Durability>& durability, const bool buffered, const bool optimistic);
 
-        TransactionSyncPtr transaction(const FB::variant& objStoreName, const boost::optional<unsigned int> timeout);
+        TransactionSyncPtr transaction(const FB::variant& objStoreName, const boost::optional<unsigned int> timeout, const boost::optional<std::string> durability, const boost::optional<int> mode, const boost::optional<bool> buffered, const boost::optional<bool> optimistic);
 
-		// We need to be notified if a transaction is aborted or committed, so we can clear our current transaction
+		// We need to be notified if a transaction is aborted or committed, so we can clear it
 		virtual void onTransactionAborted(const TransactionPtr& transaction);
 		virtual void onTransactionCommitted(const TransactionPtr& transaction);
 
@@ -90,31 +113,47 @@ class DatabaseSync : public Database
 	private:
 		// Maintain a reference to our underlying implementation
 		const std::auto_ptr<Implementation::Database> implementation;
-		// Maintain a shared pointer to our current transaction
+		// Maintain a shared pointer to our current transaction, and to those others that remain outstanding
 		boost::shared_ptr<TransactionSync> currentTransaction;
+		std::list<boost::shared_ptr<TransactionSync> > transactions;
 		// Maintain a reference to a transaction factory, to get current context and initiate new transactions
 		RootTransactionFactory transactionFactory;
 		// Maintain a reference to our underlying metadata store
 		Metadata metadata;
+		// The workers on which asynchronous requests are executed (created when first needed)
+		std::auto_ptr<Support::WorkerPool> workers;
+		// The number of workers in the pool of each database
+		static const size_t workerCount;
 
+		// Helper method to select and configure an engine, and create the underlying implementation over it
+		std::auto_ptr<Implementation::Database> createImplementation(const std::string& name, const std::string& description, const bool modifyDatabase, const FB::VariantMap& options);
 		// Helper method to ensure that we're actually allowed to create the named object store
 		void ensureCanCreateObjectStore(const std::string& name);
+		// Helper method to convert a requested access method (e.g. "btree" or "hash") into its implementation form
+		static Implementation::ObjectStore::AccessMethod toAccessMethod(const boost::optional<std::string>& accessMethod);
+		// Helper method to convert a requested mode (e.g. 1 for READ_ONLY) into its implementation form
+		static Implementation::ObjectStore::Mode toMode(const boost::optional<int>& mode);
+		// Helper method to convert a requested durability (e.g. "noSync" or "groupCommit") into its implementation form
+		static boost::optional<Implementation::DatabaseConfiguration::Durability> toDurability(const boost::optional<std::string>& durability);
 
 		// Functor to map names to ObjectStoreSync instances; used to initiate a static transaction
 		struct MapObjectStoreNameToObjectStoreFunctor : public std::unary_function<void, const std::string&>
 			{
-			MapObjectStoreNameToObjectStoreFunctor(const DatabaseSyncPtr& database, ObjectStoreSyncList& objectStores)
-				: database(database), objectStores(objectStores)
+			MapObjectStoreNameToObjectStoreFunctor(const DatabaseSyncPtr& database, const Implementation::ObjectStore::Mode mode, ObjectStoreSyncList& objectStores)
+				: database(database), mode(mode), objectStores(objectStores)
 				{ if(!objectStores.is_initialized()) objectStores = std::list<boost::shared_ptr<ObjectStoreSync>>(); }
 			void operator()(const std::string& objectStoreName)
 				//TODO we really want to be using an internal map of object stores, not opening anew; will have ownership issues here though
-				{ objectStores.get().push_back(database->openObjectStore(objectStoreName, Implementation::ObjectStore::READ_WRITE)); }
+				{ objectStores.get().push_back(database->openObjectStore(objectStoreName, mode)); }
 
 			const DatabaseSyncPtr& database;
+			const Implementation::ObjectStore::Mode mode;
 			ObjectStoreSyncList& objectStores;
 			};
 
 		friend Implementation::TransactionContext RootTransactionFactory::getTransactionContext() const;
+		friend Support::WriteSet* RootTransactionFactory::getWriteSet() const;
+		friend Support::ReadSet* RootTransactionFactory::getReadSet() const;
         friend class Support::Container<ObjectStoreSync>;
 	};
 
@@ -52,9 +52,9 @@ IndexSync::IndexSync(FB::BrowserHostPtr host, const ObjectStoreSyncPtr& objectSt
 		? new Support::KeyPathKeyGenerator(host, keyPath.get())
 		: NULL);
 	implementation = keyPath.is_initialized()
-		? Implementation::AbstractDatabaseFactory::getInstance().openIndex(
+		? transactionFactory.getFactory().openIndex(
 			objectStore->getImplementation(), name, keyGenerator, unique, transactionFactory.getTransactionContext())
-		: Implementation::AbstractDatabaseFactory::getInstance().openIndex(
+		: transactionFactory.getFactory().openIndex(
 			objectStore->getImplementation(), name, unique, transactionFactory.getTransactionContext());
 	initializeMethods();
 	}
@@ -69,9 +69,9 @@ IndexSync::IndexSync(FB::BrowserHostPtr host, const ObjectStoreSyncPtr& objectSt
 		? new Support::KeyPathKeyGenerator(host, keyPath.get())
 		: NULL),
 	  implementation(keyPath.is_initialized()
-		? Implementation::AbstractDatabaseFactory::getInstance().createIndex(
+		? transactionFactory.getFactory().createIndex(
 			objectStore->getImplementation(), name, keyGenerator, unique, transactionFactory.getTransactionContext())
-		: Implementation::AbstractDatabaseFactory::getInstance().createIndex(
+		: transactionFactory.getFactory().createIndex(
 			objectStore->getImplementation(), name, unique, transactionFactory.getTransactionContext()))
 	{ 
 	createMetadata(keyPath, unique);
@@ -91,7 +91,7 @@ void IndexSync::initializeMethods()
 	registerMethod("getObject", make_method(this, &IndexSync::getObject));
 	registerMethod("put", make_method(this, &IndexSync::put));
 	registerMethod("remove", make_method(this, &IndexSync::remove));
-	registerMethod("openCursor", make_method(this, static_cast<CursorSyncPtr (IndexSync::*)(const boost::optional<FB::VariantMap>&, const boost::optional<int>&)>(&IndexSync::openCursor))); 
+	registerMethod("openCursor", make_method(this, static_cast<CursorSyncPtr (IndexSync::*)(const boost::optional<FB::VariantMap>&, const boost::optional<int>&, const boost::optional<int>&)>(&IndexSync::openCursor))); 
 	registerMethod("openObjectCursor", make_method(this, &IndexSync::openObjectCursor)); 
 	}
 
@@ -99,6 +99,7 @@ FB::variant IndexSync::get(FB::variant key)
 	{ 
 	try
 		{ 
+		transactionFactory.applyWrites();
 		Key& primaryKey = implementation->getPrimaryKey(Convert::toKey(host, key), transactionFactory.getTransactionContext()); 
 
 		if(primaryKey.getType() == Data::Undefined)
@@ -114,6 +115,7 @@ FB::variant IndexSync::getObject(FB::variant key)
 	{
 	try
 		{
+		transactionFactory.applyWrites();
 		Data& data = implementation->get(Convert::toKey(host, key), transactionFactory.getTransactionContext());
 
 		if(data.getType() == Data::Undefined)
@@ -142,7 +144,10 @@ FB::variant IndexSync::put(FB::variant value, const FB::CatchAll& args)
 	bool noOverwrite = values.size() == 2 ? values[1].cast<bool>() : false;
 
 	try
-		{ implementation->put(Convert::toKey(host, key), Convert::toData(host, value), noOverwrite, transactionFactory.getTransactionContext()); }
+		{ 
+		transactionFactory.applyWrites();
+		implementation->put(Convert::toKey(host, key), Convert::toData(host, value), noOverwrite, transactionFactory.getTransactionContext()); 
+		}
 	catch(ImplementationException& e)
 		{ throw DatabaseException(e); }
 
@@ -152,7 +157,10 @@ FB::variant IndexSync::put(FB::variant value, const FB::CatchAll& args)
 void IndexSync::remove(FB::variant key)
 	{
 	try
-		{ implementation->remove(Convert::toKey(host, key), transactionFactory.getTransactionContext()); }
+		{ 
+		transactionFactory.applyWrites();
+		implementation->remove(Convert::toKey(host, key), transactionFactory.getTransactionContext()); 
+		}
 	catch(ImplementationException& e)
 		{ throw DatabaseException(e); }
 	}
@@ -164,7 +172,7 @@ void IndexSync::close()
 	this->implementation->close(); 
 	}
 
-CursorSyncPtr IndexSync::openCursor(const boost::optional<FB::VariantMap>& info, const boost::optional<int>& dir)
+CursorSyncPtr IndexSync::openCursor(const boost::optional<FB::VariantMap>& info, const boost::optional<int>& dir, const boost::optional<int>& isolation)
 	{
     KeyRangePtr range;
     if (info) {
@@ -180,10 +188,10 @@ CursorSyncPtr IndexSync::openCursor(const boost::optional<FB::VariantMap>& info,
 
     const Cursor::Direction direction = dir ? static_cast<Cursor::Direction>(*dir) : Cursor::NEXT;
 
-	return openCursor(range, direction, true);
+	return openCursor(range, direction, true, Cursor::toIsolation(isolation));
 	}
 
-CursorSyncPtr IndexSync::openObjectCursor(const boost::optional<FB::VariantMap>& info, const boost::optional<int>& dir)
+CursorSyncPtr IndexSync::openObjectCursor(const boost::optional<FB::VariantMap>& info, const boost::optional<int>& dir, const boost::optional<int>& isolation)
 	{
     KeyRangePtr range;
     if (info) {
@@ -199,15 +207,18 @@ CursorSyncPtr IndexSync::openObjectCursor(const boost::optional<FB::VariantMap>&
 
     const Cursor::Direction direction = dir ? static_cast<Cursor::Direction>(*dir) : Cursor::NEXT;
 
-	return openCursor(range, direction, false);
+	return openCursor(range, direction, false, Cursor::toIsolation(isolation));
 	}
 
-boost::shared_ptr<CursorSync> IndexSync::openCursor(const KeyRangePtr& range, const Cursor::Direction direction, const bool dataArePrimaryKeys)
+boost::shared_ptr<CursorSync> IndexSync::openCursor(const KeyRangePtr& range, const Cursor::Direction direction, const bool dataArePrimaryKeys, const Cursor::Isolation isolation)
 	{ 
 	try
 		{ 
+		// Indexes are maintained by the object store as it is written, so buffered writes are applied first
+		transactionFactory.applyWrites();
+
 		CursorSyncPtr cursor(
-            new CursorSync(host, FB::ptr_cast<IndexSync>(shared_from_this()), transactionFactory, range, direction, dataArePrimaryKeys)
+            new CursorSync(host, FB::ptr_cast<IndexSync>(shared_from_this()), transactionFactory, range, direction, dataArePrimaryKeys, isolation)
             );
 		openCursors->add(cursor);
 		return cursor;
@@ -48,8 +48,8 @@ public:
 	// Close this index
 	void close();
 
-	// Open a cursor over this index
-	CursorSyncPtr openCursor(const KeyRangePtr& range, const Cursor::Direction direction, const bool dataArePrimaryKeys);
+	// Open a cursor over this index, reading with the given isolation
+	CursorSyncPtr openCursor(const KeyRangePtr& range, const Cursor::Direction direction, const bool dataArePrimaryKeys, const Cursor::Isolation isolation);
 
     // Forwarding methods for the embedded Observable
 	void addLifeCycleObserver(const LifeCycleObserverPtr& observer);
@@ -73,8 +73,8 @@ private:
 	TransactionFactory transactionFactory;
 
 	// Methods to interact between the user agent and this class; it interprets the args and calls the strongly typed overloads
-    CursorSyncPtr openCursor(const boost::optional<FB::VariantMap>& info, const boost::optional<int>& dir);
-    CursorSyncPtr openObjectCursor(const boost::optional<FB::VariantMap>& info, const boost::optional<int>& dir);
+    CursorSyncPtr openCursor(const boost::optional<FB::VariantMap>& info, const boost::optional<int>& dir, const boost::optional<int>& isolation);
+    CursorSyncPtr openObjectCursor(const boost::optional<FB::VariantMap>& info, const boost::optional<int>& dir, const boost::optional<int>& isolation);
 	void initializeMethods();
 
 	// When an index is created or opened, we need to initialize our metadata; these methods do so
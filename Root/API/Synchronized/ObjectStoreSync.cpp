@@ -27,7 +27,6 @@ namespace IndexedDB {
 using Implementation::Data;
 using Implementation::ImplementationException;
 using Implementation::TransactionContext;
-using Implementation::AbstractDatabaseFactory;
 
 namespace API { 
 
@@ -41,43 +40,44 @@ void ObjectStoreSync::removeLifeCycleObserver( const LifeCycleObserverPtr& obser
     _observable->removeLifeCycleObserver(observer);
 }
 
-ObjectStoreSync::ObjectStoreSync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, TransactionContext& transactionContext, Metadata& metadata, const string& name, const string& keyPath, const bool autoIncrement)
+ObjectStoreSync::ObjectStoreSync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, TransactionContext& transactionContext, Metadata& metadata, const string& name, const string& keyPath, const bool autoIncrement, const Implementation::ObjectStore::AccessMethod accessMethod)
 	:	ObjectStore(name, Implementation::ObjectStore::READ_WRITE),
         openIndexes(boost::make_shared<Support::Container<IndexSync> >()),
         openCursors(boost::make_shared<Support::Container<CursorSync> >()),
 		host(host), 
 	    transactionFactory(transactionFactory),
 		metadata(metadata, Metadata::ObjectStore, name),
-		implementation(AbstractDatabaseFactory::getInstance().createObjectStore(
-			transactionFactory.getDatabaseContext(), name, autoIncrement, transactionContext))
+		implementation(transactionFactory.getFactory().createObjectStore(
+			transactionFactory.getDatabaseContext(), name, autoIncrement, accessMethod, transactionContext))
 	{ 
 	initializeMethods(); 
 	createMetadata(keyPath, autoIncrement, transactionContext);
 	}
 
-ObjectStoreSync::ObjectStoreSync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, TransactionContext& transactionContext, Metadata& metadata, const string& name, const bool autoIncrement)
+ObjectStoreSync::ObjectStoreSync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, TransactionContext& transactionContext, Metadata& metadata, const string& name, const bool autoIncrement, const Implementation::ObjectStore::AccessMethod accessMethod)
 	:	ObjectStore(name, Implementation::ObjectStore::READ_WRITE),
         openIndexes(boost::make_shared<Support::Container<IndexSync> >()),
         openCursors(boost::make_shared<Support::Container<CursorSync> >()),
 		host(host), 
 	    transactionFactory(transactionFactory),
 		metadata(metadata, Metadata::ObjectStore, name),
-		implementation(AbstractDatabaseFactory::getInstance().createObjectStore(
-			transactionFactory.getDatabaseContext(), name, autoIncrement, transactionContext))
+		implementation(transactionFactory.getFactory().createObjectStore(
+			transactionFactory.getDatabaseContext(), name, autoIncrement, accessMethod, transactionContext))
 	{ 
 	//TODO docs say we open all indexes whenever we open the object store (http://www.oracle.com/technology/documentation/berkeley-db/db/programmer_reference/am_second.html)
 	initializeMethods(); 
 	createMetadata(boost::optional<string>(), autoIncrement, transactionContext);
 	}
 
-ObjectStoreSync::ObjectStoreSync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, TransactionContext& transactionContext, Metadata& metadata, const string& name, const Implementation::ObjectStore::Mode mode)
+ObjectStoreSync::ObjectStoreSync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, TransactionContext& transactionContext, Metadata& metadata, const string& name, const Implementation::ObjectStore::Mode mode, const TransactionPtr& transaction)
 	:	ObjectStore(name, mode),
         openIndexes(boost::make_shared<Support::Container<IndexSync> >()),
         openCursors(boost::make_shared<Support::Container<CursorSync> >()),
 		transactionFactory(transactionFactory),
+		transaction(transaction),
 		host(host), 
 		metadata(metadata, Metadata::ObjectStore, name),
-		implementation(AbstractDatabaseFactory::getInstance().openObjectStore(
+		implementation(transactionFactory.getFactory().openObjectStore(
 			transactionFactory.getDatabaseContext(), name, mode, transactionContext))
 	{ 
 	initializeMethods(); 
@@ -97,6 +97,9 @@ void ObjectStoreSync::initializeMethods()
 	registerMethod("get", make_method(this, &ObjectStoreSync::get));
 	registerMethod("put", make_method(this, &ObjectStoreSync::put));
     registerMethod("remove", make_method(this, &ObjectStoreSync::remove));
+	registerMethod("enableCompression", make_method(this, &ObjectStoreSync::enableCompression));
+	registerMethod("freeze", make_method(this, &ObjectStoreSync::freeze));
+	registerMethod("thaw", make_method(this, &ObjectStoreSync::thaw));
     registerMethod("openCursor", make_method(this, &ObjectStoreSync::openCursor)); 
 
 	registerMethod("createIndex", FB::make_method(this, &ObjectStoreSync::createIndex));
@@ -108,7 +111,7 @@ FB::variant ObjectStoreSync::get(FB::variant key)
 	{ 
 	try
 		{ 
-		Data& data = implementation->get(Convert::toKey(host, key), transactionFactory.getTransactionContext()); 
+		Data& data = read(Convert::toKey(host, key)); 
 
 		if(data.getType() == Data::Undefined)
 			throw DatabaseException("NOT_FOUND_ERR", DatabaseException::NOT_FOUND_ERR);
@@ -119,18 +122,35 @@ FB::variant ObjectStoreSync::get(FB::variant key)
 		{ throw DatabaseException(e); }
 	}
 
-FB::variant ObjectStoreSync::put(const FB::variant& value, const FB::variant& inKey, const boost::optional<bool> no_overwrite) 
-	{ 
+FB::variant ObjectStoreSync::resolveKey(const FB::variant& value, const FB::variant& inKey)
+	{
 	if(this->getMode() != Implementation::ObjectStore::READ_WRITE)
 		throw DatabaseException("NOT_ALLOWED_ERR", DatabaseException::NOT_ALLOWED_ERR);
 	else if(!inKey.empty() && keyPath.is_initialized())
 		throw DatabaseException("DATA_ERR", DatabaseException::DATA_ERR);
 
-	FB::variant key = !inKey.empty() ? inKey : generateKey(value);
+	return !inKey.empty() ? inKey : generateKey(value);
+	}
+
+FB::variant ObjectStoreSync::put(const FB::variant& value, const FB::variant& inKey, const boost::optional<bool> no_overwrite) 
+	{ 
+	Support::WriteSet* writeSet = transactionFactory.getWriteSet();
+
+	// As with a remove, a buffered put is rejected before anything is buffered (rather than as the set is applied)
+	if(writeSet != NULL && this->getMode() != Implementation::ObjectStore::READ_WRITE)
+		throw DatabaseException("NOT_ALLOWED_ERR", DatabaseException::NOT_ALLOWED_ERR);
+
+	FB::variant key = resolveKey(value, inKey);
 	bool noOverwrite = no_overwrite ? *no_overwrite : false;
 
 	try
-		{ implementation->put(Convert::toKey(host, key), Convert::toData(host, value), noOverwrite, transactionFactory.getTransactionContext()); }
+		{ 
+		if(writeSet == NULL)
+			implementation->put(Convert::toKey(host, key), Convert::toData(host, value), noOverwrite, transactionFactory.getTransactionContext()); 
+		// As when written through, a put that may not overwrite an existing value is silently dropped
+		else if(!noOverwrite || read(Convert::toKey(host, key)).getType() == Data::Undefined)
+			writeSet->put(FB::ptr_cast<ObjectStoreSync>(shared_from_this()), Convert::toKey(host, key), Convert::toData(host, value));
+		}
 	catch(ImplementationException& e)
 		{ throw DatabaseException(e); }
 	
@@ -139,8 +159,75 @@ FB::variant ObjectStoreSync::put(const FB::variant& value, const FB::variant& in
 
 void ObjectStoreSync::remove(FB::variant key)
 	{ 
+	Support::WriteSet* writeSet = transactionFactory.getWriteSet();
+
+	if(writeSet != NULL && this->getMode() != Implementation::ObjectStore::READ_WRITE)
+		throw DatabaseException("NOT_ALLOWED_ERR", DatabaseException::NOT_ALLOWED_ERR);
+
 	try
-		{ implementation->remove(Convert::toKey(host, key), transactionFactory.getTransactionContext()); }
+		{ 
+		if(writeSet == NULL)
+			implementation->remove(Convert::toKey(host, key), transactionFactory.getTransactionContext()); 
+		else
+			writeSet->remove(FB::ptr_cast<ObjectStoreSync>(shared_from_this()), Convert::toKey(host, key));
+		}
+	catch(ImplementationException& e)
+		{ throw DatabaseException(e); }
+	}
+
+Data ObjectStoreSync::read(const Implementation::Key& key)
+	{
+	Support::WriteSet* writeSet = transactionFactory.getWriteSet();
+	optional<Data> buffered = writeSet != NULL
+		? writeSet->find(getName(), key)
+		: optional<Data>();
+
+	if(buffered.is_initialized())
+		return buffered.get();
+
+	Data data = implementation->get(key, transactionFactory.getTransactionContext());
+
+	// An optimistic transaction validates what it read as it commits
+	Support::ReadSet* readSet = transactionFactory.getReadSet();
+	if(readSet != NULL)
+		readSet->record(FB::ptr_cast<ObjectStoreSync>(shared_from_this()), key, data);
+
+	return data;
+	}
+
+void ObjectStoreSync::enableCompression()
+	{
+	if(this->getMode() != Implementation::ObjectStore::READ_WRITE)
+		throw DatabaseException("NOT_ALLOWED_ERR", DatabaseException::NOT_ALLOWED_ERR);
+
+	try
+		{ 
+		transactionFactory.applyWrites();
+		implementation->enableCompression(transactionFactory.getTransactionContext()); 
+		}
+	catch(ImplementationException& e)
+		{ throw DatabaseException(e); }
+	}
+
+void ObjectStoreSync::freeze()
+	{
+	// A buffered transaction has nothing yet to hand the implementation, but freezing within it is no more allowed
+	if(this->getMode() != Implementation::ObjectStore::READ_WRITE || transactionFactory.getWriteSet() != NULL)
+		throw DatabaseException("NOT_ALLOWED_ERR", DatabaseException::NOT_ALLOWED_ERR);
+
+	try
+		{ implementation->freeze(getIndexNames(), transactionFactory.getTransactionContext()); }
+	catch(ImplementationException& e)
+		{ throw DatabaseException(e); }
+	}
+
+void ObjectStoreSync::thaw()
+	{
+	if(this->getMode() != Implementation::ObjectStore::READ_WRITE || transactionFactory.getWriteSet() != NULL)
+		throw DatabaseException("NOT_ALLOWED_ERR", DatabaseException::NOT_ALLOWED_ERR);
+
+	try
+		{ implementation->thaw(transactionFactory.getTransactionContext()); }
 	catch(ImplementationException& e)
 		{ throw DatabaseException(e); }
 	}
@@ -155,7 +242,7 @@ void ObjectStoreSync::close()
 	this->implementation->close(); 
 	}
 
-CursorSyncPtr ObjectStoreSync::openCursor(const boost::optional<FB::VariantMap> info, const boost::optional<int> dir)
+CursorSyncPtr ObjectStoreSync::openCursor(const boost::optional<FB::VariantMap> info, const boost::optional<int> dir, const boost::optional<int> isolation)
 	{
     KeyRangePtr range;
     if (info) {
@@ -169,15 +256,18 @@ CursorSyncPtr ObjectStoreSync::openCursor(const boost::optional<FB::VariantMap>
     }
 
 	const Cursor::Direction direction = dir ? static_cast<Cursor::Direction>(*dir) : Cursor::NEXT;
-	return openCursorDirect(range, direction);
+	return openCursorDirect(range, direction, Cursor::toIsolation(isolation));
 	}
 
-CursorSyncPtr ObjectStoreSync::openCursorDirect(const KeyRangePtr& range, const Cursor::Direction direction)
+CursorSyncPtr ObjectStoreSync::openCursorDirect(const KeyRangePtr& range, const Cursor::Direction direction, const Cursor::Isolation isolation)
 	{
 	try
 		{ 
+		// Cursors read the object store directly, so they see buffered writes only once these have been applied
+		transactionFactory.applyWrites();
+
 		CursorSyncPtr cursor(
-            new CursorSync(host, FB::ptr_cast<ObjectStoreSync>(shared_from_this()), transactionFactory, range, direction)
+            new CursorSync(host, FB::ptr_cast<ObjectStoreSync>(shared_from_this()), transactionFactory, range, direction, isolation)
             );
 		openCursors->add(cursor);
 		return cursor;
@@ -193,6 +283,11 @@ IndexSyncPtr ObjectStoreSync::createIndex(const string name, const boost::option
 		throw FB::invalid_arguments();
 	bool unique = in_unique ? *in_unique : false;
 
+	try
+		{ transactionFactory.applyWrites(); }
+	catch(ImplementationException& e)
+		{ throw DatabaseException(e); }
+
 	metadata.addToMetadataCollection("indexes", name, transactionFactory, transactionFactory.getTransactionContext());
 
 	IndexSyncPtr index(
@@ -39,11 +39,11 @@ class ObjectStoreSync : public ObjectStore
         boost::shared_ptr<Support::LifeCycleObservable<ObjectStoreSync> > _observable;
 
 	public: 
-		// Create an object store, with or without a key path
-		ObjectStoreSync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, Implementation::TransactionContext& transactionContext, Metadata& metadata, const std::string& name, const std::string& keyPath, const bool autoIncrement);
-		ObjectStoreSync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, Implementation::TransactionContext& transactionContext, Metadata& metadata, const std::string& name, const bool autoIncrement);
-		// Open an object store in the given mode
-		ObjectStoreSync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, Implementation::TransactionContext& transactionContext, Metadata& metadata, const std::string& name, const Implementation::ObjectStore::Mode mode);
+		// Create an object store, with or without a key path, organized by the given access method
+		ObjectStoreSync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, Implementation::TransactionContext& transactionContext, Metadata& metadata, const std::string& name, const std::string& keyPath, const bool autoIncrement, const Implementation::ObjectStore::AccessMethod accessMethod);
+		ObjectStoreSync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, Implementation::TransactionContext& transactionContext, Metadata& metadata, const std::string& name, const bool autoIncrement, const Implementation::ObjectStore::AccessMethod accessMethod);
+		// Open an object store in the given mode (and, optionally, bound to the given transaction)
+		ObjectStoreSync(const FB::BrowserHostPtr& host, const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, Implementation::TransactionContext& transactionContext, Metadata& metadata, const std::string& name, const Implementation::ObjectStore::Mode mode, const TransactionPtr& transaction = TransactionPtr());
 		// TODO: The subtle differences in constructors will be confusing to subsequent developers; change to static factory methods and make these protected
 		
 		~ObjectStoreSync(void);
@@ -55,11 +55,20 @@ class ObjectStoreSync : public ObjectStore
 		FB::variant get(FB::variant key);
 		// Put a new key/value pair into the object store
         FB::variant put(const FB::variant& value, const FB::variant& inKey, const boost::optional<bool> no_overwrite);
+		// Gets the key under which the given value would be put (generating one if no key is given), ensuring that
+		// a put is allowed
+		FB::variant resolveKey(const FB::variant& value, const FB::variant& key);
 		// Remove the key/value pair from the object store as identified by the given key
 		void remove(FB::variant key);
+		// Compress the values in this object store, using a dictionary trained from its current contents
+		void enableCompression();
+		// Freeze this object store (and its indexes) into an immutable form optimized for reading; writes are
+		// not allowed until it is thawed.  Neither is allowed within a transaction.
+		void freeze();
+		void thaw();
 
-		// Open a new cursor over this object store, bounded by the given range
-		boost::shared_ptr<CursorSync> openCursorDirect(const KeyRangePtr& range, const Cursor::Direction direction);
+		// Open a new cursor over this object store, bounded by the given range and reading with the given isolation
+		boost::shared_ptr<CursorSync> openCursorDirect(const KeyRangePtr& range, const Cursor::Direction direction, const Cursor::Isolation isolation);
 
 		// Create a new index over this object store
         IndexSyncPtr createIndex(const std::string name, const boost::optional<std::string> keyPath, const boost::optional<bool> in_unique);
@@ -108,9 +117,14 @@ class ObjectStoreSync : public ObjectStore
 		Metadata metadata;
 		// We need a transaction factory to get current transaction context and initiate new transactions
 		TransactionFactory transactionFactory;
+		// The transaction to which this object store is bound (if any); it is also our transaction factory, so we keep it alive
+		const TransactionPtr transaction;
+
+		// Gets the value associated with the given key, preferring that buffered by the current transaction (if any)
+		Implementation::Data read(const Implementation::Key& key);
 
 		// Internal operations to expose our functionality as weakly-typed methods to user agents
-        CursorSyncPtr openCursor(const boost::optional<FB::VariantMap> info, const boost::optional<int> dir);
+        CursorSyncPtr openCursor(const boost::optional<FB::VariantMap> info, const boost::optional<int> dir, const boost::optional<int> isolation);
 		IndexSyncPtr openIndex(const std::string& name);
 
 		void initializeMethods();
@@ -4,6 +4,11 @@ http://code.google.com/p/indexeddb
 GNU Lesser General Public License
 \**********************************************************/
 
+#include <algorithm>
+#include <cstdlib>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <variant_list.h>
 #include "TransactionSync.h"
 #include "DatabaseSync.h"
 #include "../DatabaseException.h"
@@ -22,14 +27,31 @@ using Implementation::ImplementationException;
 
 namespace API { 
 
-TransactionSync::TransactionSync(const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, const ObjectStoreSyncList& objectStores, const optional<unsigned int>& timeout)
+const unsigned int TransactionSync::maximumRetries = 5;
+const unsigned int TransactionSync::initialMillisecondsBeforeRetry = 10;
+
+TransactionSync::TransactionSync(const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, const ObjectStoreSyncList& objectStores, const Implementation::ObjectStore::Mode mode, const optional<unsigned int>& timeout, const optional<Implementation::DatabaseConfiguration::Durability>& durability, const bool buffered, const bool optimistic)
 	: Transaction(database, !objectStores.is_initialized() || (objectStores.is_initialized() && !objectStores->empty())),
-	  implementation(Implementation::AbstractDatabaseFactory::getInstance()
-		  .createTransaction(transactionFactory.getDatabaseContext(), mapObjectStoresToImplementations(objectStores), timeout, Implementation::TransactionContext())),
-	  isActive(true)
+	  TransactionFactory(transactionFactory),
+	  writeSet(buffered || optimistic ? new Support::WriteSet() : NULL),
+	  readSet(optimistic ? new Support::ReadSet() : NULL),
+	  objectStores(objectStores),
+	  mode(mode),
+	  timeout(timeout),
+	  durability(durability),
+	  openObjectStores(boost::make_shared<Support::Container<ObjectStoreSync> >()),
+	  isActive(true),
+	  retries(0)
 	{
+	// An optimistic transaction is begun (and its scope locked) only as it commits
+	if(!optimistic)
+		implementation = begin();
+
 	registerMethod("commit", make_method(this, &TransactionSync::commit));
 	registerMethod("abort", make_method(this, &TransactionSync::abort));
+	registerMethod("objectStore", make_method(this, &TransactionSync::objectStore));
+	registerProperty("retries", make_property(this, &TransactionSync::getRetries));
+	registerProperty("onretry", make_property(this, &TransactionSync::getOnRetry, &TransactionSync::setOnRetry));
 	}
 
 TransactionSync::~TransactionSync()
@@ -46,9 +68,18 @@ void TransactionSync::abort()
 	if(isActive)
 		{
 		isActive = false;
+		if(writeSet.get() != NULL)
+			writeSet->clear();
+		if(readSet.get() != NULL)
+			readSet->clear();
 		Transaction::abort();
+		openObjectStores->raiseTransactionAborted(FB::ptr_cast<Transaction>(shared_from_this()));
+		openObjectStores->release();
 		try
-			{ implementation->abort(); }
+			{ 
+			if(implementation.get() != NULL)
+				implementation->abort(); 
+			}
 		catch(ImplementationException& e) 
 			{ throw DatabaseException(e); }
 		}
@@ -60,8 +91,24 @@ void TransactionSync::commit()
 	{ 
 	if(isActive)
 		{
+		// Our buffered writes are applied before anyone learns of the commit; if they cannot be, we abort instead
+		try
+			{ prepare(); }
+		catch(ImplementationException& e) 
+			{ 
+			abort();
+			throw DatabaseException(e); 
+			}
+
+		if(writeSet.get() != NULL)
+			writeSet->clear();
+		if(readSet.get() != NULL)
+			readSet->clear();
+
 		isActive = false;
 		Transaction::commit();
+		openObjectStores->raiseTransactionCommitted(FB::ptr_cast<Transaction>(shared_from_this()));
+		openObjectStores->release();
 		try
 			{ implementation->commit(); }
 		catch(ImplementationException& e) 
@@ -74,9 +121,93 @@ void TransactionSync::commit()
 void TransactionSync::close()
 	{
 	isActive = false;
+	if(writeSet.get() != NULL)
+		writeSet->clear();
+	if(readSet.get() != NULL)
+		readSet->clear();
+	openObjectStores->release();
 	implementation.reset();
 	}
 
+std::auto_ptr<Implementation::Transaction> TransactionSync::begin()
+	{ 
+	return getFactory().createTransaction(getDatabaseContext(), mapObjectStoresToImplementations(objectStores), 
+		mode, timeout, durability, Implementation::TransactionContext()); 
+	}
+
+void TransactionSync::prepare()
+	{
+	// All that an optimistic transaction does within its underlying implementation is held here, so it may be replayed
+	const bool isReplayable = implementation.get() == NULL;
+
+	for(unsigned int attempt = 0; ; attempt++)
+		try
+			{
+			if(implementation.get() == NULL)
+				{
+				implementation = begin();
+
+				// Reading again within our (now locked) scope, the values we read must not have changed
+				if(!readSet->validate(getTransactionContext()))
+					throw ImplementationException("SERIAL_ERR", ImplementationException::SERIAL_ERR);
+				}
+
+			if(writeSet.get() != NULL)
+				writeSet->apply(getTransactionContext());
+			return;
+			}
+		catch(ImplementationException& e)
+			{
+			if(e.code != ImplementationException::DEADLOCK_ERR || !isReplayable || attempt == maximumRetries)
+				throw;
+
+			// Abandon this attempt (releasing our locks), and give those we deadlocked with a chance to finish
+			implementation->abort();
+			implementation.reset();
+			retries++;
+
+			// A callback that fails does not keep us from retrying
+			if(onRetry)
+				try
+					{ onRetry->Invoke("", FB::variant_list_of(retries)); }
+				catch(const FB::script_error&) { }
+
+			boost::this_thread::sleep(boost::posix_time::milliseconds(getMillisecondsBeforeRetry(attempt)));
+			}
+	}
+
+unsigned int TransactionSync::getMillisecondsBeforeRetry(const unsigned int attempt)
+	{
+	// The delay doubles with each attempt; half of it is random, so that those retrying together drift apart
+	const unsigned int milliseconds = initialMillisecondsBeforeRetry << attempt;
+	return milliseconds / 2 + static_cast<unsigned int>(rand()) % (milliseconds / 2 + 1);
+	}
+
+void TransactionSync::setOnRetry(const FB::variant& callback)
+	{
+	if(callback.empty() || callback.is_of_type<FB::FBNull>())
+		onRetry.reset();
+	else if(callback.can_be_type<FB::JSObjectPtr>())
+		onRetry = callback.convert_cast<FB::JSObjectPtr>();
+	else
+		throw FB::invalid_arguments();
+	}
+
+ObjectStoreSyncPtr TransactionSync::objectStore(const std::string& name)
+	{
+	if(!isActive)
+		throw DatabaseException("NOT_ALLOWED_ERR", DatabaseException::NOT_ALLOWED_ERR);
+	else if(objectStores.is_initialized() && 
+			std::find_if(objectStores->begin(), objectStores->end(), 
+				boost::bind(&ObjectStoreSync::getName, _1) == name) == objectStores->end())
+		throw DatabaseException("NOT_FOUND_ERR", DatabaseException::NOT_FOUND_ERR);
+
+	ObjectStoreSyncPtr objectStore = FB::ptr_cast<DatabaseSync>(getDatabase())
+		->openObjectStore(name, mode, *this, FB::ptr_cast<Transaction>(shared_from_this()));
+	openObjectStores->add(objectStore);
+	return objectStore;
+	}
+
 const ObjectStoreImplementationList TransactionSync::mapObjectStoresToImplementations(const ObjectStoreSyncList& objectStores)
 	{
 	if(objectStores.is_initialized())
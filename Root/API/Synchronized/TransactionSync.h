@@ -19,15 +19,36 @@ namespace IndexedDB {
 namespace API { 
 
 ///<summary>
-/// This class represents a synchronized transaction in the Indexed Database API.
+/// This class represents a synchronized transaction in the Indexed Database API.  Its scope is locked in the mode
+/// with which it was begun (so that readers may share object stores, while writers have them to themselves).
+/// Many transactions may be outstanding on a database; object stores opened through a transaction (rather than
+/// through its database) operate within that transaction, for which it is their transaction factory.
+///
+/// A buffered transaction holds its puts and removes in a write set (which its own reads consult) rather than
+/// writing them through; they are applied in key order as it commits, so that its write locks are held only
+/// for as long as that takes.  An optimistic transaction is buffered, and further takes no locks until it commits:
+/// its reads are recorded, and only once its scope is locked (as it commits) are they validated and its writes
+/// applied.  Should a value it read have since changed, it aborts with a SERIAL_ERR (and may simply be retried).
+/// Only gets, puts and removes on object stores are allowed before an optimistic transaction commits.  Since all
+/// that it does as it commits is held in its read and write sets, an optimistic transaction that deadlocks as it
+/// commits is transparently retried (after a jittered, exponentially increasing delay) a bounded number of times.
+///
+/// Those delays are spent in commit, on the calling (browser) thread, which is blocked for up to about 310 ms should
+/// every retry be needed.  Before each retry the onretry callback (if any) is invoked with the number of retries so
+/// far, so that a page may release whatever it holds that conflicts with the commit.
 ///</summary>
-class TransactionSync : public Transaction
+class TransactionSync : public Transaction, public TransactionFactory
 {
 public:
-	TransactionSync(const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, const ObjectStoreSyncList& objectStores, const boost::optional<unsigned int>& timeout);
+	TransactionSync(const DatabaseSyncPtr& database, TransactionFactory& transactionFactory, const ObjectStoreSyncList& objectStores, const Implementation::ObjectStore::Mode mode, const boost::optional<unsigned int>& timeout, const boost::optional<Implementation::DatabaseConfiguration::Durability>& durability, const bool buffered, const bool optimistic);
 	~TransactionSync();
 
 	bool getIsActive() const { return isActive; }
+	// Gets the number of times the commit of this transaction was retried after a deadlock
+	unsigned int getRetries() const { return retries; }
+	// Gets (or sets) the callback invoked before each such retry
+	FB::variant getOnRetry() const { return onRetry; }
+	void setOnRetry(const FB::variant& callback);
 
 	// Not much to do here; transactions do one of two things...
 	virtual void abort();
@@ -36,19 +57,52 @@ public:
 	// Forcably close this transaction (technically behavior is undefined, but we all know this will abort...)
 	void close();
 
-protected:
+	// Opens an object store within the scope of this transaction (in the mode with which it was begun)
+	ObjectStoreSyncPtr objectStore(const std::string& name);
+
 	// Get the underlying implementation associated with this transaction (which is itself a TransactionContext)
-	virtual Implementation::TransactionContext getTransactionContext() const { return *implementation; }
+	virtual Implementation::TransactionContext getTransactionContext() const 
+		{ return implementation.get() != NULL ? Implementation::TransactionContext(*implementation) : Implementation::TransactionContext(); }
+	// Get the writes buffered by this transaction (NULL if it writes through)
+	virtual Support::WriteSet* getWriteSet() const
+		{ return writeSet.get(); }
+	// Get the reads recorded by this transaction (NULL unless it is optimistic)
+	virtual Support::ReadSet* getReadSet() const
+		{ return readSet.get(); }
 
 private:
 	// Own a reference to our underlying implementation
 	std::auto_ptr<Implementation::Transaction> implementation;
-	// Maintain a transaction factory so we can initiate and manage transactions
-	//TransactionFactory transactionFactory;
+	// The writes buffered by this transaction, if it is buffered
+	const std::auto_ptr<Support::WriteSet> writeSet;
+	// The reads recorded by this transaction, if it is optimistic
+	const std::auto_ptr<Support::ReadSet> readSet;
+	// The object stores in our scope (none if the scope is the whole database), and the mode in which they were opened
+	const ObjectStoreSyncList objectStores;
+	const Implementation::ObjectStore::Mode mode;
+	// The timeout and durability with which our underlying implementation is begun
+	const boost::optional<unsigned int> timeout;
+	const boost::optional<Implementation::DatabaseConfiguration::Durability> durability;
+	// We maintain a list of the object stores opened through this transaction, which are closed when it ends
+	boost::shared_ptr<Support::Container<ObjectStoreSync> > openObjectStores;
 	bool isActive;
+	unsigned int retries;
+	FB::JSObjectPtr onRetry;
 
 	boost::mutex synchronization;
 
+	// Begins our underlying implementation, first locking our scope (in our mode)
+	std::auto_ptr<Implementation::Transaction> begin();
+	// Validates the reads recorded by an optimistic transaction (which is begun first), and applies our buffered writes;
+	// an optimistic transaction is retried should it deadlock
+	void prepare();
+
+	// The number of times an optimistic transaction that deadlocks is retried, and the delay before the first retry
+	static const unsigned int maximumRetries;
+	static const unsigned int initialMillisecondsBeforeRetry;
+	// Helper method to choose the delay before the given (zero-based) retry
+	static unsigned int getMillisecondsBeforeRetry(const unsigned int attempt);
+
 	static const Implementation::ObjectStoreImplementationList
 		mapObjectStoresToImplementations(const ObjectStoreSyncList& objectStores);
 
@@ -62,8 +116,6 @@ private:
 
 		Implementation::ObjectStoreImplementationList& objectStoreImplementations;
 		};
-
-	friend Implementation::TransactionContext RootTransactionFactory::getTransactionContext() const;
 };
 
 }
@@ -5,7 +5,10 @@ GNU Lesser General Public License
 \**********************************************************/
 
 #include "AbstractDatabaseFactory.h"
+#include "ImplementationException.h"
 #include "BerkeleyDatabase/BerkeleyDatabaseFactory.h"
+#include "MemoryDatabase/MemoryDatabaseFactory.h"
+#include "LsmDatabase/LsmDatabaseFactory.h"
 
 namespace BrandonHaynes {
 namespace IndexedDB { 
@@ -16,6 +19,21 @@ namespace Implementation {
 		static BerkeleyDB::BerkeleyDatabaseFactory instance;
 		return static_cast<AbstractDatabaseFactory&>(instance); 
 		}
+
+	AbstractDatabaseFactory& AbstractDatabaseFactory::getInstance(const std::string& engine) 
+		{ 
+		static Memory::MemoryDatabaseFactory memoryInstance;
+		static Lsm::LsmDatabaseFactory lsmInstance;
+
+		if(engine.empty() || engine == BerkeleyDB::BerkeleyDatabaseFactory::engineName)
+			return getInstance();
+		else if(engine == Memory::MemoryDatabaseFactory::engineName)
+			return static_cast<AbstractDatabaseFactory&>(memoryInstance);
+		else if(engine == Lsm::LsmDatabaseFactory::engineName)
+			return static_cast<AbstractDatabaseFactory&>(lsmInstance);
+		else
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		}
 }
 }
 }
\ No newline at end of file
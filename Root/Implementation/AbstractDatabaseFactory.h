@@ -11,6 +11,8 @@ GNU Lesser General Public License
 #include <list>
 #include "Transaction.h"
 #include "ObjectStore.h"
+#include "Cursor.h"
+#include "DatabaseConfiguration.h"
 
 namespace BrandonHaynes {
 namespace IndexedDB { 
@@ -18,7 +20,6 @@ namespace Implementation {
 
 	class Database;
 	class Index;
-	class Cursor;
 	class Key;
 	class KeyGenerator;
 
@@ -26,32 +27,37 @@ namespace Implementation {
 	/// This is an abstract base factory interface for various implementations that back the Indexed Database API.
 	/// Any new implementation my implement all methods herein in order to interact with the API layer.
 	///
-	/// Note that the static getInstance is currently a bit lame, and is not configurable (nor does it read from
-	/// a configuration file or anything remotely sophisticated).  This will need to be fixed if subsequent
-	/// backing data stores are attempted.
+	/// Each engine is identified by name (e.g. "berkeleydb", "memory" or "lsm"), and the engine is chosen (along with
+	/// its tuning; see DatabaseConfiguration) when a database is opened.  Everything subsequently created over that database must come from the same engine,
+	/// so callers should use Database::getFactory rather than assume a particular engine.
 	///</summary>
 	class AbstractDatabaseFactory
 		{
 		public:
-			/// Retreives the currently configured factory for the application
+			/// Retreives the default factory for the application
 			static AbstractDatabaseFactory& getInstance();
+			/// Retreives the factory for the named engine (the default if the name is empty)
+			static AbstractDatabaseFactory& getInstance(const std::string& engine);
 
-			/// Creates a new Indexed Database API database with the given configuration
-			virtual std::auto_ptr<Database> createDatabase(const std::string& origin, const std::string& name, const std::string& description, const bool modifyDatabase = true) = 0;
+			/// Creates a new Indexed Database API database with the given configuration (tuning that does not apply to the engine is ignored)
+			virtual std::auto_ptr<Database> createDatabase(const std::string& origin, const std::string& name, const std::string& description, const bool modifyDatabase = true, const DatabaseConfiguration& configuration = DatabaseConfiguration()) = 0;
 
-			/// Creates a new Indexed Database API object store with the given configuration (and within the context of an optional transaction)
-			virtual std::auto_ptr<ObjectStore> createObjectStore(Database& database, const std::string& name, const bool autoIncrement = true, TransactionContext& transactionContext = TransactionContext()) = 0;
+			/// Creates a new Indexed Database API object store with the given configuration (and within the context of an optional transaction); engines
+			/// that offer a single access method ignore the one requested
+			virtual std::auto_ptr<ObjectStore> createObjectStore(Database& database, const std::string& name, const bool autoIncrement = true, const ObjectStore::AccessMethod accessMethod = ObjectStore::ORDERED, TransactionContext& transactionContext = TransactionContext()) = 0;
 			/// Opens an existing Indexed Database API object store with the given name and mode (and within the context of an optional transaction)
 			virtual std::auto_ptr<ObjectStore> openObjectStore(Database& database, const std::string& name, const ObjectStore::Mode mode, TransactionContext& transactionContext) = 0;
 
-			/// Opens a new cursor over the given object store on the interval (left, right) (and possibly open and/or reversed)
-			virtual std::auto_ptr<Cursor> openCursor(ObjectStore& objectStore, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, TransactionContext& transactionContext) = 0;
+			/// Opens a new cursor over the given object store on the interval (left, right) (and possibly open and/or reversed), reading
+			/// with the given isolation (engines that take no read locks ignore it)
+			virtual std::auto_ptr<Cursor> openCursor(ObjectStore& objectStore, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const Cursor::Isolation isolation, TransactionContext& transactionContext) = 0;
 			/// Opens a new cursor over the given index on the interval (left, right) 
-			virtual std::auto_ptr<Cursor> openCursor(Index& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool returnkeys, TransactionContext& transactionContext) = 0;
+			virtual std::auto_ptr<Cursor> openCursor(Index& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool returnkeys, const Cursor::Isolation isolation, TransactionContext& transactionContext) = 0;
 		
-			/// Creates a transaction over the given database.  Any object stores passed in are locked for the duration of the transaction (per spec).  
-			/// This may be a nested transaction.
-			virtual std::auto_ptr<Transaction> createTransaction(Database& database, const ObjectStoreImplementationList& objectStores, const boost::optional<unsigned int>& timeout, TransactionContext& transactionContext) = 0;
+			/// Creates a transaction over the given database.  Given a mode, its scope (the object stores passed in, or the whole database if none are)
+			/// is locked in that mode for the duration of the transaction (per spec); internal transactions pass none.  This may be a nested transaction.  Unless a durability is given, the transaction has that configured for the database
+			/// (engines without a log ignore it).
+			virtual std::auto_ptr<Transaction> createTransaction(Database& database, const ObjectStoreImplementationList& objectStores, const boost::optional<ObjectStore::Mode>& mode, const boost::optional<unsigned int>& timeout, const boost::optional<DatabaseConfiguration::Durability>& durability, TransactionContext& transactionContext) = 0;
 
 			/// Creates a new index over a given object store.  The key generator is used to generate secondary keys on the index.
 			virtual std::auto_ptr<Index> createIndex(ObjectStore& objectStore, const std::string& name, const std::auto_ptr<KeyGenerator>& keyGenerator, const bool unique, TransactionContext& transactionContext) = 0;
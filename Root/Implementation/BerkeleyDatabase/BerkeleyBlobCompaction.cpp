@@ -0,0 +1,86 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <boost/bind.hpp>
+#include "BerkeleyBlobCompaction.h"
+#include "BerkeleyBlobStore.h"
+#include "../ImplementationException.h"
+
+using std::string;
+using boost::mutex;
+using boost::lock_guard;
+using boost::unique_lock;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	BerkeleyBlobCompaction::BerkeleyBlobCompaction(DbEnv& environment, const string& name, const int millisecondsBetweenCompactions)
+		: environment(environment), name(name), millisecondsBetweenCompactions(millisecondsBetweenCompactions), isRunning(false)
+		{ }
+
+	BerkeleyBlobCompaction::~BerkeleyBlobCompaction()
+		{ stop(); }
+
+	void BerkeleyBlobCompaction::start()
+		{
+		lock_guard<mutex> guard(synchronized);
+
+		if(!isRunning)
+			{
+			isRunning = true;
+			compactionThread = std::auto_ptr<boost::thread>(new boost::thread(boost::bind(
+				&BerkeleyBlobCompaction::compactBlobs, this)));
+			}
+		}
+
+	void BerkeleyBlobCompaction::stop()
+		{
+			{
+			lock_guard<mutex> guard(synchronized);
+			if(!isRunning)
+				return;
+
+			isRunning = false;
+			stopped.notify_all();
+			}
+
+		compactionThread->join();
+		}
+
+	void BerkeleyBlobCompaction::compactBlobs()
+		{
+		unique_lock<mutex> lock(synchronized);
+
+		// Automatically terminate whenever the isRunning flag is cleared (which also cuts short our wait)
+		while(isRunning)
+			{
+			// A pass may take some time, so it runs without the lock (and stops between segments once asked)
+			lock.unlock();
+			try
+				{ compactSegments(); }
+			catch(ImplementationException& e)
+				{ environment.errx("Large value compaction failed (%d, %d); it will be retried", e.code, e.underlyingCode); }
+			lock.lock();
+
+			if(isRunning)
+				stopped.timed_wait(lock, boost::posix_time::milliseconds(millisecondsBetweenCompactions));
+			}
+		}
+
+	void BerkeleyBlobCompaction::compactSegments()
+		{
+		// The catalog is opened only for the length of a pass
+		BerkeleyBlobStore blobs(environment, name, 0);
+
+		while(isRunning && blobs.compact())
+			;
+		}
+	}
+}
+}
+}
@@ -0,0 +1,59 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYBLOBCOMPACTION_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYBLOBCOMPACTION_H
+
+#include <string>
+#include <memory>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <db_cxx.h>
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	///<summary>
+	/// This class compacts the large values of a database (see BerkeleyBlobStore), so that the space released by
+	/// deleted and overwritten values is reclaimed without blocking the thread that opened it.  A pass runs when
+	/// compaction starts and again on every interval; a pass that fails is reported through the environment's error
+	/// stream and retried on the next.  Like BerkeleyCheckpointing, it runs on a thread of its own and is managed by
+	/// BerkeleyEnvironmentServices.  This class is RAII.
+	///</summary>
+	class BerkeleyBlobCompaction
+		{
+		public:
+			// Create a compaction thread for the large values of the named database in the given environment
+			BerkeleyBlobCompaction(DbEnv& environment, const std::string& name, const int millisecondsBetweenCompactions);
+			~BerkeleyBlobCompaction();
+
+			// Start (or conclude) compaction on this thread; stopping waits for the segment being compacted (if any)
+			void start();
+			void stop();
+
+		private:
+			DbEnv& environment;
+			const std::string name;
+			const int millisecondsBetweenCompactions;
+
+			std::auto_ptr<boost::thread> compactionThread;
+			boost::mutex synchronized;
+			boost::condition_variable stopped;
+			volatile bool isRunning;
+
+			// Method fired once every interval; compacts each sparse segment in turn
+			void compactBlobs();
+			void compactSegments();
+		};
+	}
+}
+}
+}
+
+#endif
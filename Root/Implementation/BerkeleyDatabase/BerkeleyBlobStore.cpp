@@ -0,0 +1,567 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <cstdio>
+#include <boost/lexical_cast.hpp>
+#include "BerkeleyBlobStore.h"
+#include "BerkeleyDatabase.h"
+#include "../Data.h"
+#include "../FileSynchronization.h"
+#include "../ImplementationException.h"
+
+using std::map;
+using std::set;
+using std::string;
+using boost::mutex;
+using boost::lock_guard;
+using boost::optional;
+using boost::uint32_t;
+using boost::uint64_t;
+using boost::filesystem::path;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	const uint32_t BerkeleyBlobStore::segmentSize = 256 * 1024 * 1024;
+	const size_t BerkeleyBlobStore::maximumCachedLocations = 1024;
+	const unsigned char BerkeleyBlobStore::referenceMarker = 0xFF;
+	const size_t BerkeleyBlobStore::referenceSize = 1 + sizeof(uint64_t);
+	const uint64_t BerkeleyBlobStore::tailKey = ~static_cast<uint64_t>(0);
+	const uint64_t BerkeleyBlobStore::retiredKey = ~static_cast<uint64_t>(0) - 1;
+
+	namespace
+		{
+		// Closes a segment file when it leaves scope
+		class SegmentFile
+			{
+			public:
+				SegmentFile(const path& segmentPath, const bool create)
+					: file(fopen(segmentPath.file_string().c_str(), "r+b"))
+					{
+					if(file == NULL && create)
+						file = fopen(segmentPath.file_string().c_str(), "w+b");
+					if(file == NULL)
+						throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, errno);
+					}
+				~SegmentFile()
+					{ fclose(file); }
+
+				void seek(const uint32_t offset)
+					{
+					if(fseek(file, static_cast<long>(offset), SEEK_SET) != 0)
+						throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, errno);
+					}
+
+				FILE* file;
+			};
+		}
+
+	BerkeleyBlobStore::BerkeleyBlobStore(DbEnv& environment, const string& name, const size_t threshold)
+		: catalog(&environment, 0), home(getHome(environment)), threshold(threshold), isOpen(true)
+		{
+		try
+			{ catalog.open(NULL, (name + "__blobs").c_str(), NULL, DB_BTREE, DB_CREATE | DB_AUTO_COMMIT | DB_THREAD, 0); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		}
+
+	BerkeleyBlobStore::~BerkeleyBlobStore()
+		{
+		try
+			{ close(); }
+		catch(ImplementationException&)
+			{ }
+		}
+
+	bool BerkeleyBlobStore::isLarge(const Data& data) const
+		{ return threshold != 0 && data.getSize() > threshold; }
+
+	bool BerkeleyBlobStore::isReference(const Dbt& value)
+		{ return value.get_size() == referenceSize && *static_cast<unsigned char*>(value.get_data()) == referenceMarker; }
+
+	BerkeleyBlobStore::Reference BerkeleyBlobStore::write(const Data& data, DbTxn* transaction)
+		{
+		Location location = allocate(static_cast<uint32_t>(data.getSize()));
+		uint64_t id = (static_cast<uint64_t>(location.segment) << 32) | location.offset;
+		unsigned char key[sizeof(uint64_t)];
+
+		// The value must be durable before anything may refer to it
+		writeSegment(location, static_cast<const void*>(data));
+		cache(id, location);
+		toKey(id, key);
+
+		try
+			{ catalog.put(transaction, &Dbt(key, sizeof(key)), &Dbt(&location, sizeof(location)), 0); }
+		catch(DbDeadlockException& e)
+			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+
+		return makeReference(id);
+		}
+
+	Data BerkeleyBlobStore::read(const Dbt& reference, DbTxn* transaction)
+		{
+		const uint64_t id = getId(reference.get_data());
+		const Location location = find(id, transaction);
+
+		// The segment holds the complete encoded value, which we read directly into the buffer that Data adopts
+		std::vector<unsigned char> buffer(location.length);
+		try
+			{ readSegment(location, &buffer[0]); }
+		catch(ImplementationException&)
+			{
+			// A cached location may refer to a segment since compacted and removed, so we consult the catalog
+			uncache(id);
+			const Location current = find(id, transaction);
+			if(current.segment == location.segment && current.offset == location.offset)
+				throw;
+
+			buffer.resize(current.length);
+			readSegment(current, &buffer[0]);
+			}
+		return Data(buffer);
+		}
+
+	void BerkeleyBlobStore::release(const Reference& reference, DbTxn* transaction)
+		{
+		unsigned char key[sizeof(uint64_t)];
+		toKey(getId(&reference[0]), key);
+
+		try
+			{ catalog.del(transaction, &Dbt(key, sizeof(key)), 0); }
+		catch(DbDeadlockException& e)
+			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		}
+
+	void BerkeleyBlobStore::releaseAll(Db& database, DbTxn* transaction)
+		{
+		Dbc* cursor = NULL;
+		Dbt key, value;
+
+		try
+			{
+			database.cursor(transaction, &cursor, 0);
+			while(cursor->get(&key, &value, DB_NEXT) == 0)
+				if(isReference(value))
+					release(Reference(static_cast<unsigned char*>(value.get_data()), static_cast<unsigned char*>(value.get_data()) + referenceSize), transaction);
+			cursor->close();
+			}
+		catch(DbDeadlockException& e)
+			{
+			if(cursor != NULL) cursor->close();
+			throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno());
+			}
+		catch(DbException& e)
+			{
+			if(cursor != NULL) cursor->close();
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno());
+			}
+		}
+
+	optional<BerkeleyBlobStore::Reference> BerkeleyBlobStore::getReference(Db& database, const Dbt& key, DbTxn* transaction)
+		{
+		Reference reference(referenceSize);
+		Dbt value(&reference[0], referenceSize);
+
+		// Only read enough of the existing value to recognize a reference
+		value.set_flags(DB_DBT_USERMEM | DB_DBT_PARTIAL);
+		value.set_ulen(referenceSize);
+		value.set_doff(0);
+		value.set_dlen(referenceSize);
+
+		try
+			{
+			if(database.get(transaction, const_cast<Dbt*>(&key), &value, transaction != NULL ? DB_RMW : 0) == 0 && isReference(value))
+				return reference;
+			else
+				return optional<Reference>();
+			}
+		catch(DbDeadlockException& e)
+			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		}
+
+	optional<BerkeleyBlobStore::Reference> BerkeleyBlobStore::getReference(Dbc* cursor)
+		{
+		Reference reference(referenceSize);
+		Dbt key, value(&reference[0], referenceSize);
+
+		value.set_flags(DB_DBT_USERMEM | DB_DBT_PARTIAL);
+		value.set_ulen(referenceSize);
+		value.set_doff(0);
+		value.set_dlen(referenceSize);
+
+		try
+			{
+			if(cursor->get(&key, &value, DB_CURRENT) == 0 && isReference(value))
+				return reference;
+			else
+				return optional<Reference>();
+			}
+		catch(DbDeadlockException& e)
+			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		}
+
+	bool BerkeleyBlobStore::compact()
+		{
+		map<uint32_t, uint64_t> liveBytes;
+		map<uint32_t, std::vector<uint64_t> > liveIds;
+		set<uint32_t> retired, removed;
+		std::vector<uint32_t> candidates;
+		unsigned char tail[sizeof(uint64_t)], retiredSegments[sizeof(uint64_t)];
+		Location current;
+		Dbc* cursor = NULL;
+		DbTxn* transaction = NULL;
+		Dbt key;
+		BerkeleyDatabase::ReturnedDbt value;
+
+		toKey(tailKey, tail);
+		toKey(retiredKey, retiredSegments);
+
+		try
+			{
+			if(catalog.get(NULL, &Dbt(tail, sizeof(tail)), &value, 0) != 0)
+				return false;
+			current = toLocation(value);
+
+			if(catalog.get(NULL, &Dbt(retiredSegments, sizeof(retiredSegments)), &value, 0) == 0)
+				retired = toSegments(value);
+
+			// Tally the live bytes in each segment
+			catalog.cursor(NULL, &cursor, 0);
+			while(cursor->get(&key, &value, DB_NEXT) == 0)
+				{
+				uint64_t id = fromKey(static_cast<unsigned char*>(key.get_data()));
+				if(id == tailKey || id == retiredKey)
+					continue;
+
+				Location location = toLocation(value);
+				if(location.segment != current.segment)
+					{
+					liveBytes[location.segment] += location.length;
+					liveIds[location.segment].push_back(id);
+					}
+				}
+			cursor->close();
+			cursor = NULL;
+			}
+		catch(DbException& e)
+			{
+			if(cursor != NULL) cursor->close();
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno());
+			}
+
+		// A segment was retired by an earlier pass, so any reader that found a location within it before then has
+		// long since finished (or, holding it in a cache, will look it up again).  Only new values are written, and
+		// only to the current segment, so once the catalog no longer refers to a retired segment it never will again.
+		for(set<uint32_t>::const_iterator segment = retired.begin(); segment != retired.end(); segment++)
+			if(liveIds.find(*segment) == liveIds.end())
+				try
+					{
+					boost::filesystem::remove(getSegmentPath(*segment));
+					removed.insert(*segment);
+					}
+				// A segment still open elsewhere may not be removable on every platform; it is retried on the next pass
+				catch(boost::filesystem::filesystem_error&) { }
+
+		if(!removed.empty())
+			try
+				{
+				catalog.get_env()->txn_begin(NULL, &transaction, 0);
+				updateRetired(set<uint32_t>(), removed, transaction);
+
+				DbTxn* committing = transaction;
+				transaction = NULL;
+				committing->commit(0);
+				}
+			catch(DbException& e)
+				{
+				if(transaction != NULL) transaction->abort();
+				throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno());
+				}
+			catch(ImplementationException&)
+				{
+				if(transaction != NULL) transaction->abort();
+				throw;
+				}
+
+		// Only rewrite segments that are less than half full (and not already retired)
+		for(uint32_t segment = 0; segment < current.segment; segment++)
+			if(retired.find(segment) == retired.end() && boost::filesystem::exists(getSegmentPath(segment)) &&
+			   liveBytes[segment] * 2 <= boost::filesystem::file_size(getSegmentPath(segment)))
+				candidates.push_back(segment);
+
+		if(candidates.empty())
+			return false;
+
+		const uint32_t segment = candidates.front();
+
+		try
+			{
+			catalog.get_env()->txn_begin(NULL, &transaction, 0);
+
+			for(std::vector<uint64_t>::const_iterator iterator = liveIds[segment].begin(); iterator != liveIds[segment].end(); iterator++)
+				{
+				unsigned char id[sizeof(uint64_t)];
+				Location location = find(*iterator, transaction);
+				Location destination = allocate(location.length);
+				std::vector<unsigned char> buffer(location.length);
+
+				readSegment(location, &buffer[0]);
+				writeSegment(destination, &buffer[0]);
+
+				toKey(*iterator, id);
+				catalog.put(transaction, &Dbt(id, sizeof(id)), &Dbt(&destination, sizeof(destination)), 0);
+				}
+
+			// The segment itself is left for a later pass to remove
+			updateRetired(set<uint32_t>(&segment, &segment + 1), set<uint32_t>(), transaction);
+
+			DbTxn* committing = transaction;
+			transaction = NULL;
+			committing->commit(0);
+			}
+		catch(DbException& e)
+			{
+			if(transaction != NULL) transaction->abort();
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno());
+			}
+		catch(ImplementationException&)
+			{
+			if(transaction != NULL) transaction->abort();
+			throw;
+			}
+
+		// Relocated values may have been cached at their old locations
+			{
+			lock_guard<mutex> guard(synchronization);
+			locations.clear();
+			}
+
+		return candidates.size() > 1;
+		}
+
+	void BerkeleyBlobStore::close()
+		{
+		lock_guard<mutex> guard(synchronization);
+
+		if(isOpen)
+			try
+				{
+				isOpen = false;
+				catalog.close(0);
+				}
+			catch(DbException& e)
+				{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		}
+
+	BerkeleyBlobStore::Location BerkeleyBlobStore::allocate(const uint32_t length)
+		{
+		unsigned char key[sizeof(uint64_t)];
+		DbTxn* transaction = NULL;
+		Location location = { 0, 0, length };
+		BerkeleyDatabase::ReturnedDbt value;
+
+		toKey(tailKey, key);
+
+		try
+			{
+			catalog.get_env()->txn_begin(NULL, &transaction, 0);
+
+			if(catalog.get(transaction, &Dbt(key, sizeof(key)), &value, DB_RMW) == 0)
+				{
+				Location tail = toLocation(value);
+				location.segment = tail.segment;
+				location.offset = tail.offset;
+				}
+
+			// Roll over to a new segment when this one is full (values larger than a segment get their own)
+			if(location.offset != 0 && static_cast<uint64_t>(location.offset) + length > segmentSize)
+				{
+				location.segment++;
+				location.offset = 0;
+				}
+
+			Location tail = { location.segment, location.offset + length, 0 };
+			catalog.put(transaction, &Dbt(key, sizeof(key)), &Dbt(&tail, sizeof(tail)), 0);
+
+			DbTxn* committing = transaction;
+			transaction = NULL;
+			committing->commit(0);
+			return location;
+			}
+		catch(DbDeadlockException& e)
+			{
+			if(transaction != NULL) transaction->abort();
+			throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno());
+			}
+		catch(DbException& e)
+			{
+			if(transaction != NULL) transaction->abort();
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno());
+			}
+		}
+
+	BerkeleyBlobStore::Location BerkeleyBlobStore::find(const uint64_t id, DbTxn* transaction)
+		{
+			{
+			lock_guard<mutex> guard(synchronization);
+			map<uint64_t, Location>::const_iterator iterator = locations.find(id);
+			if(iterator != locations.end())
+				return iterator->second;
+			}
+
+		unsigned char key[sizeof(uint64_t)];
+		BerkeleyDatabase::ReturnedDbt value;
+		int result;
+
+		toKey(id, key);
+
+		try
+			{ result = catalog.get(transaction, &Dbt(key, sizeof(key)), &value, 0); }
+		catch(DbDeadlockException& e)
+			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+
+		if(result == DB_NOTFOUND)
+			throw ImplementationException("NOT_FOUND_ERR", ImplementationException::NOT_FOUND_ERR);
+		else if(result != 0)
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, result);
+
+		Location location = toLocation(value);
+		cache(id, location);
+		return location;
+		}
+
+	void BerkeleyBlobStore::cache(const uint64_t id, const Location& location)
+		{
+		lock_guard<mutex> guard(synchronization);
+
+		if(locations.size() >= maximumCachedLocations)
+			locations.clear();
+		locations[id] = location;
+		}
+
+	void BerkeleyBlobStore::uncache(const uint64_t id)
+		{
+		lock_guard<mutex> guard(synchronization);
+		locations.erase(id);
+		}
+
+	void BerkeleyBlobStore::updateRetired(const set<uint32_t>& added, const set<uint32_t>& removed, DbTxn* transaction)
+		{
+		unsigned char key[sizeof(uint64_t)];
+		BerkeleyDatabase::ReturnedDbt value;
+		set<uint32_t> retired;
+
+		toKey(retiredKey, key);
+
+		// Compaction may run in more than one process at a time, so the set is read with intent to write
+		if(catalog.get(transaction, &Dbt(key, sizeof(key)), &value, DB_RMW) == 0)
+			retired = toSegments(value);
+
+		retired.insert(added.begin(), added.end());
+		for(set<uint32_t>::const_iterator segment = removed.begin(); segment != removed.end(); segment++)
+			retired.erase(*segment);
+
+		const std::vector<uint32_t> segments(retired.begin(), retired.end());
+		if(segments.empty())
+			catalog.del(transaction, &Dbt(key, sizeof(key)), 0);
+		else
+			catalog.put(transaction, &Dbt(key, sizeof(key)), 
+				&Dbt(const_cast<uint32_t*>(&segments[0]), static_cast<u_int32_t>(segments.size() * sizeof(uint32_t))), 0);
+		}
+
+	void BerkeleyBlobStore::writeSegment(const Location& location, const void* value)
+		{
+		SegmentFile segment(getSegmentPath(location.segment), true);
+
+		segment.seek(location.offset);
+		if(fwrite(value, 1, location.length, segment.file) != location.length ||
+		   fflush(segment.file) != 0 ||
+		   FileSynchronization::synchronize(segment.file) != 0)
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, errno);
+		}
+
+	void BerkeleyBlobStore::readSegment(const Location& location, void* value)
+		{
+		SegmentFile segment(getSegmentPath(location.segment), false);
+
+		segment.seek(location.offset);
+		if(fread(value, 1, location.length, segment.file) != location.length)
+			throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR, errno);
+		}
+
+	const path BerkeleyBlobStore::getSegmentPath(const uint32_t segment) const
+		{ return home / ("blobs." + boost::lexical_cast<string>(segment)); }
+
+	const path BerkeleyBlobStore::getHome(DbEnv& environment)
+		{
+		const char* home;
+		environment.get_home(&home);
+		return path(home);
+		}
+
+	BerkeleyBlobStore::Reference BerkeleyBlobStore::makeReference(const uint64_t id)
+		{
+		Reference reference(referenceSize);
+		reference[0] = referenceMarker;
+		toKey(id, &reference[1]);
+		return reference;
+		}
+
+	uint64_t BerkeleyBlobStore::getId(const void* reference)
+		{ return fromKey(static_cast<const unsigned char*>(reference) + 1); }
+
+	void BerkeleyBlobStore::toKey(const uint64_t id, unsigned char* key)
+		{
+		for(size_t index = 0; index < sizeof(uint64_t); index++)
+			key[index] = static_cast<unsigned char>(id >> ((sizeof(uint64_t) - index - 1) * 8));
+		}
+
+	uint64_t BerkeleyBlobStore::fromKey(const unsigned char* key)
+		{
+		uint64_t id = 0;
+
+		for(size_t index = 0; index < sizeof(uint64_t); index++)
+			id = (id << 8) | key[index];
+		return id;
+		}
+
+	set<uint32_t> BerkeleyBlobStore::toSegments(const Dbt& value)
+		{
+		std::vector<uint32_t> segments(value.get_size() / sizeof(uint32_t));
+
+		if(value.get_size() % sizeof(uint32_t) != 0)
+			throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+		else if(!segments.empty())
+			memcpy(&segments[0], value.get_data(), value.get_size());
+		return set<uint32_t>(segments.begin(), segments.end());
+		}
+
+	BerkeleyBlobStore::Location BerkeleyBlobStore::toLocation(const Dbt& value)
+		{
+		Location location;
+
+		// Catalog values are not necessarily aligned
+		if(value.get_size() != sizeof(location))
+			throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+		memcpy(&location, value.get_data(), sizeof(location));
+		return location;
+		}
+	}
+}
+}
+}
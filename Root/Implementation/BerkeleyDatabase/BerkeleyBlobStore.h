@@ -0,0 +1,136 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYBLOBSTORE_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYBLOBSTORE_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
+#include <db_cxx.h>
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+
+	class Data;
+
+	namespace BerkeleyDB {
+
+		///<summary>
+		/// This class stores large values outside of the btree.  Values above a size threshold are appended
+		/// to a set of per-database segment files (which are not written to the log), and the object store
+		/// instead records a small reference to the value.  A transactional catalog maps each reference to
+		/// the current location of its value; releasing a reference (on delete or overwrite) removes its
+		/// catalog entry in the same transaction, and the space is reclaimed by a later compaction.
+		///
+		/// Compaction copies the live values of a sparse segment forward and retires the segment.  A retired segment
+		/// is removed by a later compaction, and only once the catalog no longer refers to it; a reader (in this
+		/// process or another) that still holds one of its locations finds it gone and looks the value up again.
+		///
+		/// Values are written and synchronized to disk before their reference is inserted, so a committed
+		/// reference always refers to durable data.  Space from aborted writes is reclaimed like any other
+		/// unreferenced space.
+		///</summary>
+		class BerkeleyBlobStore
+			{
+			public:
+				// The encoded form of a reference, as stored in place of a large value
+				typedef std::vector<unsigned char> Reference;
+
+				BerkeleyBlobStore(DbEnv& environment, const std::string& name, const size_t threshold);
+				~BerkeleyBlobStore(void);
+
+				// Determines whether the given value should be stored outside of the btree
+				bool isLarge(const Data& data) const;
+				// Determines whether the given stored value is a reference to a large value
+				static bool isReference(const Dbt& value);
+
+				// Writes the given value to a segment file, records it in the catalog and returns its reference
+				Reference write(const Data& data, DbTxn* transaction);
+				// Reads the value associated with the given reference
+				Data read(const Dbt& reference, DbTxn* transaction);
+				// Releases the value associated with the given reference
+				void release(const Reference& reference, DbTxn* transaction);
+				// Releases every large value referenced by the given database (used before it is removed)
+				void releaseAll(Db& database, DbTxn* transaction);
+
+				// Gets the reference (if any) stored under the given key, without reading the entire value
+				static boost::optional<Reference> getReference(Db& database, const Dbt& key, DbTxn* transaction);
+				// Gets the reference (if any) stored at the current position of the given cursor
+				static boost::optional<Reference> getReference(Dbc* cursor);
+
+				// Removes the retired segments to which the catalog no longer refers, then copies the live values of one
+				// sparsely-populated segment forward and retires it.  Returns whether another segment remains to be compacted.
+				bool compact();
+				void close();
+
+			private:
+				// The location of a value within the segment files
+				struct Location
+					{
+					boost::uint32_t segment;
+					boost::uint32_t offset;
+					boost::uint32_t length;
+					};
+
+				// The catalog of references to their current locations
+				Db catalog;
+				const boost::filesystem::path home;
+				const size_t threshold;
+				volatile bool isOpen;
+
+				// Locations written or read by this instance.  Secondary key generation may need to read a value
+				// whose catalog entry is locked by the very transaction performing the write, so we keep these
+				// (immutable) locations available without consulting the catalog.
+				std::map<boost::uint64_t, Location> locations;
+				boost::mutex synchronization;
+
+				// Segments are rolled over once they reach this size
+				static const boost::uint32_t segmentSize;
+				// Number of cached locations retained before the cache is cleared
+				static const size_t maximumCachedLocations;
+				// First byte of a stored reference; never a valid ECMAType
+				static const unsigned char referenceMarker;
+				static const size_t referenceSize;
+				// Catalog key under which the next free location is recorded
+				static const boost::uint64_t tailKey;
+				// Catalog key under which the segments retired by compaction (but not yet removed) are recorded
+				static const boost::uint64_t retiredKey;
+
+				// Reserves space for a value of the given length (in its own transaction, so that concurrent writers
+				// in other processes do not overlap)
+				Location allocate(const boost::uint32_t length);
+				Location find(const boost::uint64_t id, DbTxn* transaction);
+				void cache(const boost::uint64_t id, const Location& location);
+				void uncache(const boost::uint64_t id);
+				// Adds and removes the given segments from those recorded as retired
+				void updateRetired(const std::set<boost::uint32_t>& added, const std::set<boost::uint32_t>& removed, DbTxn* transaction);
+				static std::set<boost::uint32_t> toSegments(const Dbt& value);
+
+				void writeSegment(const Location& location, const void* value);
+				void readSegment(const Location& location, void* value);
+				const boost::filesystem::path getSegmentPath(const boost::uint32_t segment) const;
+				static const boost::filesystem::path getHome(DbEnv& environment);
+
+				// Utility methods to convert between identifiers, references and (big-endian) catalog keys
+				static Reference makeReference(const boost::uint64_t id);
+				static boost::uint64_t getId(const void* reference);
+				static void toKey(const boost::uint64_t id, unsigned char* key);
+				static boost::uint64_t fromKey(const unsigned char* key);
+				static Location toLocation(const Dbt& value);
+			};
+		}
+	}
+}
+}
+
+#endif
@@ -0,0 +1,140 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <cstdlib>
+#include <algorithm>
+#include <boost/bind.hpp>
+#include "BerkeleyCacheTuning.h"
+
+using boost::mutex;
+using boost::lock_guard;
+using boost::unique_lock;
+using boost::optional;
+using boost::uint32_t;
+using boost::uint64_t;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	const uint64_t BerkeleyCacheTuning::minimumAccesses = 1000;
+	const double BerkeleyCacheTuning::minimumHitRate = 0.95;
+
+	BerkeleyCacheTuning::BerkeleyCacheTuning(DbEnv& environment, const uint64_t budget, const int millisecondsBetweenTuning)
+		: environment(environment), budget(budget), millisecondsBetweenTuning(millisecondsBetweenTuning),
+		  floor(0), hits(0), misses(0), evictions(0), isRunning(false)
+		{ }
+
+	BerkeleyCacheTuning::~BerkeleyCacheTuning()
+		{ stop(); }
+
+	void BerkeleyCacheTuning::start()
+		{
+		lock_guard<mutex> guard(synchronized);
+
+		if(!isRunning)
+			{
+			DB_MPOOL_STAT* statistics;
+
+			// The first interval is measured from the statistics as they stand now
+			floor = getCacheSize();
+			environment.memp_stat(&statistics, NULL, 0);
+			hits = statistics->st_cache_hit;
+			misses = statistics->st_cache_miss;
+			evictions = statistics->st_ro_evict + statistics->st_rw_evict;
+			free(statistics);
+
+			isRunning = true;
+			tuningThread = std::auto_ptr<boost::thread>(new boost::thread(boost::bind(
+				&BerkeleyCacheTuning::tuneCache, this)));
+			}
+		}
+
+	void BerkeleyCacheTuning::stop()
+		{
+			{
+			lock_guard<mutex> guard(synchronized);
+			if(!isRunning)
+				return;
+
+			isRunning = false;
+			stopped.notify_all();
+			}
+
+		tuningThread->join();
+		}
+
+	void BerkeleyCacheTuning::tuneCache()
+		{
+		unique_lock<mutex> lock(synchronized);
+
+		// Automatically terminate whenever the isRunning flag is cleared (which also cuts short our wait)
+		while(isRunning)
+			{
+			stopped.timed_wait(lock, boost::posix_time::milliseconds(millisecondsBetweenTuning));
+
+			if(isRunning)
+				try
+					{ tune(); }
+				// A failed sample is simply skipped; the next may well succeed
+				catch(DbException&) { }
+			}
+		}
+
+	void BerkeleyCacheTuning::tune()
+		{
+		DB_MPOOL_STAT* statistics;
+		Sample sample;
+		u_int32_t gigabytes, bytes;
+		int caches;
+
+		environment.memp_stat(&statistics, NULL, 0);
+		sample.hits = statistics->st_cache_hit - hits;
+		sample.misses = statistics->st_cache_miss - misses;
+		sample.evictions = statistics->st_ro_evict + statistics->st_rw_evict - evictions;
+		sample.resident = static_cast<uint64_t>(statistics->st_pages) * statistics->st_pagesize;
+		hits = statistics->st_cache_hit;
+		misses = statistics->st_cache_miss;
+		evictions = statistics->st_ro_evict + statistics->st_rw_evict;
+		free(statistics);
+
+		optional<uint64_t> size = chooseCacheSize(sample, getCacheSize(), floor, budget);
+		if(size.is_initialized())
+			{
+			environment.get_cachesize(&gigabytes, &bytes, &caches);
+			environment.set_cachesize(static_cast<u_int32_t>(size.get() >> 30),
+				static_cast<u_int32_t>(size.get() & ((1 << 30) - 1)), caches);
+			}
+		}
+
+	optional<uint64_t> BerkeleyCacheTuning::chooseCacheSize(const Sample& sample, const uint64_t size, const uint64_t floor, const uint64_t budget)
+		{
+		const uint64_t accesses = sample.hits + sample.misses;
+
+		if(accesses < minimumAccesses)
+			return optional<uint64_t>();
+		// Misses without evictions are pages read for the first time, which no larger cache would avoid
+		else if(static_cast<double>(sample.hits) / accesses < minimumHitRate && sample.evictions > 0 && size < budget)
+			return std::min(budget, size * 2);
+		else if(sample.evictions == 0 && sample.resident * 4 < size && size > floor)
+			return std::max(floor, size / 2);
+		else
+			return optional<uint64_t>();
+		}
+
+	uint64_t BerkeleyCacheTuning::getCacheSize()
+		{
+		u_int32_t gigabytes, bytes;
+		int caches;
+
+		environment.get_cachesize(&gigabytes, &bytes, &caches);
+		return (static_cast<uint64_t>(gigabytes) << 30) + bytes;
+		}
+	}
+}
+}
+}
@@ -0,0 +1,87 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYCACHETUNING_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYCACHETUNING_H
+
+#include <memory>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <db_cxx.h>
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	///<summary>
+	/// This class resizes the cache of a Berkeley DB environment, within a memory budget, to suit the way in
+	/// which it is used.  On an interval it samples the cache statistics: a cache that misses often while
+	/// evicting pages is too small for the working set, and is doubled; a cache that evicts nothing while
+	/// holding far fewer pages than it has room for is larger than the working set, and is halved (though never
+	/// below the size with which tuning began).  Unlike timeout detection (see BerkeleyDeadlockDetection), it runs on a thread of its own
+	/// and is managed by BerkeleyEnvironmentServices.  This class is RAII.
+	///</summary>
+	class BerkeleyCacheTuning
+		{
+		public:
+			// Create a tuning thread for the given environment; the cache is never grown beyond the given budget (in bytes)
+			BerkeleyCacheTuning(DbEnv& environment, const boost::uint64_t budget, const int millisecondsBetweenTuning);
+			~BerkeleyCacheTuning();
+
+			// Start (or conclude) tuning on this thread
+			void start();
+			void stop();
+
+			// The statistics sampled over an interval
+			struct Sample
+				{
+				boost::uint64_t hits;
+				boost::uint64_t misses;
+				boost::uint64_t evictions;
+				// The size (in bytes) of the pages held in the cache
+				boost::uint64_t resident;
+				};
+
+			// Chooses the new size of a cache of the given size (and that may not shrink below the given floor), or
+			// none if the cache should be left as it is
+			static boost::optional<boost::uint64_t> chooseCacheSize(const Sample& sample, const boost::uint64_t size, const boost::uint64_t floor, const boost::uint64_t budget);
+
+		private:
+			DbEnv& environment;
+			const boost::uint64_t budget;
+			const int millisecondsBetweenTuning;
+			// The size of the cache when tuning began
+			boost::uint64_t floor;
+			// The cumulative statistics at the previous sample
+			boost::uint64_t hits;
+			boost::uint64_t misses;
+			boost::uint64_t evictions;
+
+			std::auto_ptr<boost::thread> tuningThread;
+			boost::mutex synchronized;
+			boost::condition_variable stopped;
+			volatile bool isRunning;
+
+			// Below this many cache accesses in an interval, a sample says too little to act upon
+			static const boost::uint64_t minimumAccesses;
+			// A cache with a hit rate below this (as a fraction of accesses) is a candidate for growth
+			static const double minimumHitRate;
+
+			// Method fired once every interval; samples the cache statistics, and resizes the cache if warranted
+			void tuneCache();
+			void tune();
+			boost::uint64_t getCacheSize();
+		};
+	}
+}
+}
+}
+
+#endif
@@ -0,0 +1,127 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <cstdlib>
+#include <boost/bind.hpp>
+#include "BerkeleyCheckpointing.h"
+
+using boost::mutex;
+using boost::lock_guard;
+using boost::unique_lock;
+using boost::optional;
+using boost::posix_time::ptime;
+using boost::posix_time::microsec_clock;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	const int BerkeleyCheckpointing::millisecondsBetweenChecks = 1000;
+
+	BerkeleyCheckpointing::BerkeleyCheckpointing(DbEnv& environment, const u_int32_t kilobytesBetweenCheckpoints, const int millisecondsBetweenCheckpoints)
+		: environment(environment), kilobytesBetweenCheckpoints(kilobytesBetweenCheckpoints),
+		  millisecondsBetweenCheckpoints(millisecondsBetweenCheckpoints), isRunning(false)
+		{ }
+
+	BerkeleyCheckpointing::~BerkeleyCheckpointing()
+		{ stop(); }
+
+	void BerkeleyCheckpointing::start()
+		{
+		lock_guard<mutex> guard(synchronized);
+
+		if(!isRunning)
+			{
+			lastCheckpointTime = microsec_clock::universal_time();
+			lastCheckpoint = getLastCheckpoint(environment);
+
+			isRunning = true;
+			checkpointingThread = std::auto_ptr<boost::thread>(new boost::thread(boost::bind(
+				&BerkeleyCheckpointing::checkpointEnvironment, this)));
+			}
+		}
+
+	void BerkeleyCheckpointing::stop()
+		{
+			{
+			lock_guard<mutex> guard(synchronized);
+			if(!isRunning)
+				return;
+
+			isRunning = false;
+			stopped.notify_all();
+			}
+
+		checkpointingThread->join();
+		}
+
+	void BerkeleyCheckpointing::checkpointEnvironment()
+		{
+		unique_lock<mutex> lock(synchronized);
+
+		// Automatically terminate whenever the isRunning flag is cleared (which also cuts short our wait)
+		while(isRunning)
+			{
+			stopped.timed_wait(lock, boost::posix_time::milliseconds(millisecondsBetweenChecks));
+
+			if(isRunning)
+				try
+					{ checkpointIfDue(); }
+				// A failed checkpoint is simply retried; the log it would have truncated is kept until then
+				catch(DbException&) { }
+			}
+		}
+
+	void BerkeleyCheckpointing::checkpointIfDue()
+		{
+		const ptime now = microsec_clock::universal_time();
+
+		// Berkeley DB skips a checkpoint when too little log has been written since the last (or none at all,
+		// once the time has passed)
+		if(now - lastCheckpointTime >= boost::posix_time::milliseconds(millisecondsBetweenCheckpoints))
+			environment.txn_checkpoint(0, 0, 0);
+		else
+			environment.txn_checkpoint(kilobytesBetweenCheckpoints, 0, 0);
+
+		const optional<DB_LSN> checkpoint = getLastCheckpoint(environment);
+		if(!isEqual(checkpoint, lastCheckpoint))
+			{
+			lastCheckpointTime = now;
+			lastCheckpoint = checkpoint;
+			environment.log_archive(NULL, DB_ARCH_REMOVE);
+			}
+		}
+
+	void BerkeleyCheckpointing::checkpoint(DbEnv& environment)
+		{
+		environment.txn_checkpoint(0, 0, 0);
+		environment.log_archive(NULL, DB_ARCH_REMOVE);
+		}
+
+	optional<DB_LSN> BerkeleyCheckpointing::getLastCheckpoint(DbEnv& environment)
+		{
+		DB_TXN_STAT* statistics;
+
+		environment.txn_stat(&statistics, 0);
+		const DB_LSN checkpoint = statistics->st_last_ckp;
+		free(statistics);
+
+		// Log files are numbered from one, so a zero file indicates that no checkpoint has been taken
+		return checkpoint.file != 0
+			? checkpoint
+			: optional<DB_LSN>();
+		}
+
+	bool BerkeleyCheckpointing::isEqual(const optional<DB_LSN>& left, const optional<DB_LSN>& right)
+		{
+		return left.is_initialized() == right.is_initialized() &&
+			(!left.is_initialized() || (left->file == right->file && left->offset == right->offset));
+		}
+	}
+}
+}
+}
@@ -0,0 +1,72 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYCHECKPOINTING_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYCHECKPOINTING_H
+
+#include <memory>
+#include <boost/optional.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <db_cxx.h>
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	///<summary>
+	/// This class checkpoints a Berkeley DB environment, so that recovery after a failure need only replay the
+	/// log written since.  A checkpoint is taken once a given volume of log has been written, or once a given time
+	/// has passed with any log written at all; afterward, log files no longer needed for recovery are removed.
+	/// Like BerkeleyCacheTuning, it runs on a thread of its own and is managed by BerkeleyEnvironmentServices.  This class
+	/// is RAII.
+	///</summary>
+	class BerkeleyCheckpointing
+		{
+		public:
+			// Create a checkpointing thread for the given environment
+			BerkeleyCheckpointing(DbEnv& environment, const u_int32_t kilobytesBetweenCheckpoints, const int millisecondsBetweenCheckpoints);
+			~BerkeleyCheckpointing();
+
+			// Start (or conclude) checkpointing on this thread
+			void start();
+			void stop();
+
+			// Takes a checkpoint (if any log has been written since the last) and removes obsolete log files
+			static void checkpoint(DbEnv& environment);
+			// Gets the position in the log of the most recent checkpoint, if one has been taken
+			static boost::optional<DB_LSN> getLastCheckpoint(DbEnv& environment);
+
+		private:
+			DbEnv& environment;
+			const u_int32_t kilobytesBetweenCheckpoints;
+			const int millisecondsBetweenCheckpoints;
+			// When (and where in the log) the most recent checkpoint was taken
+			boost::posix_time::ptime lastCheckpointTime;
+			boost::optional<DB_LSN> lastCheckpoint;
+
+			std::auto_ptr<boost::thread> checkpointingThread;
+			boost::mutex synchronized;
+			boost::condition_variable stopped;
+			volatile bool isRunning;
+
+			// The log volume is checked on this interval (in milliseconds)
+			static const int millisecondsBetweenChecks;
+
+			// Method fired once every interval; takes a checkpoint if one is due
+			void checkpointEnvironment();
+			void checkpointIfDue();
+			static bool isEqual(const boost::optional<DB_LSN>& left, const boost::optional<DB_LSN>& right);
+		};
+	}
+}
+}
+}
+
+#endif
@@ -0,0 +1,290 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <set>
+#include <algorithm>
+#include <zlib.h>
+#include <boost/lexical_cast.hpp>
+#include "BerkeleyCompression.h"
+#include "BerkeleyDatabase.h"
+#include "../Key.h"
+#include "../Data.h"
+#include "../ImplementationException.h"
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+using std::pair;
+using boost::mutex;
+using boost::lock_guard;
+using boost::optional;
+using boost::uint32_t;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	const unsigned char BerkeleyCompression::compressedMarker = 0xFE;
+	const size_t BerkeleyCompression::headerSize = 1 + 2 * sizeof(uint32_t);
+	const size_t BerkeleyCompression::minimumSize = 64;
+	// Deflate cannot refer further back than its 32KB window, so a larger dictionary would be wasted
+	const size_t BerkeleyCompression::maximumDictionarySize = 32 * 1024;
+	const size_t BerkeleyCompression::maximumSampleSize = 4 * 1024;
+	const size_t BerkeleyCompression::fragmentLength = 8;
+
+	BerkeleyCompression::BerkeleyCompression(Db& metadata)
+		: metadata(metadata)
+		{ }
+
+	BerkeleyCompression::DictionaryId BerkeleyCompression::train(const vector<Data>& samples, DbTxn* transaction)
+		{
+		map<string, size_t> frequencies;
+		map<string, size_t> segments;
+		// A fragment is considered common if it appears in at least this many samples
+		const size_t minimumFrequency = std::max<size_t>(2, samples.size() / 10);
+
+		// Count the number of samples in which each fragment appears
+		for(vector<Data>::const_iterator sample = samples.begin(); sample != samples.end(); sample++)
+			{
+			const char* value = static_cast<const char*>(static_cast<const void*>(*sample));
+			const size_t size = std::min(sample->getSize(), maximumSampleSize);
+			set<string> fragments;
+
+			for(size_t index = 0; index + fragmentLength <= size; index++)
+				fragments.insert(string(value + index, fragmentLength));
+			for(set<string>::const_iterator fragment = fragments.begin(); fragment != fragments.end(); fragment++)
+				frequencies[*fragment]++;
+			}
+
+		// Merge overlapping runs of common fragments into segments, scored by the frequency of their fragments
+		for(vector<Data>::const_iterator sample = samples.begin(); sample != samples.end(); sample++)
+			{
+			const char* value = static_cast<const char*>(static_cast<const void*>(*sample));
+			const size_t size = std::min(sample->getSize(), maximumSampleSize);
+			size_t start = 0, score = 0;
+
+			for(size_t index = 0; index + fragmentLength <= size + 1; index++)
+				{
+				size_t frequency = index + fragmentLength <= size ? frequencies[string(value + index, fragmentLength)] : 0;
+
+				if(frequency >= minimumFrequency)
+					{
+					if(score == 0)
+						start = index;
+					score += frequency;
+					}
+				else if(score > 0)
+					{
+					size_t& existing = segments[string(value + start, index - 1 + fragmentLength - start)];
+					existing = std::max(existing, score);
+					score = 0;
+					}
+				}
+			}
+
+		// Zlib finds matches near the end of a dictionary most cheaply, so the most valuable segments are placed last
+		vector<pair<size_t, string> > ranked;
+		for(map<string, size_t>::const_iterator segment = segments.begin(); segment != segments.end(); segment++)
+			ranked.push_back(std::make_pair(segment->second, segment->first));
+		std::sort(ranked.rbegin(), ranked.rend());
+
+		string contents;
+		for(vector<pair<size_t, string> >::const_iterator segment = ranked.begin(); segment != ranked.end(); segment++)
+			if(contents.size() + segment->second.size() <= maximumDictionarySize && contents.find(segment->second) == string::npos)
+				contents.insert(0, segment->second);
+
+		if(contents.empty())
+			throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+
+		Dictionary dictionary(new vector<unsigned char>(contents.begin(), contents.end()));
+		DictionaryId id = crc32(0, &(*dictionary)[0], static_cast<uInt>(dictionary->size()));
+
+		try
+			{
+			// Another store's dictionary may share our checksum; it is never overwritten, so we either reuse it (when
+			// it is identical to ours) or probe for the next free identifier
+			while(metadata.put(transaction, &BerkeleyDatabase::ToDbt(Key(getDictionaryKey(id))),
+					&BerkeleyDatabase::ToDbt(Data(&(*dictionary)[0], dictionary->size(), Data::Binary)), DB_NOOVERWRITE) == DB_KEYEXIST)
+				if(*load(id, transaction) == *dictionary)
+					return id;
+				else
+					id++;
+			}
+		catch(DbDeadlockException& e)
+			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+
+		lock_guard<mutex> guard(synchronization);
+		dictionaries[id] = dictionary;
+		return id;
+		}
+
+	void BerkeleyCompression::setDictionary(const string& objectStoreName, const DictionaryId dictionary, DbTxn* transaction)
+		{
+		try
+			{ metadata.put(transaction, &BerkeleyDatabase::ToDbt(Key(getObjectStoreKey(objectStoreName))),
+				&BerkeleyDatabase::ToDbt(Data(&dictionary, sizeof(dictionary), Data::Integer)), 0); }
+		catch(DbDeadlockException& e)
+			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		}
+
+	optional<BerkeleyCompression::DictionaryId> BerkeleyCompression::getDictionary(const string& objectStoreName, DbTxn* transaction)
+		{
+		BerkeleyDatabase::ReturnedDbt value;
+
+		try
+			{
+			if(metadata.get(transaction, &BerkeleyDatabase::ToDbt(Key(getObjectStoreKey(objectStoreName))), &value, 0) == 0 &&
+					value.get_size() == 1 + sizeof(DictionaryId))
+				{
+				DictionaryId dictionary;
+				memcpy(&dictionary, static_cast<unsigned char*>(value.get_data()) + 1, sizeof(dictionary));
+				return dictionary;
+				}
+			else
+				return optional<DictionaryId>();
+			}
+		catch(DbDeadlockException& e)
+			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		}
+
+	void BerkeleyCompression::removeDictionary(const string& objectStoreName, DbTxn* transaction)
+		{
+		try
+			{ metadata.del(transaction, &BerkeleyDatabase::ToDbt(Key(getObjectStoreKey(objectStoreName))), 0); }
+		catch(DbDeadlockException& e)
+			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		}
+
+	bool BerkeleyCompression::compress(const Data& data, const DictionaryId dictionary, vector<unsigned char>& result, DbTxn* transaction)
+		{
+		if(data.getSize() < minimumSize)
+			return false;
+
+		Dictionary contents = load(dictionary, transaction);
+		vector<unsigned char> compressed;
+		z_stream stream;
+		int status;
+
+		memset(&stream, 0, sizeof(stream));
+		if(deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR);
+
+		compressed.push_back(compressedMarker);
+		appendBigEndian(compressed, dictionary);
+		appendBigEndian(compressed, static_cast<uint32_t>(data.getSize()));
+		compressed.resize(headerSize + deflateBound(&stream, static_cast<uLong>(data.getSize())));
+
+		stream.next_in = static_cast<Bytef*>(const_cast<void*>(static_cast<const void*>(data)));
+		stream.avail_in = static_cast<uInt>(data.getSize());
+		stream.next_out = &compressed[headerSize];
+		stream.avail_out = static_cast<uInt>(compressed.size() - headerSize);
+
+		if((status = deflateSetDictionary(&stream, &(*contents)[0], static_cast<uInt>(contents->size()))) == Z_OK)
+			status = deflate(&stream, Z_FINISH);
+		deflateEnd(&stream);
+
+		if(status != Z_STREAM_END)
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, status);
+		else if(headerSize + stream.total_out >= data.getSize())
+			return false;
+
+		compressed.resize(headerSize + stream.total_out);
+		result.swap(compressed);
+		return true;
+		}
+
+	bool BerkeleyCompression::isCompressed(const void* value, const size_t size)
+		{ return size > headerSize && *static_cast<const unsigned char*>(value) == compressedMarker; }
+
+	Data BerkeleyCompression::decompress(const void* value, const size_t size, DbTxn* transaction)
+		{
+		const unsigned char* header = static_cast<const unsigned char*>(value);
+
+		if(!isCompressed(value, size))
+			throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+
+		Dictionary contents = load(readBigEndian(header + 1), transaction);
+		vector<unsigned char> decompressed(readBigEndian(header + 1 + sizeof(uint32_t)));
+		z_stream stream;
+		int status;
+
+		memset(&stream, 0, sizeof(stream));
+		stream.next_in = const_cast<Bytef*>(header + headerSize);
+		stream.avail_in = static_cast<uInt>(size - headerSize);
+		if(inflateInit(&stream) != Z_OK)
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR);
+
+		stream.next_out = decompressed.empty() ? NULL : &decompressed[0];
+		stream.avail_out = static_cast<uInt>(decompressed.size());
+
+		// The stream requests its preset dictionary before producing any output
+		if((status = inflate(&stream, Z_FINISH)) == Z_NEED_DICT &&
+				(status = inflateSetDictionary(&stream, &(*contents)[0], static_cast<uInt>(contents->size()))) == Z_OK)
+			status = inflate(&stream, Z_FINISH);
+		inflateEnd(&stream);
+
+		if(status != Z_STREAM_END || stream.total_out != decompressed.size() || decompressed.empty())
+			throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR, status);
+
+		return Data(decompressed);
+		}
+
+	BerkeleyCompression::Dictionary BerkeleyCompression::load(const DictionaryId dictionary, DbTxn* transaction)
+		{
+			{
+			lock_guard<mutex> guard(synchronization);
+			map<DictionaryId, Dictionary>::const_iterator cached = dictionaries.find(dictionary);
+			if(cached != dictionaries.end())
+				return cached->second;
+			}
+
+		BerkeleyDatabase::ReturnedDbt value;
+
+		try
+			{
+			if(metadata.get(transaction, &BerkeleyDatabase::ToDbt(Key(getDictionaryKey(dictionary))), &value, 0) != 0 || value.get_size() <= 1)
+				throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+			}
+		catch(DbDeadlockException& e)
+			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+
+		const unsigned char* contents = static_cast<unsigned char*>(value.get_data()) + 1;
+		Dictionary loaded(new vector<unsigned char>(contents, contents + value.get_size() - 1));
+
+		lock_guard<mutex> guard(synchronization);
+		return dictionaries[dictionary] = loaded;
+		}
+
+	const string BerkeleyCompression::getDictionaryKey(const DictionaryId dictionary)
+		{ return "__dictionary:" + boost::lexical_cast<string>(dictionary); }
+
+	const string BerkeleyCompression::getObjectStoreKey(const string& objectStoreName)
+		{ return "__compression:" + objectStoreName; }
+
+	void BerkeleyCompression::appendBigEndian(vector<unsigned char>& buffer, const uint32_t value)
+		{
+		for(size_t index = sizeof(value); index > 0; index--)
+			buffer.push_back(static_cast<unsigned char>(value >> ((index - 1) * 8)));
+		}
+
+	uint32_t BerkeleyCompression::readBigEndian(const unsigned char* position)
+		{ return (position[0] << 24) | (position[1] << 16) | (position[2] << 8) | position[3]; }
+	}
+}
+}
+}
@@ -0,0 +1,97 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYCOMPRESSION_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYCOMPRESSION_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <db_cxx.h>
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+
+	class Data;
+
+	namespace BerkeleyDB {
+
+		///<summary>
+		/// This class compresses stored values using (zlib) dictionaries trained from a sample of the values
+		/// in an object store.  Stored objects tend to share most of their text (e.g. property names), which
+		/// a general-purpose compressor cannot exploit in a single small value; a preset dictionary built from
+		/// the fragments common to many values allows even short values to be compressed well.
+		///
+		/// Dictionaries are immutable and identified by a checksum of their contents (or, should that checksum
+		/// already identify a different dictionary, by the next free identifier after it).  They are recorded in
+		/// the database metadata, along with the dictionary (if any) associated with each object store.  A
+		/// compressed value is self-describing (it carries its dictionary identifier and uncompressed size),
+		/// so values may be decompressed without knowledge of the object store that contains them.
+		///</summary>
+		class BerkeleyCompression
+			{
+			public:
+				typedef boost::uint32_t DictionaryId;
+
+				explicit BerkeleyCompression(Db& metadata);
+
+				// Trains a dictionary from the given sample values, records it in the metadata and returns its identifier
+				DictionaryId train(const std::vector<Data>& samples, DbTxn* transaction);
+
+				// Associates a dictionary with the given object store
+				void setDictionary(const std::string& objectStoreName, const DictionaryId dictionary, DbTxn* transaction);
+				// Gets the dictionary (if any) associated with the given object store
+				boost::optional<DictionaryId> getDictionary(const std::string& objectStoreName, DbTxn* transaction);
+				// Removes the association between an object store and its dictionary
+				void removeDictionary(const std::string& objectStoreName, DbTxn* transaction);
+
+				// Compresses the given value; returns false (leaving the result untouched) if this would not reduce its size
+				bool compress(const Data& data, const DictionaryId dictionary, std::vector<unsigned char>& result, DbTxn* transaction);
+				// Determines whether the given stored value is compressed
+				static bool isCompressed(const void* value, const size_t size);
+				// Decompresses the given stored value
+				Data decompress(const void* value, const size_t size, DbTxn* transaction);
+
+			private:
+				typedef boost::shared_ptr<const std::vector<unsigned char> > Dictionary;
+
+				// The metadata database in which dictionaries and associations are recorded
+				Db& metadata;
+
+				// Dictionaries are immutable, so we cache those we have loaded (decompression may occur during
+				// secondary key generation, where we cannot safely read the metadata in the caller's transaction)
+				std::map<DictionaryId, Dictionary> dictionaries;
+				boost::mutex synchronization;
+
+				// First byte of a compressed value; never a valid ECMAType
+				static const unsigned char compressedMarker;
+				// Size of the header preceding the compressed stream (marker, dictionary and uncompressed size)
+				static const size_t headerSize;
+				// Values smaller than this are never compressed
+				static const size_t minimumSize;
+				// Limits used when training a dictionary
+				static const size_t maximumDictionarySize;
+				static const size_t maximumSampleSize;
+				static const size_t fragmentLength;
+
+				Dictionary load(const DictionaryId dictionary, DbTxn* transaction);
+
+				static const std::string getDictionaryKey(const DictionaryId dictionary);
+				static const std::string getObjectStoreKey(const std::string& objectStoreName);
+				static void appendBigEndian(std::vector<unsigned char>& buffer, const boost::uint32_t value);
+				static boost::uint32_t readBigEndian(const unsigned char* position);
+			};
+		}
+	}
+}
+}
+
+#endif
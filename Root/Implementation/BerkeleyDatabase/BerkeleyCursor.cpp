@@ -9,21 +9,24 @@ GNU Lesser General Public License
 #include "BerkeleyCursor.h"
 #include "BerkeleyDatabase.h"
 #include "BerkeleyTransaction.h"
+#include "BerkeleyBlobStore.h"
 #include "..\Key.h"
 #include "..\Data.h"
 #include "..\ImplementationException.h"
 
 using boost::mutex;
 using boost::lock_guard;
+using boost::optional;
 
 namespace BrandonHaynes {
 namespace IndexedDB { 
 namespace Implementation { 
 namespace BerkeleyDB
 	{
-	BerkeleyCursor::BerkeleyCursor(Db& source, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, TransactionContext& transactionContext)
+	BerkeleyCursor::BerkeleyCursor(Db& source, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool readOnly, const Isolation isolation, TransactionContext& transactionContext)
 		: Cursor(left, right, openLeft, openRight, isReversed, omitDuplicates),
-		  cursor(makeCursor(source, transactionContext)),
+		  database(BerkeleyDatabase::FromEnvironment(source.get_env())),
+		  cursor(makeCursor(source, readOnly, isolation, transactionContext)),
 		  isOpen(true)
 		{
 		try
@@ -76,7 +79,7 @@ namespace BerkeleyDB
 			if(!isOpen)
 				throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
 			else if((result = cursor->get(&key, &data, DB_CURRENT)) == 0)
-				return BerkeleyDatabase::ToData(data);
+				return database.resolveData(data, transaction);
 			else if(result == DB_KEYEMPTY)
 				return Key::getUndefinedKey();
 			else
@@ -182,11 +185,18 @@ namespace BerkeleyDB
 		int result;
 
 		ensureOpen();
+		// Writes to a transactional database must be made in a transaction, which a read-only cursor may not have
+		if(transaction == NULL)
+			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
 
 		try
 			{
+			optional<BerkeleyBlobStore::Reference> existing = BerkeleyBlobStore::getReference(cursor);
+
 			if((result = cursor->del(0)) != 0)
 				throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, result);
+			else if(existing.is_initialized())
+				database.getBlobStore().release(existing.get(), transaction);
 			}
 		catch(DbDeadlockException& e)
 			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
@@ -348,22 +358,31 @@ namespace BerkeleyDB
 						: right < key);
 		}
 
-	Dbc* BerkeleyCursor::makeCursor(Db& source, TransactionContext transactionContext)
+	Dbc* BerkeleyCursor::makeCursor(Db& source, const bool readOnly, const Isolation isolation, TransactionContext transactionContext)
 		{
 		DbTxn* transaction;
 		Dbc* cursor;
+		// A read-committed cursor releases the lock on each page as it moves off it, so that a long scan does not
+		// accumulate locks (and block writers) until its transaction ends; a read-uncommitted cursor takes none
+		const u_int32_t flags = isolation == READ_COMMITTED ? DB_READ_COMMITTED
+			: isolation == READ_UNCOMMITTED ? DB_READ_UNCOMMITTED
+			: 0;
 
 		transaction = BerkeleyTransaction::ToDbTxn(transactionContext);
 
-		if(transaction == NULL)
+		// A cursor that cannot write needs no transaction of its own (which would cost us the transaction, and the
+		// locks it holds until it ends); without one, it locks only the page at which it is positioned
+		if(transaction == NULL && !readOnly)
 			{
-			source.get_env()->txn_begin(NULL, &transaction, 0); 
+			// The cursor is the only reader in its implicit transaction, which therefore reads with the same isolation
+			source.get_env()->txn_begin(NULL, &transaction, flags); 
 			this->implicitTransaction = transaction;
 			}
 		else
 			this->implicitTransaction = NULL;
 
-		source.cursor(transaction, &cursor, 0);
+		this->transaction = transaction;
+		source.cursor(transaction, &cursor, flags);
 		return cursor;
 		}
 
@@ -27,11 +27,17 @@ namespace Implementation {
 		
 	namespace BerkeleyDB {
 
+		class BerkeleyDatabase;
+
 		///<summary>
 		/// This abstract class represents a cursor in a Berkeley DB environment.
 		/// In addition to providing default implementations for most methods
 		/// required by the Cursor interface, this class provides helper functions
-		/// useful in derived classes.
+		/// useful in derived classes.  Unlike the database it reads, a cursor is not
+		/// free-threaded: it must be used by one thread at a time.  A cursor that cannot
+		/// write (over a read-only object store) and is opened outside of a transaction
+		/// reads outside of any transaction, with cursor stability, rather than begin one
+		/// of its own.
 		///</summary>
 		class BerkeleyCursor : public Cursor
 		{
@@ -48,13 +54,13 @@ namespace Implementation {
 
 		protected:
 			/// Construct a Berkeley DB-backed cursor with the given (left, right) interval (possibly open on one or both ends)
-			BerkeleyCursor(Db& source, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, TransactionContext& transactionContext);
+			BerkeleyCursor(Db& source, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool readOnly, const Isolation isolation, TransactionContext& transactionContext);
 
 			boost::mutex synchronization;
 
-			/// Initializes a cursor in the given transaction context; if none exists, it creates an implicit
-			/// context (via implicitTransaction)
-			Dbc* makeCursor(Db& source, TransactionContext transactionContext);
+			/// Initializes a cursor with the given isolation in the given transaction context; if none exists, it
+			/// creates an implicit context (via implicitTransaction), unless the cursor is read-only
+			Dbc* makeCursor(Db& source, const bool readOnly, const Isolation isolation, TransactionContext transactionContext);
 			Dbc* getCursor() { return cursor; }
 			/// Helper method to iterate the underlying cursor
 			virtual bool next(Dbc* cursor, TransactionContext& transactionContext);
@@ -62,6 +68,10 @@ namespace Implementation {
 			void ensureOpen();
 
 		private:
+			// The database that owns the cursor's source (used to resolve large values)
+			BerkeleyDatabase& database;
+			// The transaction in which this cursor operates (explicit or implicit; none for a read-only cursor opened outside of one)
+			DbTxn* transaction;
 			// The implict transaction associated with this cursor (none if the cursor was created using an explicit context)
 			DbTxn* implicitTransaction;
 			Dbc* cursor;
@@ -4,16 +4,30 @@ http://code.google.com/p/indexeddb
 GNU Lesser General Public License
 \**********************************************************/
 
+#include <cstdlib>
+#include <boost/lexical_cast.hpp>
 #include "BerkeleyObjectStore.h"
 #include "BerkeleyDatabase.h"
+#include "BerkeleyDatabaseFactory.h"
 #include "BerkeleyTransaction.h"
 #include "BerkeleyDeadlockDetection.h"
+#include "BerkeleyCheckpointing.h"
+#include "BerkeleyEnvironmentServices.h"
+#include "BerkeleyGroupCommit.h"
+#include "BerkeleyBlobStore.h"
+#include "BerkeleyCompression.h"
+#include "BerkeleyFrozenCatalog.h"
 #include "../ImplementationException.h"
 #include "../Key.h"
 #include "../Data.h"
 #include "../../Support/DatabaseLocation.h"
 
+using std::map;
 using std::string;
+using boost::mutex;
+using boost::lock_guard;
+using boost::optional;
+using boost::filesystem::path;
 
 namespace BrandonHaynes {
 namespace IndexedDB { 
@@ -21,57 +35,299 @@ namespace Implementation {
 namespace BerkeleyDB
 	{
 	const string BerkeleyDatabase::metadataDatabaseSuffix = "__metadata";
+	const string BerkeleyDatabase::singleFileSuffix = "__objectStores";
+	const size_t BerkeleyDatabase::largeValueThreshold = 64 * 1024;
+	const u_int32_t BerkeleyDatabase::defaultLogFileSize = 262144;
+	const db_timeout_t BerkeleyDatabase::defaultTimeout = 2500;
+	const db_timeout_t BerkeleyDatabase::defaultScopeTimeout = 10 * 1000 * 1000;
+	const int BerkeleyDatabase::millisecondsBetweenCacheTuning = 10000;
+	const int BerkeleyDatabase::millisecondsBetweenCompactions = 10 * 60 * 1000;
+	const boost::uint64_t BerkeleyDatabase::defaultCacheSize = 256 * 1024;
+	const boost::uint64_t BerkeleyDatabase::defaultVersionCacheSize = 1024 * 1024;
+	const u_int32_t BerkeleyDatabase::defaultCheckpointLogSize = 1024 * 1024;
+	const u_int32_t BerkeleyDatabase::defaultCheckpointInterval = 30 * 1000 * 1000;
+	map<string, int> BerkeleyDatabase::openEnvironments;
+	mutex BerkeleyDatabase::openEnvironmentsSynchronization;
 
-	BerkeleyDatabase::BerkeleyDatabase(const string& origin, const string& name, const string& description, const bool modifyDatabase)
-		: environment(0), name(name), origin(origin),
-		  deadlockDetection(new BerkeleyDeadlockDetection(environment, 3000))
+	BerkeleyDatabase::BerkeleyDatabase(const string& origin, const string& name, const string& description, const bool modifyDatabase, const DatabaseConfiguration& configuration)
+		: environment(0), name(name), origin(origin), configuration(configuration),
+		  deadlockDetection(new BerkeleyDeadlockDetection(environment))
 		{
-		environment.set_lg_max(262144);
+		environment.set_lg_max(configuration.getLogFileSize().get_value_or(defaultLogFileSize));
+		if(configuration.getLogBufferSize().is_initialized())
+			environment.set_lg_bsize(configuration.getLogBufferSize().get());
 		environment.set_flags(DB_AUTO_COMMIT, 1);
-		environment.set_timeout(2500, DB_SET_LOCK_TIMEOUT);
-		environment.set_timeout(2500, DB_SET_TXN_TIMEOUT);
+		environment.set_timeout(configuration.getLockTimeout().get_value_or(defaultTimeout), DB_SET_LOCK_TIMEOUT);
+		environment.set_timeout(configuration.getTransactionTimeout().get_value_or(defaultTimeout), DB_SET_TXN_TIMEOUT);
+		// Deadlocks are broken as soon as a lock request conflicts; timeouts are left to the shared detector
 		environment.set_lk_detect(DB_LOCK_DEFAULT);
 		environment.set_errcall(this->errorHandler);
-		int environmentFlags = DB_CREATE | DB_INIT_LOCK | DB_INIT_MPOOL | DB_INIT_TXN | DB_INIT_LOG;
+		environment.set_app_private(this);
+		// Memory returned through a ReturnedDbt is allocated with our runtime's allocator, since it is our runtime that frees it
+		environment.set_alloc(malloc, realloc, free);
 
-		try 
-			{ 
-			environment.open(DatabaseLocation::getDatabasePath(origin, name).c_str(), environmentFlags, 0); }
-		catch(DbException& e)
-			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		// Where snapshots are enabled, every database is multi-version, so that snapshot reads need not lock; the versions
+		// they read are kept in the cache, which is enlarged accordingly.  Otherwise writes pay nothing for them.
+		if(configuration.getSnapshots())
+			environment.set_flags(DB_MULTIVERSION, 1);
+
+		// The cache size is fixed when the environment is created, so this applies only to a new environment
+		const boost::uint64_t cacheSize = configuration.getCacheSize().get_value_or(defaultCacheSize) + 
+			(configuration.getSnapshots() ? configuration.getVersionCacheSize().get_value_or(defaultVersionCacheSize) : 0);
+		environment.set_cachesize(static_cast<u_int32_t>(cacheSize >> 30), static_cast<u_int32_t>(cacheSize & ((1 << 30) - 1)), 1);
+		// Likewise the budget, which bounds the size to which the cache may later be grown
+		if(configuration.getCacheBudget().is_initialized())
+			environment.set_cache_max(static_cast<u_int32_t>(configuration.getCacheBudget().get() >> 30), 
+				static_cast<u_int32_t>(configuration.getCacheBudget().get() & ((1 << 30) - 1)));
+		if(configuration.getDurability() == DatabaseConfiguration::WRITE_NO_SYNC)
+			environment.set_flags(DB_TXN_WRITE_NOSYNC, 1);
+		else if(configuration.getDurability() == DatabaseConfiguration::NO_SYNC)
+			environment.set_flags(DB_TXN_NOSYNC, 1);
+		// The environment is free-threaded, so that requests executed on worker threads may share it (and its handles).
+		// Recovery replays the log written since the last checkpoint, but it also recreates the environment, so it is
+		// only safe while no other handle (in any process) has the environment open.  Every handle registers itself,
+		// so that Berkeley DB recovers the environment only when it must (on first use, or after a process that had
+		// it open has failed) and then only while no live process has it open.
+		const int environmentFlags = DB_CREATE | DB_INIT_LOCK | DB_INIT_MPOOL | DB_INIT_TXN | DB_INIT_LOG | DB_THREAD | 
+			DB_REGISTER | DB_RECOVER;
+		const string home = DatabaseLocation::getDatabasePath(origin, name);
+
+			{
+			lock_guard<mutex> guard(openEnvironmentsSynchronization);
+
+			try 
+				{ 
+				environment.open(home.c_str(), environmentFlags, 0); }
+			catch(DbException& e)
+				{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+
+			++openEnvironments[home];
+			}
+
+		try
+			{
+			// An existing database keeps the layout with which it was created (its metadata is a file of its own
+			// only in the file-per-object store layout)
+			if(boost::filesystem::exists(path(home) / (name + metadataDatabaseSuffix)))
+				layout = DatabaseConfiguration::FILE_PER_OBJECT_STORE;
+			else if(boost::filesystem::exists(path(home) / (name + singleFileSuffix)))
+				layout = DatabaseConfiguration::SINGLE_FILE;
+			else
+				layout = configuration.getLayout();
 
-		deadlockDetection->start();
+			deadlockDetection->start();
 
-		metadata.reset(new BerkeleyObjectStore(*this, name + metadataDatabaseSuffix, 
-			ObjectStore::READ_WRITE, true, TransactionContext()));
+			blobs.reset(new BerkeleyBlobStore(environment, name, largeValueThreshold));
+			groupCommit.reset(new BerkeleyGroupCommit(environment));
+			scopeLocks = BerkeleyScopeLocks::getInstance(home);
+
+			// Every handle on the environment shares one set of background services (checkpointing, blob compaction and
+			// cache tuning), which run until the last is closed
+			services = BerkeleyEnvironmentServices::getInstance(home, name, configuration.getCacheBudget(), millisecondsBetweenCacheTuning,
+				configuration.getCheckpointLogSize().get_value_or(defaultCheckpointLogSize) / 1024,
+				configuration.getCheckpointInterval().get_value_or(defaultCheckpointInterval) / 1000,
+				millisecondsBetweenCompactions);
+
+			metadata.reset(new BerkeleyObjectStore(*this, name + metadataDatabaseSuffix, 
+				ObjectStore::READ_WRITE, true, TransactionContext()));
+			compression.reset(new BerkeleyCompression(static_cast<BerkeleyObjectStore&>(*metadata).getImplementation()));
+			frozenCatalog.reset(new BerkeleyFrozenCatalog(static_cast<BerkeleyObjectStore&>(*metadata).getImplementation(), home));
+			}
+		catch(...)
+			{
+			// A handle that fails to open releases what it had acquired, so that the environment is neither left
+			// open nor counted as such
+			close();
+			throw;
+			}
 		}
 
 	BerkeleyDatabase::~BerkeleyDatabase()
+		{ close(); }
+
+	void BerkeleyDatabase::close()
 		{ 
 		deadlockDetection->stop();
+		// The services stop here only if this is the last handle to release them
+		services.reset();
+
+		// The catalogs refer to the metadata, and so are released before it is closed
+		frozenCatalog.reset();
+		compression.reset();
 
 		try
-			{ metadata->close(); }
+			{ if(metadata.get() != NULL) metadata->close(); }
 		catch(ImplementationException&) { }
 
+		try
+			{ if(blobs.get() != NULL) blobs->close(); }
+		catch(ImplementationException&) { }
+
+		// The last handle out takes a final checkpoint, so that the next to open the environment has nothing to recover
+		if(registerEnvironment(-1) == 0)
+			try
+				{ BerkeleyCheckpointing::checkpoint(environment); }
+			catch(DbException&) { }
+
 		try
 			{ environment.close(0); }
 		catch(DbDeadlockException&) { }
 		catch(DbException&) { }
 		}
 
+	optional<string> BerkeleyDatabase::getLastCheckpoint()
+		{
+		try
+			{
+			const optional<DB_LSN> checkpoint = BerkeleyCheckpointing::getLastCheckpoint(environment);
+			return checkpoint.is_initialized()
+				? boost::lexical_cast<string>(checkpoint->file) + "/" + boost::lexical_cast<string>(checkpoint->offset)
+				: optional<string>();
+			}
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		}
+
+	void BerkeleyDatabase::checkpoint()
+		{
+		try
+			{ BerkeleyCheckpointing::checkpoint(environment); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		}
+
+	optional<size_t> BerkeleyDatabase::getOpenFileCount()
+		{
+		DB_MPOOL_STAT* statistics;
+		DB_MPOOL_FSTAT** files;
+		size_t count = 0;
+
+		try
+			{ environment.memp_stat(&statistics, &files, 0); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+
+		// The per-file statistics are a null-terminated array
+		if(files != NULL)
+			{
+			while(files[count] != NULL)
+				count++;
+			free(files);
+			}
+		free(statistics);
+
+		return count;
+		}
+
 	void BerkeleyDatabase::removeObjectStore(const string& objectStoreName, TransactionContext& transactionContext)
 		{
-		DbTxn* transaction = BerkeleyTransaction::ToDbTxn(transactionContext);
+		DbTxn* parent = BerkeleyTransaction::ToDbTxn(transactionContext);
+		DbTxn* transaction = NULL;
+		optional<BerkeleyFrozenCatalog::Generation> frozen;
 
-		//TODO: Should be be using sub databases?  Is there any perf difference?
+		DatabaseLocation::ensurePathValid(objectStoreName);
 		try
-			{ getEnvironment().dbremove(transaction, DatabaseLocation::getObjectStorePath(origin, this->name, objectStoreName).c_str(), NULL, 
-				transaction == NULL ? DB_AUTO_COMMIT : 0); }
+			{ 
+			// Large values referenced by the object store are released along with it
+			getEnvironment().txn_begin(parent, &transaction, 0);
+
+			Db objectStore(&getEnvironment(), 0);
+			openDatabase(objectStore, transaction, objectStoreName, DB_UNKNOWN, 0);
+			try
+				{ blobs->releaseAll(objectStore, transaction); }
+			catch(ImplementationException&)
+				{
+				objectStore.close(0);
+				throw;
+				}
+			objectStore.close(0);
+
+			removeDatabase(transaction, objectStoreName, 0);
+			compression->removeDictionary(objectStoreName, transaction);
+			frozen = frozenCatalog->remove(objectStoreName, transaction);
+
+			DbTxn* committing = transaction;
+			transaction = NULL;
+			committing->commit(0);
+			}
 		catch(DbDeadlockException& e)
-			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+			{ 
+			if(transaction != NULL) transaction->abort();
+			throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); 
+			}
 		catch(DbException& e)
-			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+			{ 
+			if(transaction != NULL) transaction->abort();
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); 
+			}
+		catch(ImplementationException&)
+			{
+			if(transaction != NULL) transaction->abort();
+			throw;
+			}
+
+		// The frozen form of the object store (if any) is discarded once the store itself is gone
+		frozenCatalog->release(objectStoreName, frozen);
+		}
+
+	AbstractDatabaseFactory& BerkeleyDatabase::getFactory()
+		{ return AbstractDatabaseFactory::getInstance(BerkeleyDatabaseFactory::engineName); }
+
+	void BerkeleyDatabase::configure(Db& database) const
+		{
+		// As with the cache, the page size is fixed when a database is created (and ignored otherwise)
+		if(configuration.getPageSize().is_initialized())
+			database.set_pagesize(configuration.getPageSize().get());
+		}
+
+	void BerkeleyDatabase::openDatabase(Db& database, DbTxn* transaction, const string& databaseName, const DBTYPE type, const u_int32_t flags) const
+		{
+		// Sub-databases share the file (and so its file handle, and its pages in the cache), which spares us a
+		// file per object store and index; the page size of the file is fixed by the first of them to be created
+		if(layout == DatabaseConfiguration::SINGLE_FILE)
+			database.open(transaction, (name + singleFileSuffix).c_str(), databaseName.c_str(), type, flags | DB_THREAD | DB_READ_UNCOMMITTED, 0);
+		else
+			database.open(transaction, databaseName.c_str(), NULL, type, flags | DB_THREAD | DB_READ_UNCOMMITTED, 0);
+		}
+
+	void BerkeleyDatabase::removeDatabase(DbTxn* transaction, const string& databaseName, const u_int32_t flags)
+		{
+		if(layout == DatabaseConfiguration::SINGLE_FILE)
+			environment.dbremove(transaction, (name + singleFileSuffix).c_str(), databaseName.c_str(), flags);
+		else
+			environment.dbremove(transaction, databaseName.c_str(), NULL, flags);
+		}
+
+	Data BerkeleyDatabase::resolveData(const Dbt& dbt, DbTxn* transaction)
+		{ 
+		if(BerkeleyBlobStore::isReference(dbt))
+			{
+			Data value = blobs->read(dbt, transaction);
+			return BerkeleyCompression::isCompressed(static_cast<const void*>(value), value.getSize())
+				? compression->decompress(static_cast<const void*>(value), value.getSize(), transaction)
+				: value;
+			}
+		else if(BerkeleyCompression::isCompressed(dbt.get_data(), dbt.get_size()))
+			return compression->decompress(dbt.get_data(), dbt.get_size(), transaction);
+		else
+			return ToData(dbt); 
+		}
+
+	std::auto_ptr<BerkeleyScopeLocks::Scope> BerkeleyDatabase::lockScope(const optional<std::vector<string> >& objectStoreNames, const bool exclusive, const optional<unsigned int>& timeout)
+		{
+		const db_timeout_t wait = timeout.is_initialized() 
+			? timeout.get() 
+			: configuration.getScopeTimeout().get_value_or(defaultScopeTimeout);
+		return scopeLocks->lock(objectStoreNames, exclusive, boost::posix_time::microseconds(wait));
+		}
+
+	int BerkeleyDatabase::registerEnvironment(const int delta)
+		{
+		const char* home;
+		environment.get_home(&home);
+
+		lock_guard<mutex> guard(openEnvironmentsSynchronization);
+		return openEnvironments[home] += delta;
 		}
 
 	void BerkeleyDatabase::errorHandler(const DbEnv *environment, const char *errpfx, const char *message)		
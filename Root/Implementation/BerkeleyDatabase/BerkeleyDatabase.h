@@ -7,10 +7,18 @@ GNU Lesser General Public License
 #ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYDATABASE_H
 #define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYDATABASE_H
 
+#include <map>
 #include <string>
+#include <vector>
+#include <cstdlib>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include <db_cxx.h>
 #include "../Database.h"
 #include "../Transaction.h"
+#include "../DatabaseConfiguration.h"
+#include "BerkeleyScopeLocks.h"
 
 namespace BrandonHaynes {
 namespace IndexedDB { 
@@ -23,19 +31,36 @@ namespace Implementation {
 	namespace BerkeleyDB {
 
 		class BerkeleyDeadlockDetection;
+		class BerkeleyEnvironmentServices;
+		class BerkeleyGroupCommit;
+		class BerkeleyBlobStore;
+		class BerkeleyCompression;
+		class BerkeleyFrozenCatalog;
 
 		///<summary>
 		/// This class represents a Indexed Database API database implementation (which is represented, confusingly,
-		/// by a Berkeley DB environment).
+		/// by a Berkeley DB environment).  Object stores and indexes are Berkeley DB databases in the environment,
+		/// each in a file of its own or (with the single file layout) as named sub-databases of one file; the
+		/// layout is chosen when the database is created, and kept thereafter.
+		///
+		/// The environment and every database in it are opened free-threaded, so a database, its object stores and
+		/// its indexes may be used by several threads at once.  Cursors are not: a cursor (and the implicit
+		/// transaction it may have begun) belongs to the thread that opened it.  A transaction may be used by any
+		/// thread, but its commit or abort must not race with operations still running in it.
 		///</summary>
 		class BerkeleyDatabase : public Database
 			{
 			public:
-				BerkeleyDatabase(const std::string& origin, const std::string& name, const std::string& description, const bool modifyDatabase);
+				BerkeleyDatabase(const std::string& origin, const std::string& name, const std::string& description, const bool modifyDatabase, const DatabaseConfiguration& configuration);
 				virtual ~BerkeleyDatabase(void);
 
 				virtual void removeObjectStore(const std::string& objectStoreName, TransactionContext& transactionContext);
 				virtual ObjectStore& getMetadata() { return *metadata; }
+				virtual AbstractDatabaseFactory& getFactory();
+				virtual boost::optional<std::string> getLastCheckpoint();
+				virtual void checkpoint();
+				// The files in the environment's cache, which is shared by every handle on the environment
+				virtual boost::optional<size_t> getOpenFileCount();
 
 				// Utility methods to convert between the implementation-exposing Data/Key objects and underlying
 				// BerkeleyDB Dbts.  Used by most of the other Berkeley DB implementation classes. 
@@ -43,23 +68,113 @@ namespace Implementation {
 				static Data ToData(const Dbt& dbt);
 				static Key ToKey(const Dbt& key);
 
+				///<summary>
+				/// A Dbt into which a database (rather than a cursor) returns a key or value.  A free-threaded handle
+				/// has no memory of its own in which to return data, so Berkeley DB allocates it on behalf of the Dbt
+				/// (reallocating it if the Dbt is reused), and the Dbt frees it when destroyed.
+				///</summary>
+				class ReturnedDbt : public Dbt
+					{
+					public:
+						ReturnedDbt() { set_flags(DB_DBT_REALLOC); }
+						~ReturnedDbt() { free(get_data()); }
+
+					private:
+						ReturnedDbt(const ReturnedDbt&);
+						ReturnedDbt& operator=(const ReturnedDbt&);
+					};
+
+				// Converts a stored value into a Data instance, reading it from the blob store if the value was
+				// stored outside of the btree and decompressing it if it was compressed
+				Data resolveData(const Dbt& dbt, DbTxn* transaction);
+				// Gets the store used for values too large to be kept in the btree
+				BerkeleyBlobStore& getBlobStore() { return *blobs; }
+				// Gets the dictionaries used to compress values in this database
+				BerkeleyCompression& getCompression() { return *compression; }
+				// Gets the flush shared by the commits of group-commit transactions
+				BerkeleyGroupCommit& getGroupCommit() { return *groupCommit; }
+				// Locks the scope of a transaction over the named object stores (or the whole database, if none are named), waiting
+				// no longer than the given time (in microseconds) or, if none is given, the scope timeout.  The calling thread is
+				// blocked while it waits for transactions on other threads to release a conflicting scope; a scope that conflicts
+				// with one held on the calling thread fails at once.
+				std::auto_ptr<BerkeleyScopeLocks::Scope> lockScope(const boost::optional<std::vector<std::string> >& objectStoreNames, const bool exclusive, const boost::optional<unsigned int>& timeout);
+				// Gets the object stores in this database that have been frozen
+				BerkeleyFrozenCatalog& getFrozenCatalog() { return *frozenCatalog; }
+				// Gets the database associated with the given environment (e.g. from within a secondary callback)
+				static BerkeleyDatabase& FromEnvironment(DbEnv* environment)
+					{ return *static_cast<BerkeleyDatabase*>(environment->get_app_private()); }
+
+				// Gets the configuration with which this database was opened
+				const DatabaseConfiguration& getConfiguration() const { return configuration; }
+				// Applies the configured tuning to a Berkeley DB database (before it is opened)
+				void configure(Db& database) const;
+
+				// Opens (or removes) the Berkeley DB database for the named object store or index, according to the
+				// layout of this database (a database is always opened free-threaded, and so that cursors may read it
+				// uncommitted); Berkeley DB exceptions are left to the caller
+				void openDatabase(Db& database, DbTxn* transaction, const std::string& databaseName, const DBTYPE type, const u_int32_t flags) const;
+				void removeDatabase(DbTxn* transaction, const std::string& databaseName, const u_int32_t flags);
+
 				// Not a fan of exposing the environment in this way, but otherwise we'd need several friends.
 				DbEnv& getEnvironment() { return environment; }
 
 			private:
 				DbEnv environment;
 
-				// Managed thread associated with this environment to detect lock and transaction timeouts
+				// Registration of this environment with the (shared) detector of lock and transaction timeouts
 				std::auto_ptr<BerkeleyDeadlockDetection> deadlockDetection;
+				// The checkpointing and cache tuning of this environment (shared by every handle in this process)
+				boost::shared_ptr<BerkeleyEnvironmentServices> services;
 
 				// An object store containing metdata for this environment
 				std::auto_ptr<ObjectStore> metadata;
+				// Storage for values above the large value threshold
+				std::auto_ptr<BerkeleyBlobStore> blobs;
+				// Dictionaries for object stores with compression enabled (recorded in the metadata)
+				std::auto_ptr<BerkeleyCompression> compression;
+				// Flushes the log on behalf of group-commit transactions
+				std::auto_ptr<BerkeleyGroupCommit> groupCommit;
+				// The scopes of the transactions active in this environment (shared by every handle in this process)
+				boost::shared_ptr<BerkeleyScopeLocks> scopeLocks;
+				// Frozen object stores (recorded in the metadata)
+				std::auto_ptr<BerkeleyFrozenCatalog> frozenCatalog;
 
 				const std::string origin;
 				const std::string name;
+				const DatabaseConfiguration configuration;
+				// The layout of this database (which may differ from the configured layout, if it already existed)
+				DatabaseConfiguration::Layout layout;
 
 				// An fixed suffix for metadatabase naming (e.g. "__metadata")
 				static const std::string metadataDatabaseSuffix;
+				// An fixed suffix for the file holding every object store and index in the single file layout (e.g. "__objectStores")
+				static const std::string singleFileSuffix;
+				// Values larger than this (in bytes) are stored in the blob store
+				static const size_t largeValueThreshold;
+				// Engine defaults for the log file size and lock and transaction timeouts, used unless configured otherwise
+				static const u_int32_t defaultLogFileSize;
+				static const db_timeout_t defaultTimeout;
+				// Engine default for the time (in microseconds) for which a transaction waits to lock its scope
+				static const db_timeout_t defaultScopeTimeout;
+				// Engine defaults for the size (in bytes) of the cache, and of the part of it set aside for page versions
+				static const boost::uint64_t defaultCacheSize;
+				static const boost::uint64_t defaultVersionCacheSize;
+				// The interval (in milliseconds) at which the cache is tuned
+				static const int millisecondsBetweenCacheTuning;
+				// The interval (in milliseconds) at which the space of released large values is reclaimed
+				static const int millisecondsBetweenCompactions;
+				// Engine defaults for the log volume (in bytes) and time (in microseconds) between checkpoints
+				static const u_int32_t defaultCheckpointLogSize;
+				static const u_int32_t defaultCheckpointInterval;
+
+				// Tracks the number of handles open against each environment in this process
+				static std::map<std::string, int> openEnvironments;
+				static boost::mutex openEnvironmentsSynchronization;
+				// Registers (or unregisters) this handle; returns the number of handles now open on the environment
+				int registerEnvironment(const int delta);
+				// Releases everything this (opened) handle has acquired, and closes the environment; used both by the
+				// destructor and by a constructor that fails after the environment was opened
+				void close();
 
 				// Empty implementation; set a breakpoint here for debugging.
 				static void errorHandler(const DbEnv *environment, const char *errpfx, const char *message);
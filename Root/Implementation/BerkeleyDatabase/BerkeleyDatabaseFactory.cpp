@@ -13,6 +13,9 @@ GNU Lesser General Public License
 #include "BerkeleyManualIndexCursor.h"
 #include "BerkeleyManualIndex.h"
 #include "BerkeleyTransaction.h"
+#include "BerkeleyFrozenCursor.h"
+#include "../ImplementationException.h"
+#include "../Data.h"
 
 namespace BrandonHaynes {
 namespace IndexedDB { 
@@ -23,18 +26,29 @@ namespace BerkeleyDB
 	using ::std::list;
 	using ::std::string;
 	using ::boost::optional;
+	using ::boost::shared_ptr;
 
-	auto_ptr<Database> BerkeleyDatabaseFactory::createDatabase(const string& origin, const string& name, const string& description, const bool modifyDatabase)
-		{ return auto_ptr<Database>(new BerkeleyDatabase(origin, name, description, modifyDatabase)); }
+	const string BerkeleyDatabaseFactory::engineName = "berkeleydb";
 
-	auto_ptr<ObjectStore> BerkeleyDatabaseFactory::createObjectStore(Database& database, const string& name, const bool autoIncrement, TransactionContext& transactionContext)
-		{ return auto_ptr<ObjectStore>(new BerkeleyObjectStore(static_cast<BerkeleyDatabase&>(database), name, autoIncrement, transactionContext)); }
+	auto_ptr<Database> BerkeleyDatabaseFactory::createDatabase(const string& origin, const string& name, const string& description, const bool modifyDatabase, const DatabaseConfiguration& configuration)
+		{ return auto_ptr<Database>(new BerkeleyDatabase(origin, name, description, modifyDatabase, configuration)); }
+
+	auto_ptr<ObjectStore> BerkeleyDatabaseFactory::createObjectStore(Database& database, const string& name, const bool autoIncrement, const ObjectStore::AccessMethod accessMethod, TransactionContext& transactionContext)
+		{ return auto_ptr<ObjectStore>(new BerkeleyObjectStore(static_cast<BerkeleyDatabase&>(database), name, autoIncrement, accessMethod, transactionContext)); }
 
 	auto_ptr<ObjectStore> BerkeleyDatabaseFactory::openObjectStore(Database& database, const string& name, const ObjectStore::Mode mode, TransactionContext& transactionContext)
-		{ return auto_ptr<ObjectStore>(new BerkeleyObjectStore(static_cast<BerkeleyDatabase&>(database), name, mode, false, transactionContext)); }
+		{ 
+		BerkeleyDatabase& berkeleyDatabase = static_cast<BerkeleyDatabase&>(database);
+		auto_ptr<BerkeleyObjectStore> objectStore(new BerkeleyObjectStore(berkeleyDatabase, name, mode, false, transactionContext));
+
+		// Databases configured for compression compress each object store when it is opened for writing
+		if(mode == ObjectStore::READ_WRITE && berkeleyDatabase.getConfiguration().getCompression())
+			objectStore->ensureCompressed(transactionContext);
+		return auto_ptr<ObjectStore>(objectStore.release());
+		}
 
-	auto_ptr<Transaction> BerkeleyDatabaseFactory::createTransaction(Database& database, const ObjectStoreImplementationList& objectStores, const optional<unsigned int>& timeout, TransactionContext& transactionContext)
-		{ return auto_ptr<Transaction>(new BerkeleyTransaction(static_cast<BerkeleyDatabase&>(database), objectStores, timeout, transactionContext)); }
+	auto_ptr<Transaction> BerkeleyDatabaseFactory::createTransaction(Database& database, const ObjectStoreImplementationList& objectStores, const optional<ObjectStore::Mode>& mode, const optional<unsigned int>& timeout, const optional<DatabaseConfiguration::Durability>& durability, TransactionContext& transactionContext)
+		{ return auto_ptr<Transaction>(new BerkeleyTransaction(static_cast<BerkeleyDatabase&>(database), objectStores, mode, timeout, durability, transactionContext)); }
 
 	auto_ptr<Index> BerkeleyDatabaseFactory::createIndex(ObjectStore& objectStore, const string& name, const auto_ptr<KeyGenerator>& keyGenerator, const bool unique, TransactionContext& transactionContext)
 		{ return auto_ptr<Index>(new BerkeleyIndex(static_cast<BerkeleyObjectStore&>(objectStore), name, keyGenerator, unique, transactionContext, true)); } 
@@ -48,17 +62,48 @@ namespace BerkeleyDB
 	auto_ptr<Index> BerkeleyDatabaseFactory::openIndex(ObjectStore& objectStore, const string& name, const bool unique, TransactionContext& transactionContext)
 		{ return auto_ptr<Index>(new BerkeleyManualIndex(static_cast<BerkeleyObjectStore&>(objectStore), name, unique, transactionContext, false));  }
 
-	auto_ptr<Cursor> BerkeleyDatabaseFactory::openCursor(ObjectStore& objectStore, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, TransactionContext& transactionContext)
-		{ return auto_ptr<Cursor>(new BerkeleyObjectStoreCursor(static_cast<BerkeleyObjectStore&>(objectStore), left, right, openLeft, openRight, isReversed, omitDuplicates, transactionContext)); }
+	auto_ptr<Cursor> BerkeleyDatabaseFactory::openCursor(ObjectStore& objectStore, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const Cursor::Isolation isolation, TransactionContext& transactionContext)
+		{ 
+		BerkeleyObjectStore& berkeleyObjectStore = static_cast<BerkeleyObjectStore&>(objectStore);
+		// Cursors opened outside of a transaction over an object store in snapshot mode read its snapshot
+		TransactionContext readContext = berkeleyObjectStore.getReadContext(transactionContext);
+		shared_ptr<const BerkeleyFrozenStore> frozen = berkeleyObjectStore.getFrozen(BerkeleyTransaction::ToDbTxn(readContext));
+
+		// The keys of a hashed object store have no order, so only a cursor over every key is meaningful
+		if(berkeleyObjectStore.getAccessMethod() == ObjectStore::HASHED && 
+		   (left.getType() != Data::Undefined || right.getType() != Data::Undefined))
+			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
 
-	auto_ptr<Cursor> BerkeleyDatabaseFactory::openCursor(Index& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool returnKeys, TransactionContext& transactionContext)
+		// Cursors over a frozen object store read its frozen form (and so neither lock nor need a transaction)
+		if(frozen)
+			return auto_ptr<Cursor>(new BerkeleyFrozenCursor(frozen, string(), left, right, openLeft, openRight, isReversed, omitDuplicates, false));
+		else
+			return auto_ptr<Cursor>(new BerkeleyObjectStoreCursor(berkeleyObjectStore, left, right, openLeft, openRight, isReversed, omitDuplicates, 
+				getReadIsolation(isolation, transactionContext, readContext), readContext)); 
+		}
+
+	auto_ptr<Cursor> BerkeleyDatabaseFactory::openCursor(Index& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool returnKeys, const Cursor::Isolation isolation, TransactionContext& transactionContext)
 		{ 
 		// Not a fan of RTTI here, should probably clean up at some point.
-		if(typeid(index) == typeid(BerkeleyIndex&))
-			return auto_ptr<Cursor>(new BerkeleyIndexCursor(static_cast<BerkeleyIndex&>(index), left, right, openLeft, openRight, isReversed, omitDuplicates, returnKeys, transactionContext)); 
+		const bool isManual = typeid(index) != typeid(BerkeleyIndex&);
+		BerkeleyObjectStore& objectStore = isManual ? static_cast<BerkeleyManualIndex&>(index).getObjectStore() : static_cast<BerkeleyIndex&>(index).getObjectStore();
+		const string& name = isManual ? static_cast<BerkeleyManualIndex&>(index).getName() : static_cast<BerkeleyIndex&>(index).getName();
+		TransactionContext readContext = objectStore.getReadContext(transactionContext);
+		shared_ptr<const BerkeleyFrozenStore> frozen = objectStore.getFrozen(BerkeleyTransaction::ToDbTxn(readContext));
+
+		// An index created since its object store was frozen is read from Berkeley DB
+		if(frozen && frozen->getTable(name) != NULL)
+			return auto_ptr<Cursor>(new BerkeleyFrozenCursor(frozen, name, left, right, openLeft, openRight, isReversed, omitDuplicates, returnKeys));
+		else if(!isManual)
+			return auto_ptr<Cursor>(new BerkeleyIndexCursor(static_cast<BerkeleyIndex&>(index), left, right, openLeft, openRight, isReversed, omitDuplicates, returnKeys, 
+				getReadIsolation(isolation, transactionContext, readContext), readContext)); 
 		else
-			return auto_ptr<Cursor>(new BerkeleyManualIndexCursor(static_cast<BerkeleyManualIndex&>(index), left, right, openLeft, openRight, isReversed, omitDuplicates, returnKeys, transactionContext)); 
+			return auto_ptr<Cursor>(new BerkeleyManualIndexCursor(static_cast<BerkeleyManualIndex&>(index), left, right, openLeft, openRight, isReversed, omitDuplicates, returnKeys, 
+				getReadIsolation(isolation, transactionContext, readContext), readContext)); 
 		}
+
+	Cursor::Isolation BerkeleyDatabaseFactory::getReadIsolation(const Cursor::Isolation isolation, TransactionContext& transactionContext, TransactionContext& readContext)
+		{ return !transactionContext.is_initialized() && readContext.is_initialized() ? Cursor::SERIALIZABLE : isolation; }
 	}
 }
 }
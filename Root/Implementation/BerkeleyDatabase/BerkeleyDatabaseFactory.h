@@ -24,8 +24,11 @@ namespace BerkeleyDB {
 			BerkeleyDatabaseFactory(void) { }
 			~BerkeleyDatabaseFactory(void) { }
 
-			virtual std::auto_ptr<Database> createDatabase(const std::string& origin, const std::string& name, const std::string& description, const bool modifyDatabase = true);
-			virtual std::auto_ptr<ObjectStore> createObjectStore(Database& database, const std::string& name, const bool autoIncrement = true, TransactionContext& transactionContext = TransactionContext());
+			// The name by which this engine is selected (e.g. "berkeleydb")
+			static const std::string engineName;
+
+			virtual std::auto_ptr<Database> createDatabase(const std::string& origin, const std::string& name, const std::string& description, const bool modifyDatabase = true, const DatabaseConfiguration& configuration = DatabaseConfiguration());
+			virtual std::auto_ptr<ObjectStore> createObjectStore(Database& database, const std::string& name, const bool autoIncrement = true, const ObjectStore::AccessMethod accessMethod = ObjectStore::ORDERED, TransactionContext& transactionContext = TransactionContext());
 			virtual std::auto_ptr<ObjectStore> openObjectStore(Database& database, const std::string& name, const ObjectStore::Mode mode, TransactionContext& transactionContext);		
 			
 			virtual std::auto_ptr<Index> createIndex(ObjectStore& objectStore, const std::string& name, const std::auto_ptr<KeyGenerator>& keyGenerator, const bool unique, TransactionContext& transactionContext);
@@ -33,10 +36,15 @@ namespace BerkeleyDB {
 			virtual std::auto_ptr<Index> openIndex(ObjectStore& objectStore, const std::string& name, const std::auto_ptr<KeyGenerator>& keyGenerator, const bool unique, TransactionContext& transactionContext);
 			virtual std::auto_ptr<Index> openIndex(ObjectStore& objectStore, const std::string& name, const bool unique, TransactionContext& transactionContext);
 
-			virtual std::auto_ptr<Cursor> openCursor(ObjectStore& objectStoreSync, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, TransactionContext& transactionContext);
-			virtual std::auto_ptr<Cursor> openCursor(Index& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool returnkeys, TransactionContext& transactionContext);
+			virtual std::auto_ptr<Cursor> openCursor(ObjectStore& objectStoreSync, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const Cursor::Isolation isolation, TransactionContext& transactionContext);
+			virtual std::auto_ptr<Cursor> openCursor(Index& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool returnkeys, const Cursor::Isolation isolation, TransactionContext& transactionContext);
 			
-			virtual std::auto_ptr<Transaction> createTransaction(Database& database, const ObjectStoreImplementationList& objectStores, const boost::optional<unsigned int>& timeout, TransactionContext& transactionContext);
+			virtual std::auto_ptr<Transaction> createTransaction(Database& database, const ObjectStoreImplementationList& objectStores, const boost::optional<ObjectStore::Mode>& mode, const boost::optional<unsigned int>& timeout, const boost::optional<DatabaseConfiguration::Durability>& durability, TransactionContext& transactionContext);
+
+		private:
+			// Gets the isolation with which a cursor reads in the given context; a cursor over the snapshot of an object store
+			// takes no read locks, whatever the isolation requested
+			static Cursor::Isolation getReadIsolation(const Cursor::Isolation isolation, TransactionContext& transactionContext, TransactionContext& readContext);
 		};
 	}
 }
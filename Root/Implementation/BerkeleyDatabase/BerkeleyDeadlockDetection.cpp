@@ -0,0 +1,115 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <algorithm>
+#include <boost/bind.hpp>
+#include "BerkeleyDeadlockDetection.h"
+
+using std::list;
+using boost::mutex;
+using boost::lock_guard;
+using boost::unique_lock;
+using boost::shared_ptr;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	list<DbEnv*> BerkeleyDeadlockDetection::environments;
+	std::auto_ptr<boost::thread> BerkeleyDeadlockDetection::detectionThread;
+	shared_ptr<bool> BerkeleyDeadlockDetection::isStopping;
+	mutex BerkeleyDeadlockDetection::synchronized;
+	boost::condition_variable BerkeleyDeadlockDetection::changed;
+	const int BerkeleyDeadlockDetection::minimumMillisecondsBetweenDetection = 5;
+	const int BerkeleyDeadlockDetection::maximumMillisecondsBetweenDetection = 500;
+
+	BerkeleyDeadlockDetection::BerkeleyDeadlockDetection(DbEnv& environment)
+		: environment(environment), isRunning(false)
+		{ }
+
+	BerkeleyDeadlockDetection::~BerkeleyDeadlockDetection()
+		{ stop(); }
+
+	void BerkeleyDeadlockDetection::start()
+		{
+		lock_guard<mutex> guard(synchronized);
+
+		if(!isRunning)
+			{
+			isRunning = true;
+			environments.push_back(&environment);
+
+			if(detectionThread.get() == NULL)
+				{
+				isStopping.reset(new bool(false));
+				detectionThread.reset(new boost::thread(boost::bind(
+					&BerkeleyDeadlockDetection::detectDeadlocks, isStopping)));
+				}
+			// A newly-registered environment is checked promptly
+			else
+				changed.notify_all();
+			}
+		}
+
+	void BerkeleyDeadlockDetection::stop()
+		{
+		std::auto_ptr<boost::thread> stoppedThread;
+
+			{
+			// The detector holds this lock while it uses an environment, so ours is not in use once we have it
+			lock_guard<mutex> guard(synchronized);
+			if(!isRunning)
+				return;
+
+			isRunning = false;
+			environments.remove(&environment);
+
+			// The last environment out stops the thread
+			if(environments.empty())
+				{
+				*isStopping = true;
+				stoppedThread = detectionThread;
+				changed.notify_all();
+				}
+			}
+
+		if(stoppedThread.get() != NULL)
+			stoppedThread->join();
+		}
+
+	void BerkeleyDeadlockDetection::detectDeadlocks(shared_ptr<bool> isStopping)
+		{
+		unique_lock<mutex> lock(synchronized);
+		int millisecondsBetweenDetection = minimumMillisecondsBetweenDetection;
+
+		// Automatically terminate whenever our flag is set (which also cuts short our wait)
+		while(!*isStopping)
+			{
+			int rejected = 0;
+
+			for(list<DbEnv*>::const_iterator iterator = environments.begin(); iterator != environments.end(); iterator++)
+				try
+					{
+					int environmentRejected = 0;
+					(*iterator)->lock_detect(0, DB_LOCK_DEFAULT, &environmentRejected);
+					rejected += environmentRejected;
+					}
+				// A failed pass over one environment does not affect the others; the next pass may well succeed
+				catch(DbException&) { }
+
+			// Lock contention tends to come in bursts, so we check often while it lasts and back off while it does not
+			millisecondsBetweenDetection = rejected > 0
+				? minimumMillisecondsBetweenDetection
+				: std::min(maximumMillisecondsBetweenDetection, millisecondsBetweenDetection * 2);
+
+			changed.timed_wait(lock, boost::posix_time::milliseconds(millisecondsBetweenDetection));
+			}
+		}
+	}
+}
+}
+}
@@ -7,9 +7,13 @@ GNU Lesser General Public License
 #ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYDEADLOCKDETECTION_H
 #define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYDEADLOCKDETECTION_H
 
-#include <db_cxx.h>
-#include <boost/bind.hpp>
+#include <list>
+#include <memory>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <db_cxx.h>
 
 namespace BrandonHaynes {
 namespace IndexedDB { 
@@ -17,72 +21,49 @@ namespace Implementation {
 namespace BerkeleyDB
 	{
 	///<summary>
-	/// This class is spawned on a per-BerkeleyDatabase basis; it runs the Berkeley DB timeout detection method
-	/// on an interval.  This class is fully managed by BerkeleyDatabase, including initiation and termination.
-	/// (There is no reason that an external entity could not also utilize this class.)  This class is RAII.
+	/// This class registers a Berkeley DB environment with the (process-wide) timeout detector.  Deadlocks
+	/// themselves are broken by Berkeley DB as soon as a lock request conflicts (see set_lk_detect), but expired
+	/// locks and transactions are only noticed when detection runs; a single thread does so for every registered
+	/// environment.  Its interval adapts: a pass that rejects a lock request drops it to the minimum, and a
+	/// pass that rejects nothing doubles it (up to the maximum).  The thread exists only while at least one
+	/// environment is registered.  This class is managed by BerkeleyDatabase, and is RAII.
 	///</summary>
 	class BerkeleyDeadlockDetection
 		{
 		public:
-			// Create a deadlock detection thread for the given environment.  Timeouts are detected at the given interval.
-			BerkeleyDeadlockDetection(DbEnv& environment, int millisecondsBetweenDetection)
-				: isRunning(false), 
-				  environment(environment), 
-				  millisecondsBetweenDetection(millisecondsBetweenDetection)
-				{ }
-
-			~BerkeleyDeadlockDetection()
-				{ stop(); }
-
-			// Start deadlock detection on this thread
-			void start()
-				{ 
-				boost::lock_guard<boost::mutex> guard(synchronized);
-				if(!isRunning)
-					{
-					isRunning = true; 
-					deadlockDetectionThread = std::auto_ptr<boost::thread>(new boost::thread(boost::bind(
-						&BerkeleyDeadlockDetection::detectDeadlocks, this)));
-					}
-				}
+			// Create a registration for the given environment
+			explicit BerkeleyDeadlockDetection(DbEnv& environment);
+			~BerkeleyDeadlockDetection();
 
-			// Conclude deadlock detection on this thread
-			void stop()
-				{
-				boost::lock_guard<boost::mutex> guard(synchronized);
-				if(isRunning)
-					{
-					isRunning = false;
-					deadlockDetectionThread->join();
-					}
-				}
+			// Register (or unregister) the environment; once stop returns, the detector no longer uses it
+			void start();
+			void stop();
 
 		private:
-			// The thead associated with this class
-			std::auto_ptr<boost::thread> deadlockDetectionThread;
-			// Several operations need to be synchronized; we use a Boost mutex for this purpose
-			boost::mutex synchronized;
 			DbEnv& environment;
-			// Indicates whether our thread is currently running
-			volatile bool isRunning;
-			const int millisecondsBetweenDetection;
-		    
-			// Method fired once every interval; detects timed out transactions and locks
-			void detectDeadlocks()
-				{
-				// Automatically terminate whenever the isRunning flag is cleared
-				while(isRunning)
-					{
-					// Execute our deadlock detection routine
-					environment.lock_detect(0, DB_LOCK_DEFAULT, NULL);
-					// Sleep for our interval (I believe this is interruptable, but should probably check)
-					boost::this_thread::sleep(boost::posix_time::milliseconds(millisecondsBetweenDetection));
-					}
-				}
+			// Indicates whether our environment is currently registered
+			bool isRunning;
+
+			// The environments registered with the detector, and the thread that services them
+			static std::list<DbEnv*> environments;
+			static std::auto_ptr<boost::thread> detectionThread;
+			// Set to stop the current detection thread (each thread has a flag of its own, so that a stopping
+			// thread may be joined while its replacement starts)
+			static boost::shared_ptr<bool> isStopping;
+			// Guards all of the above, and is held by the detector while it uses an environment
+			static boost::mutex synchronized;
+			static boost::condition_variable changed;
+
+			// Bounds (in milliseconds) of the interval between detection passes
+			static const int minimumMillisecondsBetweenDetection;
+			static const int maximumMillisecondsBetweenDetection;
+
+			// Method fired once every interval; detects timed out transactions and locks in each environment
+			static void detectDeadlocks(boost::shared_ptr<bool> isStopping);
 		};
 	}
 }
 }
 }
 
-#endif
\ No newline at end of file
+#endif
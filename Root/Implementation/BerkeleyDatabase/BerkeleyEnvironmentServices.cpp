@@ -0,0 +1,93 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <cstdlib>
+#include "BerkeleyEnvironmentServices.h"
+#include "BerkeleyBlobCompaction.h"
+#include "BerkeleyCacheTuning.h"
+#include "BerkeleyCheckpointing.h"
+#include "../ImplementationException.h"
+
+using std::map;
+using std::string;
+using boost::mutex;
+using boost::lock_guard;
+using boost::optional;
+using boost::shared_ptr;
+using boost::weak_ptr;
+using boost::uint64_t;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	map<string, weak_ptr<BerkeleyEnvironmentServices> > BerkeleyEnvironmentServices::instances;
+	mutex BerkeleyEnvironmentServices::instancesSynchronization;
+
+	shared_ptr<BerkeleyEnvironmentServices> BerkeleyEnvironmentServices::getInstance(const string& home, const string& name,
+		const optional<uint64_t>& cacheBudget, const int millisecondsBetweenCacheTuning,
+		const u_int32_t kilobytesBetweenCheckpoints, const int millisecondsBetweenCheckpoints,
+		const int millisecondsBetweenCompactions)
+		{
+		lock_guard<mutex> guard(instancesSynchronization);
+		shared_ptr<BerkeleyEnvironmentServices> services = instances[home].lock();
+
+		if(!services)
+			{
+			services.reset(new BerkeleyEnvironmentServices(home, name, cacheBudget, millisecondsBetweenCacheTuning, 
+				kilobytesBetweenCheckpoints, millisecondsBetweenCheckpoints, millisecondsBetweenCompactions));
+			instances[home] = services;
+			}
+
+		return services;
+		}
+
+	BerkeleyEnvironmentServices::BerkeleyEnvironmentServices(const string& home, const string& name,
+		const optional<uint64_t>& cacheBudget, const int millisecondsBetweenCacheTuning,
+		const u_int32_t kilobytesBetweenCheckpoints, const int millisecondsBetweenCheckpoints,
+		const int millisecondsBetweenCompactions)
+		: environment(0)
+		{
+		// As with BerkeleyDatabase, memory returned by the environment is freed by our runtime
+		environment.set_alloc(malloc, realloc, free);
+
+		try
+			{ environment.open(home.c_str(), DB_JOINENV | DB_THREAD, 0); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+
+		if(cacheBudget.is_initialized())
+			try
+				{
+				cacheTuning.reset(new BerkeleyCacheTuning(environment, cacheBudget.get(), millisecondsBetweenCacheTuning));
+				cacheTuning->start();
+				}
+			// Tuning is only an optimization; a cache that cannot be sampled is left at its configured size
+			catch(DbException&) { }
+
+		checkpointing.reset(new BerkeleyCheckpointing(environment, kilobytesBetweenCheckpoints, millisecondsBetweenCheckpoints));
+		checkpointing->start();
+
+		compaction.reset(new BerkeleyBlobCompaction(environment, name, millisecondsBetweenCompactions));
+		compaction->start();
+		}
+
+	BerkeleyEnvironmentServices::~BerkeleyEnvironmentServices()
+		{
+		compaction->stop();
+		if(cacheTuning.get() != NULL)
+			cacheTuning->stop();
+		checkpointing->stop();
+
+		try
+			{ environment.close(0); }
+		catch(DbException&) { }
+		}
+	}
+}
+}
+}
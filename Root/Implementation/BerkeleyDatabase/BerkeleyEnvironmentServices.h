@@ -0,0 +1,71 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYENVIRONMENTSERVICES_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYENVIRONMENTSERVICES_H
+
+#include <map>
+#include <string>
+#include <memory>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <db_cxx.h>
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	class BerkeleyBlobCompaction;
+	class BerkeleyCacheTuning;
+	class BerkeleyCheckpointing;
+
+	///<summary>
+	/// This class runs the background services of a Berkeley DB environment (checkpointing, compaction of large
+	/// values and, if a cache budget is configured, cache tuning) once for every handle on that environment in this process.  The services join
+	/// the environment through a handle of their own, so they outlive whichever handle started them; they are
+	/// stopped when the last handle releases them.  They are configured by the first handle to open the environment.
+	/// This class is RAII.
+	///</summary>
+	class BerkeleyEnvironmentServices
+		{
+		public:
+			// Gets the services of the environment at the given home (which must already be open), starting them with
+			// the given settings if no other handle in this process has
+			static boost::shared_ptr<BerkeleyEnvironmentServices> getInstance(const std::string& home, const std::string& name,
+				const boost::optional<boost::uint64_t>& cacheBudget, const int millisecondsBetweenCacheTuning,
+				const u_int32_t kilobytesBetweenCheckpoints, const int millisecondsBetweenCheckpoints,
+				const int millisecondsBetweenCompactions);
+			~BerkeleyEnvironmentServices();
+
+		private:
+			// Our own handle on the environment, on which the services run
+			DbEnv environment;
+			// Managed thread to resize the cache of the environment (only if a cache budget is configured)
+			std::auto_ptr<BerkeleyCacheTuning> cacheTuning;
+			// Managed thread to take checkpoints and remove obsolete log files
+			std::auto_ptr<BerkeleyCheckpointing> checkpointing;
+			// Managed thread to reclaim the space of released large values
+			std::auto_ptr<BerkeleyBlobCompaction> compaction;
+
+			// The services of each environment in use in this process, by home
+			static std::map<std::string, boost::weak_ptr<BerkeleyEnvironmentServices> > instances;
+			static boost::mutex instancesSynchronization;
+
+			BerkeleyEnvironmentServices(const std::string& home, const std::string& name,
+				const boost::optional<boost::uint64_t>& cacheBudget, const int millisecondsBetweenCacheTuning,
+				const u_int32_t kilobytesBetweenCheckpoints, const int millisecondsBetweenCheckpoints,
+				const int millisecondsBetweenCompactions);
+		};
+	}
+}
+}
+}
+
+#endif
@@ -0,0 +1,192 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include "BerkeleyFrozenCatalog.h"
+#include "BerkeleyDatabase.h"
+#include "../Key.h"
+#include "../Data.h"
+#include "../ImplementationException.h"
+
+using std::map;
+using std::string;
+using boost::mutex;
+using boost::lock_guard;
+using boost::optional;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	map<string, BerkeleyFrozenCatalog::StorePtr> BerkeleyFrozenCatalog::stores;
+	mutex BerkeleyFrozenCatalog::storesSynchronization;
+	mutex BerkeleyFrozenCatalog::freezeSynchronization;
+
+	BerkeleyFrozenCatalog::BerkeleyFrozenCatalog(Db& metadata, const string& home)
+		: metadata(metadata), home(home)
+		{ }
+
+	BerkeleyFrozenCatalog::StorePtr BerkeleyFrozenCatalog::get(const string& objectStoreName, DbTxn* transaction)
+		{
+			{
+			lock_guard<mutex> guard(storesSynchronization);
+			map<string, StorePtr>::const_iterator cached = stores.find(getPath(objectStoreName));
+			if(cached != stores.end())
+				return cached->second;
+			}
+
+		// Stores are loaded while freezing is excluded, so that we never map a generation that is being discarded
+		lock_guard<mutex> freezeGuard(freezeSynchronization);
+		optional<Generation> generation = getGeneration(objectStoreName, transaction);
+		StorePtr store;
+
+		if(generation.is_initialized())
+			store.reset(new BerkeleyFrozenStore(getPath(objectStoreName, generation.get())));
+
+		lock_guard<mutex> guard(storesSynchronization);
+		return stores.insert(std::make_pair(getPath(objectStoreName), store)).first->second;
+		}
+
+	void BerkeleyFrozenCatalog::freeze(const string& objectStoreName, const WriteCallback& write)
+		{
+		lock_guard<mutex> guard(freezeSynchronization);
+		optional<Generation> previous = getGeneration(objectStoreName, NULL);
+		const string path = getPath(objectStoreName, previous.get_value_or(0) + 1);
+		const string temporaryPath = path + ".tmp";
+
+		// An unfinished writer removes its file, so a failure here leaves nothing behind
+			{
+			BerkeleyFrozenStore::Writer writer(temporaryPath);
+			write(writer);
+			writer.finish();
+			}
+
+		try
+			{
+			// A file left by an earlier (interrupted) freeze may occupy the path
+			boost::filesystem::remove(path);
+			boost::filesystem::rename(temporaryPath, path);
+			}
+		catch(boost::filesystem::basic_filesystem_error<boost::filesystem::path>& e)
+			{
+			try
+				{ boost::filesystem::remove(temporaryPath); }
+			catch(boost::filesystem::basic_filesystem_error<boost::filesystem::path>&) { }
+			throw ImplementationException(e.what(), ImplementationException::UNKNOWN_ERR);
+			}
+
+		StorePtr store(new BerkeleyFrozenStore(path));
+		try
+			{ setGeneration(objectStoreName, previous.get_value_or(0) + 1, NULL); }
+		catch(ImplementationException&)
+			{
+			store->markObsolete();
+			throw;
+			}
+
+		publish(objectStoreName, store, previous);
+		}
+
+	void BerkeleyFrozenCatalog::thaw(const string& objectStoreName)
+		{
+		lock_guard<mutex> guard(freezeSynchronization);
+		optional<Generation> previous = getGeneration(objectStoreName, NULL);
+
+		if(previous.is_initialized())
+			setGeneration(objectStoreName, optional<Generation>(), NULL);
+		publish(objectStoreName, StorePtr(), previous);
+		}
+
+	optional<BerkeleyFrozenCatalog::Generation> BerkeleyFrozenCatalog::remove(const string& objectStoreName, DbTxn* transaction)
+		{
+		optional<Generation> generation = getGeneration(objectStoreName, transaction);
+
+		if(generation.is_initialized())
+			setGeneration(objectStoreName, optional<Generation>(), transaction);
+		return generation;
+		}
+
+	void BerkeleyFrozenCatalog::release(const string& objectStoreName, const optional<Generation>& generation)
+		{
+		lock_guard<mutex> guard(freezeSynchronization);
+		publish(objectStoreName, StorePtr(), generation);
+		}
+
+	optional<BerkeleyFrozenCatalog::Generation> BerkeleyFrozenCatalog::getGeneration(const string& objectStoreName, DbTxn* transaction)
+		{
+		BerkeleyDatabase::ReturnedDbt value;
+
+		try
+			{
+			if(metadata.get(transaction, &BerkeleyDatabase::ToDbt(Key(getObjectStoreKey(objectStoreName))), &value, 0) == 0 &&
+					value.get_size() == 1 + sizeof(Generation))
+				{
+				Generation generation;
+				memcpy(&generation, static_cast<unsigned char*>(value.get_data()) + 1, sizeof(generation));
+				return generation;
+				}
+			else
+				return optional<Generation>();
+			}
+		catch(DbDeadlockException& e)
+			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		}
+
+	void BerkeleyFrozenCatalog::setGeneration(const string& objectStoreName, const optional<Generation>& generation, DbTxn* transaction)
+		{
+		Key key(getObjectStoreKey(objectStoreName));
+
+		try
+			{
+			// Absent a transaction, the change is committed immediately (the metadata database is opened to auto-commit)
+			if(generation.is_initialized())
+				metadata.put(transaction, &BerkeleyDatabase::ToDbt(key),
+					&BerkeleyDatabase::ToDbt(Data(&generation.get(), sizeof(Generation), Data::Integer)), 0);
+			else
+				metadata.del(transaction, &BerkeleyDatabase::ToDbt(key), 0);
+			}
+		catch(DbDeadlockException& e)
+			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+		catch(DbException& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		}
+
+	void BerkeleyFrozenCatalog::publish(const string& objectStoreName, const StorePtr& store, const optional<Generation>& previous)
+		{
+		StorePtr superseded;
+
+			{
+			lock_guard<mutex> guard(storesSynchronization);
+			StorePtr& current = stores[getPath(objectStoreName)];
+			superseded = current;
+			current = store;
+			}
+
+		// A mapped store is removed once its last reader releases it; one never mapped here may be removed now
+		if(superseded)
+			superseded->markObsolete();
+		else if(previous.is_initialized())
+			try
+				{ boost::filesystem::remove(getPath(objectStoreName, previous.get())); }
+			catch(boost::filesystem::basic_filesystem_error<boost::filesystem::path>&) { }
+		}
+
+	const string BerkeleyFrozenCatalog::getPath(const string& objectStoreName) const
+		{ return home + "\\" + objectStoreName; }
+
+	const string BerkeleyFrozenCatalog::getPath(const string& objectStoreName, const Generation generation) const
+		{ return getPath(objectStoreName) + "." + boost::lexical_cast<string>(generation) + ".frozen"; }
+
+	const string BerkeleyFrozenCatalog::getObjectStoreKey(const string& objectStoreName)
+		{ return "__frozen:" + objectStoreName; }
+	}
+}
+}
+}
@@ -0,0 +1,82 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYFROZENCATALOG_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYFROZENCATALOG_H
+
+#include <map>
+#include <string>
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <db_cxx.h>
+#include "BerkeleyFrozenStore.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB {
+
+	///<summary>
+	/// This class tracks the object stores in a database that have been frozen (see BerkeleyFrozenStore).  The
+	/// current generation of each frozen store is recorded in the database metadata, and its file is named for
+	/// that generation; a store that is frozen again is written to a new file, so that readers of the previous
+	/// generation are never disturbed (a file that is mapped may not be replaced on every platform).
+	///
+	/// Mapped stores are shared by every handle on the database in this process.  Freezing and thawing take
+	/// effect immediately, and are not undone if an enclosing transaction aborts.
+	///</summary>
+	class BerkeleyFrozenCatalog
+		{
+		public:
+			typedef boost::shared_ptr<const BerkeleyFrozenStore> StorePtr;
+			typedef boost::function<void (BerkeleyFrozenStore::Writer&)> WriteCallback;
+			typedef boost::uint32_t Generation;
+
+			// Creates a catalog recorded in the given metadata database, for stores held in the given directory
+			BerkeleyFrozenCatalog(Db& metadata, const std::string& home);
+
+			// Gets the frozen store for the given object store, or an empty pointer if it is not frozen
+			StorePtr get(const std::string& objectStoreName, DbTxn* transaction);
+			// Freezes an object store; the callback writes its tables, after which the new store replaces any previous one
+			void freeze(const std::string& objectStoreName, const WriteCallback& write);
+			// Discards the frozen store (if any) for the given object store
+			void thaw(const std::string& objectStoreName);
+
+			// Removes the record of the frozen store for an object store that is being removed (in the same transaction);
+			// returns the generation removed, which is passed to release once the transaction commits
+			boost::optional<Generation> remove(const std::string& objectStoreName, DbTxn* transaction);
+			void release(const std::string& objectStoreName, const boost::optional<Generation>& generation);
+
+		private:
+			// The metadata database in which generations are recorded
+			Db& metadata;
+			// The directory holding the frozen stores
+			const std::string home;
+
+			// Mapped stores (or an empty pointer, for an object store known not to be frozen), keyed by path
+			static std::map<std::string, StorePtr> stores;
+			static boost::mutex storesSynchronization;
+			// Freezing is serialized, so that concurrent freezes do not claim the same generation
+			static boost::mutex freezeSynchronization;
+
+			boost::optional<Generation> getGeneration(const std::string& objectStoreName, DbTxn* transaction);
+			void setGeneration(const std::string& objectStoreName, const boost::optional<Generation>& generation, DbTxn* transaction);
+			// Replaces the mapped store for an object store, and discards the one it supersedes
+			void publish(const std::string& objectStoreName, const StorePtr& store, const boost::optional<Generation>& previous);
+
+			const std::string getPath(const std::string& objectStoreName) const;
+			const std::string getPath(const std::string& objectStoreName, const Generation generation) const;
+			static const std::string getObjectStoreKey(const std::string& objectStoreName);
+		};
+	}
+}
+}
+}
+
+#endif
@@ -0,0 +1,166 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include "BerkeleyFrozenCursor.h"
+#include "../ImplementationException.h"
+
+using std::string;
+using boost::mutex;
+using boost::lock_guard;
+using boost::optional;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	BerkeleyFrozenCursor::BerkeleyFrozenCursor(const boost::shared_ptr<const BerkeleyFrozenStore>& store, const string& tableName, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool dataArePrimaryKeys)
+		: Cursor(left, right, openLeft, openRight, isReversed, omitDuplicates),
+		  store(store),
+		  table(getTable(*store, tableName)),
+		  values(getTable(*store, string())),
+		  isIndex(!tableName.empty()),
+		  dataArePrimaryKeys(dataArePrimaryKeys),
+		  totalCount(-1),
+		  isOpen(true)
+		{
+		if(!initial(position) || isOutOfRange(position.getKey()))
+			throw ImplementationException("NOT_FOUND_ERR", ImplementationException::NOT_FOUND_ERR);
+		}
+
+	Key BerkeleyFrozenCursor::getKey()
+		{
+		ensureOpen();
+		return position.getKey();
+		}
+
+	Data BerkeleyFrozenCursor::getData(TransactionContext& transactionContext)
+		{
+		ensureOpen();
+
+		if(!isIndex || dataArePrimaryKeys)
+			return position.getValue();
+
+		optional<Data> value = values.find(position.getValue());
+		return value.is_initialized() ? value.get() : Data::getUndefinedData();
+		}
+
+	bool BerkeleyFrozenCursor::next(TransactionContext& transactionContext)
+		{
+		ensureOpen();
+		return step(position) && !isOutOfRange(position.getKey());
+		}
+
+	bool BerkeleyFrozenCursor::next(const Key& key)
+		{
+		BerkeleyFrozenStore::Table::Position found;
+
+		ensureOpen();
+
+		if(!table.seek(key, true, found) || !(found.getKey() == key))
+			return false;
+
+		position = found;
+		return true;
+		}
+
+	unsigned long BerkeleyFrozenCursor::getCount(TransactionContext& transactionContext)
+		{
+		ensureOpen();
+
+		if(totalCount == -1)
+			{
+			BerkeleyFrozenStore::Table::Position counter;
+			long count = 0;
+
+			// As with Berkeley DB, this is an O(n) iteration over the interval (though without any I/O or locking)
+			if(initial(counter) && !isOutOfRange(counter.getKey()))
+				for(count = 1; step(counter) && !isOutOfRange(counter.getKey()); ++count)
+					{ }
+
+			totalCount = count;
+			}
+
+		return totalCount;
+		}
+
+	void BerkeleyFrozenCursor::remove()
+		{
+		ensureOpen();
+		throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
+		}
+
+	void BerkeleyFrozenCursor::close()
+		{
+		lock_guard<mutex> guard(synchronization);
+		isOpen = false;
+		}
+
+	bool BerkeleyFrozenCursor::initial(BerkeleyFrozenStore::Table::Position& position) const
+		{
+		if(isReversed && right.getType() == Data::Undefined)
+			return table.last(position);
+		else if(isReversed)
+			{
+			// Find the first record beyond the right bound (or at it, if it is open), and then go back one
+			return table.seek(right, openRight, position)
+				? table.previous(position)
+				: table.last(position);
+			}
+		else if(left.getType() == Data::Undefined)
+			return table.first(position);
+		else
+			return table.seek(left, !openLeft, position);
+		}
+
+	bool BerkeleyFrozenCursor::step(BerkeleyFrozenStore::Table::Position& position) const
+		{
+		const Key current = position.getKey();
+		BerkeleyFrozenStore::Table::Position candidate = position;
+
+		do
+			{
+			if(!(isReversed ? table.previous(candidate) : table.next(candidate)))
+				return false;
+			}
+		while(omitDuplicates && candidate.getKey() == current);
+
+		position = candidate;
+		return true;
+		}
+
+	bool BerkeleyFrozenCursor::isOutOfRange(const Key& key) const
+		{
+		if(isReversed)
+			return left.getType() != Data::Undefined &&
+					(openLeft
+						? left >= key
+						: left > key);
+		else
+			return right.getType() != Data::Undefined &&
+					(openRight
+						? right <= key
+						: right < key);
+		}
+
+	void BerkeleyFrozenCursor::ensureOpen()
+		{
+		if(!isOpen)
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		}
+
+	const BerkeleyFrozenStore::Table& BerkeleyFrozenCursor::getTable(const BerkeleyFrozenStore& store, const string& name)
+		{
+		const BerkeleyFrozenStore::Table* table = store.getTable(name);
+
+		if(table == NULL)
+			throw ImplementationException("NOT_FOUND_ERR", ImplementationException::NOT_FOUND_ERR);
+		return *table;
+		}
+	}
+}
+}
+}
@@ -0,0 +1,75 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYFROZENCURSOR_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYFROZENCURSOR_H
+
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "BerkeleyFrozenStore.h"
+#include "../Cursor.h"
+#include "../Key.h"
+#include "../Data.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB {
+
+	///<summary>
+	/// This class represents a cursor over a table of a frozen object store (see BerkeleyFrozenStore).  The
+	/// cursor holds the store for its lifetime, and neither locks nor participates in a transaction; a frozen
+	/// store cannot be modified, so removal is not allowed.
+	///</summary>
+	class BerkeleyFrozenCursor : public Cursor
+		{
+		public:
+			// Opens a cursor over the named table; a cursor over an index table returns primary keys (if dataArePrimaryKeys)
+			// or the values they identify
+			BerkeleyFrozenCursor(const boost::shared_ptr<const BerkeleyFrozenStore>& store, const std::string& tableName, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool dataArePrimaryKeys);
+			virtual ~BerkeleyFrozenCursor() { }
+
+			virtual Key getKey();
+			virtual Data getData(TransactionContext& transactionContext);
+			virtual unsigned long getCount(TransactionContext& transactionContext);
+			virtual bool next(TransactionContext& transactionContext);
+			virtual bool next(const Key& key);
+			virtual void remove();
+			virtual void close();
+
+		private:
+			const boost::shared_ptr<const BerkeleyFrozenStore> store;
+			// The table over which we iterate, and the object store table (used to resolve primary keys)
+			const BerkeleyFrozenStore::Table& table;
+			const BerkeleyFrozenStore::Table& values;
+			// Flag indicating whether the table is an index (its values are primary keys)
+			const bool isIndex;
+			const bool dataArePrimaryKeys;
+
+			BerkeleyFrozenStore::Table::Position position;
+			long totalCount;
+			volatile bool isOpen;
+
+			boost::mutex synchronization;
+
+			/// Utility methods used to find the first record in the interval, and to step between records
+			bool initial(BerkeleyFrozenStore::Table::Position& position) const;
+			bool step(BerkeleyFrozenStore::Table::Position& position) const;
+
+			/// Utility method to determine if a key is outside of the cursor's defined interval
+			bool isOutOfRange(const Key& key) const;
+			/// Helper method to ensure that the cursor is open; throw otherwise
+			void ensureOpen();
+
+			static const BerkeleyFrozenStore::Table& getTable(const BerkeleyFrozenStore& store, const std::string& name);
+		};
+	}
+}
+}
+}
+
+#endif
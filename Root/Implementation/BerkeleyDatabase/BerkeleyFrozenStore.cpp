@@ -0,0 +1,400 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include "BerkeleyFrozenStore.h"
+#include "../FileSynchronization.h"
+#include "../ImplementationException.h"
+
+using std::map;
+using std::string;
+using std::vector;
+using boost::optional;
+using boost::uint32_t;
+using boost::uint64_t;
+using boost::interprocess::file_mapping;
+using boost::interprocess::mapped_region;
+using boost::interprocess::interprocess_exception;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	const uint32_t BerkeleyFrozenStore::magic = 0x5a525346; // "FSRZ"
+	const size_t BerkeleyFrozenStore::footerSize = 16;
+	const size_t BerkeleyFrozenStore::blockSize = 4096;
+
+	BerkeleyFrozenStore::BerkeleyFrozenStore(const string& path)
+		: path(path), isObsolete(false)
+		{
+		try
+			{
+			mapping.reset(new file_mapping(path.c_str(), boost::interprocess::read_only));
+			region.reset(new mapped_region(*mapping, boost::interprocess::read_only));
+			}
+		catch(interprocess_exception& e)
+			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_native_error()); }
+
+		const unsigned char* base = static_cast<const unsigned char*>(region->get_address());
+		const size_t size = region->get_size();
+
+		if(size < footerSize || readInteger(base + size - 4, 4) != magic)
+			throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+
+		const unsigned char* position = base + readInteger(base + size - footerSize, 8);
+		const unsigned char* end = base + size - footerSize;
+		uint64_t count = readInteger(base + size - 8, 4);
+
+		for(; count > 0; count--)
+			{
+			if(position < base || end - position < 4)
+				throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+			const size_t nameSize = static_cast<size_t>(readInteger(position, 4));
+			if(static_cast<size_t>(end - position) < 4 + nameSize + 24)
+				throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+
+			const string name(position + 4, position + 4 + nameSize);
+			position += 4 + nameSize;
+
+			Table table(base, readInteger(position, 8), readInteger(position + 8, 8), readInteger(position + 16, 8));
+			position += 24;
+
+			if(table.indexOffset + 8 * table.blockCount > size - footerSize)
+				throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+			tables.insert(std::make_pair(name, table));
+			}
+		}
+
+	BerkeleyFrozenStore::~BerkeleyFrozenStore()
+		{
+		// The mapping must be released before the file may be removed
+		region.reset();
+		mapping.reset();
+
+		if(isObsolete)
+			try
+				{ boost::filesystem::remove(path); }
+			// An obsolete store that cannot be removed is merely wasted space
+			catch(boost::filesystem::basic_filesystem_error<boost::filesystem::path>&) { }
+		}
+
+	const BerkeleyFrozenStore::Table* BerkeleyFrozenStore::getTable(const string& name) const
+		{
+		map<string, Table>::const_iterator table = tables.find(name);
+		return table != tables.end() ? &table->second : NULL;
+		}
+
+	bool BerkeleyFrozenStore::Table::seek(const Data& key, const bool inclusive, Position& position) const
+		{
+		if(blockCount == 0)
+			return false;
+
+		// Find the last block that begins before the key (or at it, if not inclusive); entries at the key may
+		// extend back into that block
+		size_t low = 0, high = static_cast<size_t>(blockCount);
+		while(low < high)
+			{
+			const size_t middle = low + (high - low) / 2;
+			Position first;
+			decode(middle, getBlockStart(middle), first);
+
+			const int comparison = compare(first.key, key);
+			if(inclusive ? comparison < 0 : comparison <= 0)
+				low = middle + 1;
+			else
+				high = middle;
+			}
+
+		Position candidate;
+		const size_t block = low > 0 ? low - 1 : 0;
+		decode(block, getBlockStart(block), candidate);
+
+		while(inclusive ? compare(candidate.key, key) < 0 : compare(candidate.key, key) <= 0)
+			if(!next(candidate))
+				return false;
+
+		position = candidate;
+		return true;
+		}
+
+	bool BerkeleyFrozenStore::Table::first(Position& position) const
+		{
+		if(blockCount == 0)
+			return false;
+
+		position.key.clear();
+		decode(0, getBlockStart(0), position);
+		return true;
+		}
+
+	bool BerkeleyFrozenStore::Table::last(Position& position) const
+		{
+		if(blockCount == 0)
+			return false;
+
+		settleLast(static_cast<size_t>(blockCount) - 1, position);
+		return true;
+		}
+
+	bool BerkeleyFrozenStore::Table::next(Position& position) const
+		{
+		if(position.next < getBlockEnd(position.block))
+			decode(position.block, position.next, position);
+		else if(position.block + 1 < blockCount)
+			{
+			position.key.clear();
+			decode(position.block + 1, getBlockStart(position.block + 1), position);
+			}
+		else
+			return false;
+
+		return true;
+		}
+
+	bool BerkeleyFrozenStore::Table::previous(Position& position) const
+		{
+		const size_t start = getBlockStart(position.block);
+
+		if(position.offset > start)
+			{
+			// Keys are stored relative to their predecessor, so we decode forward from the start of the block
+			Position scan;
+			decode(position.block, start, scan);
+			while(scan.next < position.offset)
+				decode(position.block, scan.next, scan);
+			position = scan;
+			}
+		else if(position.block > 0)
+			settleLast(position.block - 1, position);
+		else
+			return false;
+
+		return true;
+		}
+
+	optional<Data> BerkeleyFrozenStore::Table::find(const Data& key) const
+		{
+		Position position;
+		return seek(key, true, position) && compare(position.key, key) == 0
+			? position.getValue()
+			: optional<Data>();
+		}
+
+	size_t BerkeleyFrozenStore::Table::getBlockStart(const size_t block) const
+		{ return static_cast<size_t>(readInteger(base + indexOffset + 8 * block, 8)); }
+
+	size_t BerkeleyFrozenStore::Table::getBlockEnd(const size_t block) const
+		{ return block + 1 < blockCount ? getBlockStart(block + 1) : static_cast<size_t>(indexOffset); }
+
+	void BerkeleyFrozenStore::Table::decode(const size_t block, const size_t offset, Position& position) const
+		{
+		const unsigned char* current = base + offset;
+		const unsigned char* end = base + getBlockEnd(block);
+
+		const size_t shared = static_cast<size_t>(readVariable(current, end));
+		const size_t suffixSize = static_cast<size_t>(readVariable(current, end));
+		if(shared > position.key.size() || static_cast<size_t>(end - current) < suffixSize)
+			throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+
+		position.key.resize(shared);
+		position.key.insert(position.key.end(), current, current + suffixSize);
+		current += suffixSize;
+
+		position.valueSize = static_cast<size_t>(readVariable(current, end));
+		if(static_cast<size_t>(end - current) < position.valueSize)
+			throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+		position.value = current;
+
+		position.block = block;
+		position.offset = offset;
+		position.next = (current + position.valueSize) - base;
+		}
+
+	void BerkeleyFrozenStore::Table::settleLast(const size_t block, Position& position) const
+		{
+		const size_t end = getBlockEnd(block);
+		Position scan;
+
+		decode(block, getBlockStart(block), scan);
+		while(scan.next < end)
+			decode(block, scan.next, scan);
+		position = scan;
+		}
+
+	int BerkeleyFrozenStore::Table::compare(const vector<unsigned char>& key, const Data& other)
+		{
+		const size_t size = std::min(key.size(), other.getSize());
+		const int comparison = size > 0 ? memcmp(&key[0], static_cast<const void*>(other), size) : 0;
+
+		if(comparison != 0)
+			return comparison;
+		else
+			return key.size() < other.getSize() ? -1 : key.size() > other.getSize() ? 1 : 0;
+		}
+
+	BerkeleyFrozenStore::Writer::Writer(const string& path)
+		: path(path), file(fopen(path.c_str(), "wb")), offset(0), isFinished(false)
+		{
+		if(file == NULL)
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, errno);
+		}
+
+	BerkeleyFrozenStore::Writer::~Writer()
+		{
+		if(file != NULL)
+			fclose(file);
+
+		if(!isFinished)
+			try
+				{ boost::filesystem::remove(path); }
+			catch(boost::filesystem::basic_filesystem_error<boost::filesystem::path>&) { }
+		}
+
+	void BerkeleyFrozenStore::Writer::beginTable(const string& name)
+		{
+		if(!tables.empty())
+			endTable();
+
+		TableLocation table = { name, 0, 0, 0 };
+		tables.push_back(table);
+		}
+
+	void BerkeleyFrozenStore::Writer::add(const void* key, const size_t keySize, const void* value, const size_t valueSize)
+		{
+		const unsigned char* keyBytes = static_cast<const unsigned char*>(key);
+		size_t shared = 0;
+
+		if(block.size() >= blockSize)
+			endBlock();
+
+		// The first key in each block is stored in full (and its offset recorded), so that seeks may begin there
+		if(block.empty())
+			{
+			blockOffsets.push_back(offset);
+			previousKey.clear();
+			}
+		else
+			while(shared < keySize && shared < previousKey.size() && previousKey[shared] == keyBytes[shared])
+				shared++;
+
+		appendVariable(block, shared);
+		appendVariable(block, keySize - shared);
+		block.insert(block.end(), keyBytes + shared, keyBytes + keySize);
+		appendVariable(block, valueSize);
+		block.insert(block.end(), static_cast<const unsigned char*>(value), static_cast<const unsigned char*>(value) + valueSize);
+
+		previousKey.assign(keyBytes, keyBytes + keySize);
+		tables.back().recordCount++;
+		}
+
+	void BerkeleyFrozenStore::Writer::finish()
+		{
+		vector<unsigned char> directory;
+
+		endTable();
+		const uint64_t directoryOffset = offset;
+
+		for(vector<TableLocation>::const_iterator table = tables.begin(); table != tables.end(); table++)
+			{
+			appendInteger(directory, table->name.size(), 4);
+			directory.insert(directory.end(), table->name.begin(), table->name.end());
+			appendInteger(directory, table->indexOffset, 8);
+			appendInteger(directory, table->blockCount, 8);
+			appendInteger(directory, table->recordCount, 8);
+			}
+
+		appendInteger(directory, directoryOffset, 8);
+		appendInteger(directory, tables.size(), 4);
+		appendInteger(directory, magic, 4);
+		write(directory);
+
+		if(fflush(file) != 0 || FileSynchronization::synchronize(file) != 0)
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, errno);
+
+		fclose(file);
+		file = NULL;
+		isFinished = true;
+		}
+
+	void BerkeleyFrozenStore::Writer::endBlock()
+		{
+		write(block);
+		block.clear();
+		}
+
+	void BerkeleyFrozenStore::Writer::endTable()
+		{
+		vector<unsigned char> index;
+
+		if(!block.empty())
+			endBlock();
+
+		for(vector<uint64_t>::const_iterator blockOffset = blockOffsets.begin(); blockOffset != blockOffsets.end(); blockOffset++)
+			appendInteger(index, *blockOffset, 8);
+
+		if(!tables.empty())
+			{
+			tables.back().indexOffset = offset;
+			tables.back().blockCount = blockOffsets.size();
+			}
+
+		if(!index.empty())
+			write(index);
+		blockOffsets.clear();
+		}
+
+	void BerkeleyFrozenStore::Writer::write(const vector<unsigned char>& buffer)
+		{
+		if(!buffer.empty() && fwrite(&buffer[0], 1, buffer.size(), file) != buffer.size())
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, errno);
+		offset += buffer.size();
+		}
+
+	void BerkeleyFrozenStore::appendInteger(vector<unsigned char>& buffer, const uint64_t value, const size_t size)
+		{
+		for(size_t index = 0; index < size; index++)
+			buffer.push_back(static_cast<unsigned char>(value >> (8 * index)));
+		}
+
+	void BerkeleyFrozenStore::appendVariable(vector<unsigned char>& buffer, uint64_t value)
+		{
+		// Seven bits per byte, least significant first; the high bit marks a continuation
+		for(; value >= 0x80; value >>= 7)
+			buffer.push_back(static_cast<unsigned char>(value | 0x80));
+		buffer.push_back(static_cast<unsigned char>(value));
+		}
+
+	uint64_t BerkeleyFrozenStore::readInteger(const unsigned char* position, const size_t size)
+		{
+		uint64_t value = 0;
+
+		for(size_t index = 0; index < size; index++)
+			value |= static_cast<uint64_t>(position[index]) << (8 * index);
+		return value;
+		}
+
+	uint64_t BerkeleyFrozenStore::readVariable(const unsigned char*& position, const unsigned char* end)
+		{
+		uint64_t value = 0;
+
+		for(size_t shift = 0; position < end && shift < 64; shift += 7)
+			{
+			const unsigned char byte = *position++;
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			if((byte & 0x80) == 0)
+				return value;
+			}
+
+		throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+		}
+	}
+}
+}
+}
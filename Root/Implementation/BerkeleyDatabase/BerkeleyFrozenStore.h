@@ -0,0 +1,182 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYFROZENSTORE_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYFROZENSTORE_H
+
+#include <map>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "../Data.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB {
+
+	///<summary>
+	/// This class represents a frozen object store: an immutable snapshot of an object store and its indexes,
+	/// written to a single file that is memory-mapped and read without Berkeley DB (and so without its locking,
+	/// transactions or cache).  The file holds a table for the object store and one for each index:
+	///
+	///     [table][table]...[directory][footer]
+	///     table:  [block][block]...[block offsets]
+	///     block:  [record][record]...
+	///     record: [shared key length][key suffix length][key suffix][value length][value]
+	///
+	/// Records are in key (and then value) order, and each key is stored as a suffix of the key before it in
+	/// its block; the first key of a block is stored in full, so that a seek binary-searches the (sparse)
+	/// block offsets before scanning a single block.  Lengths are variable-length integers.  An index table
+	/// maps each secondary key to its primary key.
+	///
+	/// Nothing in a frozen store changes once it is written, so it may be read by any number of threads
+	/// without synchronization.
+	///</summary>
+	class BerkeleyFrozenStore
+		{
+		public:
+			///<summary>
+			/// This class represents a single table in a frozen store.  A table is traversed by moving a
+			/// position, which holds the (decompressed) key of the record at which it rests.
+			///</summary>
+			class Table
+				{
+				public:
+					class Position
+						{
+						public:
+							Position() : block(0), offset(0), next(0), value(NULL), valueSize(0) { }
+
+							Data getKey() const { std::vector<unsigned char> copy(key); return Data(copy); }
+							Data getValue() const
+								{ std::vector<unsigned char> copy(value, value + valueSize); return Data(copy); }
+
+						private:
+							// The block and (absolute) offset of the record, and the offset of the record following it
+							size_t block;
+							size_t offset;
+							size_t next;
+							std::vector<unsigned char> key;
+							const unsigned char* value;
+							size_t valueSize;
+
+							friend class Table;
+						};
+
+					// Positions at the first record with a key ordered after the given key (or at it, if inclusive)
+					bool seek(const Data& key, const bool inclusive, Position& position) const;
+					bool first(Position& position) const;
+					bool last(Position& position) const;
+					// Moves to the following (or preceding) record; returns false (leaving the position unchanged) at the end
+					bool next(Position& position) const;
+					bool previous(Position& position) const;
+
+					// Gets the value of the first record with the given key, if any
+					boost::optional<Data> find(const Data& key) const;
+					boost::uint64_t getRecordCount() const { return recordCount; }
+
+				private:
+					Table(const unsigned char* base, const boost::uint64_t indexOffset, const boost::uint64_t blockCount, const boost::uint64_t recordCount)
+						: base(base), indexOffset(indexOffset), blockCount(blockCount), recordCount(recordCount)
+						{ }
+
+					const unsigned char* base;
+					boost::uint64_t indexOffset;
+					boost::uint64_t blockCount;
+					boost::uint64_t recordCount;
+
+					size_t getBlockStart(const size_t block) const;
+					size_t getBlockEnd(const size_t block) const;
+					// Decodes the record at the given offset, given the key of the record preceding it in its block
+					void decode(const size_t block, const size_t offset, Position& position) const;
+					// Positions at the last record in the given block
+					void settleLast(const size_t block, Position& position) const;
+					static int compare(const std::vector<unsigned char>& key, const Data& other);
+
+					friend class BerkeleyFrozenStore;
+				};
+
+			///<summary>
+			/// This class writes a new frozen store; tables are written one at a time, and records must be added
+			/// to a table in key (and then value) order.  A store that is not finished is removed.
+			///</summary>
+			class Writer
+				{
+				public:
+					explicit Writer(const std::string& path);
+					~Writer();
+
+					// Begins a new table (concluding the previous one); the object store is the table with an empty name
+					void beginTable(const std::string& name);
+					void add(const void* key, const size_t keySize, const void* value, const size_t valueSize);
+					// Completes the store, and flushes it to disk
+					void finish();
+
+				private:
+					struct TableLocation
+						{
+						std::string name;
+						boost::uint64_t indexOffset;
+						boost::uint64_t blockCount;
+						boost::uint64_t recordCount;
+						};
+
+					const std::string path;
+					FILE* file;
+					boost::uint64_t offset;
+					bool isFinished;
+
+					std::vector<TableLocation> tables;
+					std::vector<boost::uint64_t> blockOffsets;
+					std::vector<unsigned char> block;
+					std::vector<unsigned char> previousKey;
+
+					void endBlock();
+					void endTable();
+					void write(const std::vector<unsigned char>& buffer);
+				};
+
+			// Maps the frozen store at the given path; throws DATA_ERR if the file is not a frozen store
+			explicit BerkeleyFrozenStore(const std::string& path);
+			~BerkeleyFrozenStore();
+
+			// Gets the table with the given name (the object store is the table with an empty name), or NULL if there is none
+			const Table* getTable(const std::string& name) const;
+
+			// Marks the store as superseded; its file is removed once the store is no longer in use
+			void markObsolete() const { isObsolete = true; }
+
+			// Identifies a frozen store, and the size of its footer
+			static const boost::uint32_t magic;
+			static const size_t footerSize;
+			// Blocks are concluded once they reach this size
+			static const size_t blockSize;
+
+		private:
+			const std::string path;
+			std::auto_ptr<boost::interprocess::file_mapping> mapping;
+			std::auto_ptr<boost::interprocess::mapped_region> region;
+			std::map<std::string, Table> tables;
+			mutable volatile bool isObsolete;
+
+			// Utility methods used to encode and decode the integers in a frozen store
+			static void appendInteger(std::vector<unsigned char>& buffer, const boost::uint64_t value, const size_t size);
+			static void appendVariable(std::vector<unsigned char>& buffer, boost::uint64_t value);
+			static boost::uint64_t readInteger(const unsigned char* position, const size_t size);
+			static boost::uint64_t readVariable(const unsigned char*& position, const unsigned char* end);
+		};
+	}
+}
+}
+}
+
+#endif
@@ -0,0 +1,54 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <algorithm>
+#include "BerkeleyGroupCommit.h"
+
+using boost::mutex;
+using boost::unique_lock;
+using boost::uint64_t;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	void BerkeleyGroupCommit::flush()
+		{
+		unique_lock<mutex> lock(synchronized);
+		const uint64_t request = ++requested;
+
+		while(flushed < request)
+			if(isFlushing)
+				completed.wait(lock);
+			else
+				{
+				// Every request made so far follows a commit record already written, so one flush satisfies them all
+				const uint64_t satisfied = requested;
+				isFlushing = true;
+				lock.unlock();
+
+				try
+					{ environment.log_flush(NULL); }
+				catch(DbException&)
+					{
+					// Waiters try again for themselves
+					lock.lock();
+					isFlushing = false;
+					completed.notify_all();
+					throw;
+					}
+
+				lock.lock();
+				isFlushing = false;
+				flushed = std::max(flushed, satisfied);
+				completed.notify_all();
+				}
+		}
+	}
+}
+}
+}
@@ -0,0 +1,53 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYGROUPCOMMIT_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYGROUPCOMMIT_H
+
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <db_cxx.h>
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	///<summary>
+	/// This class makes the commits of group-commit transactions durable.  Such a transaction writes (but does not
+	/// flush) its commit record, and then waits here until the log has been flushed past it.  The first waiter
+	/// flushes the log on behalf of every transaction that committed before it began; those that commit while it
+	/// does so wait for the next flush, which is shared in turn.  Concurrent commits thus share a single flush.
+	///</summary>
+	class BerkeleyGroupCommit
+		{
+		public:
+			explicit BerkeleyGroupCommit(DbEnv& environment)
+				: environment(environment), requested(0), flushed(0), isFlushing(false)
+				{ }
+
+			// Returns once the log has been flushed past every commit record written before the call; Berkeley DB
+			// exceptions are left to the caller
+			void flush();
+
+		private:
+			DbEnv& environment;
+			// The number of flushes requested, and the number of requests that a completed flush has satisfied
+			boost::uint64_t requested;
+			boost::uint64_t flushed;
+			// Indicates whether a flush is underway
+			bool isFlushing;
+
+			boost::mutex synchronized;
+			boost::condition_variable completed;
+		};
+	}
+}
+}
+}
+
+#endif
@@ -8,13 +8,17 @@ GNU Lesser General Public License
 #include "BerkeleyDatabase.h"
 #include "BerkeleyObjectStore.h"
 #include "BerkeleyTransaction.h"
+#include "BerkeleyFrozenStore.h"
 #include "../Key.h"
 #include "../KeyGenerator.h"
 #include "../ImplementationException.h"
 #include "../../Support/DatabaseLocation.h"
 
+using std::string;
 using boost::mutex;
 using boost::lock_guard;
+using boost::optional;
+using boost::shared_ptr;
 
 namespace BrandonHaynes {
 namespace IndexedDB { 
@@ -22,9 +26,10 @@ namespace Implementation {
 namespace BerkeleyDB
 	{
 	BerkeleyIndex::BerkeleyIndex(BerkeleyObjectStore& objectStore, const std::string& name, const std::auto_ptr<IndexedDB::Implementation::KeyGenerator>& keyGenerator, const bool unique, TransactionContext& transactionContext, const bool create)
-		: implementation(objectStore.getImplementation().get_env(), 0), isOpen(true)
+		: objectStore(objectStore), name(name), implementation(objectStore.getImplementation().get_env(), 0), isOpen(true)
 		{
 		DatabaseLocation::ensurePathValid(name);
+		BerkeleyDatabase::FromEnvironment(implementation.get_env()).configure(implementation);
 
 		if(!unique)
 			implementation.set_flags(DB_DUPSORT);
@@ -32,8 +37,8 @@ namespace BerkeleyDB
 		//TODO: What happens if an index has the same name as a database?
 		try 
 			{ 
-			implementation.open(BerkeleyTransaction::ToDbTxn(transactionContext), name.c_str(), NULL, DB_BTREE, 
-				DB_AUTO_COMMIT | (create ? DB_CREATE : 0), 0); 
+			BerkeleyDatabase::FromEnvironment(implementation.get_env()).openDatabase(implementation, 
+				BerkeleyTransaction::ToDbTxn(transactionContext), name, DB_BTREE, DB_AUTO_COMMIT | (create ? DB_CREATE : 0)); 
 
 			implementation.set_app_private(static_cast<void*>(keyGenerator.get()));
 
@@ -56,13 +61,22 @@ namespace BerkeleyDB
 
 	Key BerkeleyIndex::getPrimaryKey(const Key& secondaryKey, TransactionContext& transactionContext)
 		{
-		Dbt data, primaryKey;
+		DbTxn* transaction = objectStore.getReadTransaction(transactionContext);
+		BerkeleyDatabase::ReturnedDbt data, primaryKey;
 
 		try
 			{
 			if(!isOpen)
 				throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
-			else if(implementation.pget(BerkeleyTransaction::ToDbTxn(transactionContext), &BerkeleyDatabase::ToDbt(secondaryKey), &primaryKey, &data, 0) == 0)
+
+			// An index frozen along with its object store maps each key to its primary key
+			shared_ptr<const BerkeleyFrozenStore> frozen = objectStore.getFrozen(transaction);
+			if(frozen && frozen->getTable(name) != NULL)
+				{
+				optional<Data> frozenPrimaryKey = frozen->getTable(name)->find(secondaryKey);
+				return frozenPrimaryKey.is_initialized() ? Key(frozenPrimaryKey.get()) : Key::getUndefinedKey();
+				}
+			else if(implementation.pget(transaction, &BerkeleyDatabase::ToDbt(secondaryKey), &primaryKey, &data, 0) == 0)
 				return BerkeleyDatabase::ToKey(primaryKey);
 			else
 				return Key::getUndefinedKey();
@@ -75,14 +89,22 @@ namespace BerkeleyDB
 
 	Data BerkeleyIndex::get(const Key& secondaryKey, TransactionContext& transactionContext)
 		{
-		Dbt data;
+		DbTxn* transaction = objectStore.getReadTransaction(transactionContext);
+		BerkeleyDatabase::ReturnedDbt data;
 
 		try
 			{
 			if(!isOpen)
 				throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
-			else if(implementation.get(BerkeleyTransaction::ToDbTxn(transactionContext), &BerkeleyDatabase::ToDbt(secondaryKey), &data, 0) == 0)
-				return BerkeleyDatabase::ToData(data);
+
+			shared_ptr<const BerkeleyFrozenStore> frozen = objectStore.getFrozen(transaction);
+			if(frozen && frozen->getTable(name) != NULL)
+				{
+				optional<Data> primaryKey = frozen->getTable(name)->find(secondaryKey);
+				return primaryKey.is_initialized() ? objectStore.get(Key(primaryKey.get()), transactionContext) : Data::getUndefinedData();
+				}
+			else if(implementation.get(transaction, &BerkeleyDatabase::ToDbt(secondaryKey), &data, 0) == 0)
+				return BerkeleyDatabase::FromEnvironment(implementation.get_env()).resolveData(data, transaction);
 			else
 				return Data::getUndefinedData();
 			}
@@ -97,11 +119,15 @@ namespace BerkeleyDB
 
 	void BerkeleyIndex::remove(const Key& secondaryKey, TransactionContext& transactionContext)
 		{ 
+		DbTxn* transaction = BerkeleyTransaction::ToDbTxn(transactionContext);
+
 		if(!isOpen)
 			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		else if(objectStore.getFrozen(transaction))
+			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
 
 		try 
-			{ implementation.del(BerkeleyTransaction::ToDbTxn(transactionContext), &BerkeleyDatabase::ToDbt(secondaryKey), 0); }
+			{ implementation.del(transaction, &BerkeleyDatabase::ToDbt(secondaryKey), 0); }
 		catch(DbDeadlockException& e)
 			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
 		catch(DbException& e)
@@ -130,7 +156,8 @@ namespace BerkeleyDB
 			{
 			const KeyGenerator* keyGenerator = static_cast<const KeyGenerator*>(secondary->get_app_private());
 
-			Data& value = BerkeleyDatabase::ToData(*data);
+			// Large values are stored by reference; generate keys from the value itself
+			Data value = BerkeleyDatabase::FromEnvironment(secondary->get_env()).resolveData(*data, NULL);
 			Key indexKey(keyGenerator->generateKey(value));
 
 			void* keyData = malloc(indexKey.getSize());
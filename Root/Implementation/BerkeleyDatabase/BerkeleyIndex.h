@@ -8,6 +8,7 @@ GNU Lesser General Public License
 #define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYINDEX_H
 
 #include <memory>
+#include <string>
 #include <boost/thread/mutex.hpp>
 #include <db_cxx.h>
 #include "../Index.h"
@@ -28,6 +29,7 @@ namespace Implementation {
 		///<summary>
 		/// This class represents an index implementation backed by Berkeley DB.  This index type is 
 		/// associated with a Berkeley DB database and automatically synchronizes keys between the two.
+		/// While its object store is frozen, the index is read from its frozen form (if it was frozen with it).
 		///</summary>
 		class BerkeleyIndex : public Index
 			{
@@ -41,7 +43,14 @@ namespace Implementation {
 				virtual void remove(const Key& secondaryKey, TransactionContext& transactionContext);
 				virtual void close();
 
+				BerkeleyObjectStore& getObjectStore() { return objectStore; }
+				const std::string& getName() const { return name; }
+
 			private:
+				// The object store over which this index is defined
+				BerkeleyObjectStore& objectStore;
+				// The name of this index
+				const std::string name;
 				// The underlying index
 				Db implementation;
 				// Flag indicating whether the underlying index is still open
@@ -7,6 +7,7 @@ GNU Lesser General Public License
 #include "BerkeleyIndexCursor.h"
 #include "BerkeleyIndex.h"
 #include "BerkeleyDatabase.h"
+#include "BerkeleyObjectStore.h"
 #include "../ImplementationException.h"
 
 using boost::mutex;
@@ -17,8 +18,8 @@ namespace IndexedDB {
 namespace Implementation { 
 namespace BerkeleyDB
 	{
-	BerkeleyIndexCursor::BerkeleyIndexCursor(BerkeleyIndex& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool dataArePrimaryKeys, TransactionContext& transactionContext)
-		: BerkeleyCursor(index.implementation, left, right, openLeft, openRight, isReversed, omitDuplicates, transactionContext),
+	BerkeleyIndexCursor::BerkeleyIndexCursor(BerkeleyIndex& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool dataArePrimaryKeys, const Isolation isolation, TransactionContext& transactionContext)
+		: BerkeleyCursor(index.implementation, left, right, openLeft, openRight, isReversed, omitDuplicates, index.getObjectStore().isReadOnly(), isolation, transactionContext),
 		  dataArePrimaryKeys(dataArePrimaryKeys)
 		{ }
 
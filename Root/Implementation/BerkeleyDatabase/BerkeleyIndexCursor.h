@@ -26,7 +26,7 @@ namespace Implementation {
 		class BerkeleyIndexCursor : public BerkeleyCursor
 			{
 			public:
-				BerkeleyIndexCursor(BerkeleyIndex& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool dataArePrimaryKeys, TransactionContext& transactionContext);
+				BerkeleyIndexCursor(BerkeleyIndex& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool dataArePrimaryKeys, const Isolation isolation, TransactionContext& transactionContext);
 				virtual ~BerkeleyIndexCursor() { }
 
 				virtual Data getData(TransactionContext& transactionContext);
@@ -10,10 +10,13 @@ GNU Lesser General Public License
 #include "BerkeleyDatabase.h"
 #include "BerkeleyObjectStore.h"
 #include "BerkeleyTransaction.h"
+#include "BerkeleyFrozenStore.h"
 
 using std::string;
 using boost::mutex;
 using boost::lock_guard;
+using boost::optional;
+using boost::shared_ptr;
 
 namespace BrandonHaynes {
 namespace IndexedDB { 
@@ -22,14 +25,18 @@ namespace BerkeleyDB
 	{
 	BerkeleyManualIndex::BerkeleyManualIndex(BerkeleyObjectStore& objectStore, const string& name, const bool unique, TransactionContext& transactionContext, const bool create)
 		: implementation(objectStore.getImplementation().get_env(), 0), 
-		  objectStore(objectStore)
+		  objectStore(objectStore),
+		  name(name)
 		{
+		BerkeleyDatabase::FromEnvironment(implementation.get_env()).configure(implementation);
+
 		if(!unique)
 			implementation.set_flags(DB_DUPSORT);
 
 		//TODO: What happens if an index has the same name as a database?
 		try 
-			{ implementation.open(BerkeleyTransaction::ToDbTxn(transactionContext), name.c_str(), NULL, DB_BTREE, DB_AUTO_COMMIT | (create ? DB_CREATE : 0), 0); } 
+			{ BerkeleyDatabase::FromEnvironment(implementation.get_env()).openDatabase(implementation, 
+				BerkeleyTransaction::ToDbTxn(transactionContext), name, DB_BTREE, DB_AUTO_COMMIT | (create ? DB_CREATE : 0)); } 
 		catch(DbDeadlockException& e)
 			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
 		catch(DbException& e)
@@ -48,13 +55,22 @@ namespace BerkeleyDB
 
 	Key BerkeleyManualIndex::getPrimaryKey(const Key& secondaryKey, TransactionContext& transactionContext)
 		{
-		Dbt data, primaryKey;
+		DbTxn* transaction = objectStore.getReadTransaction(transactionContext);
+		BerkeleyDatabase::ReturnedDbt primaryKey;
 
 		try
 			{
 			if(!isOpen)
 				throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
-			else if(implementation.get(BerkeleyTransaction::ToDbTxn(transactionContext), &BerkeleyDatabase::ToDbt(secondaryKey), &primaryKey, 0) == 0)
+
+			// Entries without a primary key were omitted when the index was frozen, so none need be checked
+			shared_ptr<const BerkeleyFrozenStore> frozen = objectStore.getFrozen(transaction);
+			if(frozen && frozen->getTable(name) != NULL)
+				{
+				optional<Data> frozenPrimaryKey = frozen->getTable(name)->find(secondaryKey);
+				return frozenPrimaryKey.is_initialized() ? Key(frozenPrimaryKey.get()) : Key::getUndefinedKey();
+				}
+			else if(implementation.get(transaction, &BerkeleyDatabase::ToDbt(secondaryKey), &primaryKey, 0) == 0)
 				return ensurePrimaryKeyExists(primaryKey, secondaryKey, transactionContext);
 			else
 				return Key::getUndefinedKey();
@@ -67,13 +83,21 @@ namespace BerkeleyDB
 
 	Data BerkeleyManualIndex::get(const Key& secondaryKey, TransactionContext& transactionContext)
 		{
-		Dbt primaryKey;
+		DbTxn* transaction = objectStore.getReadTransaction(transactionContext);
+		BerkeleyDatabase::ReturnedDbt primaryKey;
 
 		try
 			{
 			if(!isOpen)
 				throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
-			else if(implementation.get(BerkeleyTransaction::ToDbTxn(transactionContext), &BerkeleyDatabase::ToDbt(secondaryKey), &primaryKey, 0) == 0)
+
+			shared_ptr<const BerkeleyFrozenStore> frozen = objectStore.getFrozen(transaction);
+			if(frozen && frozen->getTable(name) != NULL)
+				{
+				optional<Data> frozenPrimaryKey = frozen->getTable(name)->find(secondaryKey);
+				return frozenPrimaryKey.is_initialized() ? objectStore.get(Key(frozenPrimaryKey.get()), transactionContext) : Data::getUndefinedData();
+				}
+			else if(implementation.get(transaction, &BerkeleyDatabase::ToDbt(secondaryKey), &primaryKey, 0) == 0)
 				return ensurePrimaryKeyExists(objectStore.get(BerkeleyDatabase::ToKey(primaryKey), transactionContext), secondaryKey, transactionContext);
 			else
 				return Data::getUndefinedData();
@@ -88,6 +112,8 @@ namespace BerkeleyDB
 		{ 
 		if(!isOpen)
 			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		else if(objectStore.getFrozen(BerkeleyTransaction::ToDbTxn(transactionContext)))
+			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
 		else if(objectStore.get(Key(primaryKey), transactionContext) == Data::getUndefinedData())
 			throw ImplementationException("CONSTRAINT_ERR", ImplementationException::CONSTRAINT_ERR);
 
@@ -106,6 +132,8 @@ namespace BerkeleyDB
 		{ 
 		if(!isOpen)
 			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		else if(objectStore.getFrozen(BerkeleyTransaction::ToDbTxn(transactionContext)))
+			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
 
 		try 
 			{ 
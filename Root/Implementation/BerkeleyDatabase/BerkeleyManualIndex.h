@@ -25,6 +25,7 @@ namespace BerkeleyDB {
 	/// We use an unassociated Berkeley DB for the index; keys are synchronized automatically, during get and cursor
 	/// operations.  This is a little bit inefficient, but the spec requires we NOT automatically delete primary
 	/// keys during an index delete, and Berkeley DB does not support this.  So we do things the hard way.
+	/// While its object store is frozen, the index is read from its frozen form (if it was frozen with it).
 	///</summary>
 	class BerkeleyManualIndex : public Index
 		{
@@ -38,9 +39,14 @@ namespace BerkeleyDB {
 			virtual void remove(const Key& key, TransactionContext& transactionContext);
 			virtual void close();
 
+			BerkeleyObjectStore& getObjectStore() { return objectStore; }
+			const std::string& getName() const { return name; }
+
 		private:
 			// The object store with which this association is associated
 			BerkeleyObjectStore& objectStore;
+			// The name of this index
+			const std::string name;
 			// The underlying object store that represents this index
 			Db implementation;
 			// Flag indicating whether the index is open
@@ -18,8 +18,8 @@ namespace IndexedDB {
 namespace Implementation { 
 namespace BerkeleyDB
 	{
-	BerkeleyManualIndexCursor::BerkeleyManualIndexCursor(BerkeleyManualIndex& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool dataArePrimaryKeys, TransactionContext& transactionContext)
-		: BerkeleyCursor(index.implementation, left, right, openLeft, openRight, isReversed, omitDuplicates, transactionContext),
+	BerkeleyManualIndexCursor::BerkeleyManualIndexCursor(BerkeleyManualIndex& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool dataArePrimaryKeys, const Isolation isolation, TransactionContext& transactionContext)
+		: BerkeleyCursor(index.implementation, left, right, openLeft, openRight, isReversed, omitDuplicates, index.getObjectStore().isReadOnly(), isolation, transactionContext),
 		  index(index),
 		  dataArePrimaryKeys(dataArePrimaryKeys),
 		  currentValue(Data::getUndefinedData())
@@ -27,7 +27,7 @@ namespace Implementation {
 		class BerkeleyManualIndexCursor : public BerkeleyCursor
 			{
 			public:
-				BerkeleyManualIndexCursor(BerkeleyManualIndex& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool dataArePrimaryKeys, TransactionContext& transactionContext);
+				BerkeleyManualIndexCursor(BerkeleyManualIndex& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool dataArePrimaryKeys, const Isolation isolation, TransactionContext& transactionContext);
 				~BerkeleyManualIndexCursor() { }
 
 				virtual Data getData(TransactionContext& transactionContext);
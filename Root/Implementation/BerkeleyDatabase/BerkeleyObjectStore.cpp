@@ -5,31 +5,42 @@ GNU Lesser General Public License
 \**********************************************************/
 
 #include <atlstr.h>
+#include <cstdlib>
+#include <boost/bind.hpp>
 #include "BerkeleyObjectStore.h"
 #include "BerkeleyDatabase.h"
 #include "BerkeleyTransaction.h"
+#include "BerkeleyBlobStore.h"
+#include "BerkeleyCompression.h"
+#include "BerkeleyFrozenCatalog.h"
 #include "..\ImplementationException.h"
 #include "..\Key.h"
 #include "..\Data.h"
 #include "..\..\Support/DatabaseLocation.h"
 
 using std::string;
+using std::vector;
 using boost::mutex;
 using boost::lock_guard;
+using boost::optional;
+using boost::shared_ptr;
 
 namespace BrandonHaynes {
 namespace IndexedDB { 
 namespace Implementation { 
 namespace BerkeleyDB
 	{
-	BerkeleyObjectStore::BerkeleyObjectStore(BerkeleyDatabase& database, const string& name, const bool autoIncrement, TransactionContext& transactionContext)
-		: implementation(&database.getEnvironment(), 0), readOnly(false), isOpen(true)
+	const size_t BerkeleyObjectStore::compressionSampleSize = 256;
+
+	BerkeleyObjectStore::BerkeleyObjectStore(BerkeleyDatabase& database, const string& name, const bool autoIncrement, const AccessMethod accessMethod, TransactionContext& transactionContext)
+		: database(database), implementation(&database.getEnvironment(), 0), name(name), readOnly(false), accessMethod(accessMethod), isOpen(true), isDictionaryLoaded(false)
 		{
 		DatabaseLocation::ensurePathValid(name);
+		database.configure(getImplementation());
 		DbTxn* transaction = BerkeleyTransaction::ToDbTxn(transactionContext);
 
 		try 
-			{ getImplementation().open(transaction, name.c_str(), NULL, DB_BTREE, DB_EXCL | DB_CREATE | (transaction == NULL ? DB_AUTO_COMMIT : 0), 0); }
+			{ database.openDatabase(getImplementation(), transaction, name, accessMethod == HASHED ? DB_HASH : DB_BTREE, DB_EXCL | DB_CREATE | (transaction == NULL ? DB_AUTO_COMMIT : 0)); }
 		catch(DbException &e) 
 			{ 
 			if(e.get_errno() == EPERM) // Cross-origin attempt!
@@ -40,13 +51,24 @@ namespace BerkeleyDB
 		}
 
 	BerkeleyObjectStore::BerkeleyObjectStore(BerkeleyDatabase& database, const string& name, const Mode mode, const bool create, TransactionContext& transactionContext)
-		: implementation(&database.getEnvironment(), 0), readOnly(mode != ObjectStore::READ_WRITE), isOpen(true)
+		: database(database), implementation(&database.getEnvironment(), 0), name(name), readOnly(mode != ObjectStore::READ_WRITE), accessMethod(ORDERED), isOpen(true), isDictionaryLoaded(false)
 		{
+		DBTYPE type;
+
 		DatabaseLocation::ensurePathValid(name);
+		// Without multi-version databases, a snapshot would hold its read locks (and so block writers) until it closed
+		if(mode == SNAPSHOT_READ && !database.getConfiguration().getSnapshots())
+			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
+		database.configure(getImplementation());
 
+		// An existing object store is opened with whichever access method it was created with
 		try 
-			{ getImplementation().open(BerkeleyTransaction::ToDbTxn(transactionContext), name.c_str(), NULL, DB_BTREE, 
-				(readOnly ? DB_RDONLY : 0) | (create ? DB_CREATE : 0) | DB_AUTO_COMMIT, 0); }
+			{ 
+			database.openDatabase(getImplementation(), BerkeleyTransaction::ToDbTxn(transactionContext), name, create ? DB_BTREE : DB_UNKNOWN, 
+				(readOnly ? DB_RDONLY : 0) | (create ? DB_CREATE : 0) | DB_AUTO_COMMIT); 
+			getImplementation().get_type(&type);
+			accessMethod = type == DB_HASH ? HASHED : ORDERED;
+			}
 		catch(DbException &e)
 			{ 
 			if(e.get_errno() == ENOENT)
@@ -54,6 +76,15 @@ namespace BerkeleyDB
 			else
 				throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno());
 			}
+
+		if(mode == SNAPSHOT_READ)
+			try
+				{ snapshot = BerkeleyTransaction::beginSnapshot(database); }
+			catch(ImplementationException&)
+				{
+				getImplementation().close(0);
+				throw;
+				}
 		}
 
 	BerkeleyObjectStore::~BerkeleyObjectStore()
@@ -61,14 +92,23 @@ namespace BerkeleyDB
 
 	Data BerkeleyObjectStore::get(const Key& key, TransactionContext& transactionContext)
 		{
-		Dbt data;
+		DbTxn* transaction = getReadTransaction(transactionContext);
+		BerkeleyDatabase::ReturnedDbt data;
 
 		try
 			{
 			if(!isOpen)
 				throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
-			else if(getImplementation().get(BerkeleyTransaction::ToDbTxn(transactionContext), &BerkeleyDatabase::ToDbt(key), &data, 0) == 0)
-				return BerkeleyDatabase::ToData(data);
+
+			// A frozen object store is read from its frozen form, without involving Berkeley DB
+			shared_ptr<const BerkeleyFrozenStore> frozen = getFrozen(transaction);
+			if(frozen)
+				{
+				optional<Data> value = frozen->getTable(string())->find(key);
+				return value.is_initialized() ? value.get() : Data::getUndefinedData();
+				}
+			else if(getImplementation().get(transaction, &BerkeleyDatabase::ToDbt(key), &data, 0) == 0)
+				return database.resolveData(data, transaction);
 			else
 				return Data::getUndefinedData();
 			}
@@ -80,10 +120,17 @@ namespace BerkeleyDB
 
 	bool BerkeleyObjectStore::exists(const Key& key, TransactionContext& transactionContext)
 		{
+		DbTxn* transaction = getReadTransaction(transactionContext);
+
 		if(!isOpen)
 			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+
+		shared_ptr<const BerkeleyFrozenStore> frozen = getFrozen(transaction);
+		if(frozen)
+			return frozen->getTable(string())->find(key).is_initialized();
+
 		try
-			{ return getImplementation().exists(BerkeleyTransaction::ToDbTxn(transactionContext), &BerkeleyDatabase::ToDbt(key), 0) != DB_NOTFOUND; }
+			{ return getImplementation().exists(transaction, &BerkeleyDatabase::ToDbt(key), 0) != DB_NOTFOUND; }
 		catch(DbDeadlockException& e)
 			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
 		catch(DbException &e) 
@@ -97,16 +144,56 @@ namespace BerkeleyDB
 		else if(readOnly)
 			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
 
+		DbTxn* transaction = BerkeleyTransaction::ToDbTxn(transactionContext);
+		ensureNotFrozen(transaction);
+		DbTxn* implicitTransaction = beginImplicitTransaction(transaction);
+		DbTxn* activeTransaction = implicitTransaction != NULL ? implicitTransaction : transaction;
+		BerkeleyBlobStore& blobs = database.getBlobStore();
+		Dbt keyDbt = BerkeleyDatabase::ToDbt(key);
+
 		try 
 			{ 
-			getImplementation().put(BerkeleyTransaction::ToDbTxn(transactionContext),
-				&BerkeleyDatabase::ToDbt(key), 
-				&BerkeleyDatabase::ToDbt(data), 
-				noOverwrite ? DB_NOOVERWRITE : 0); }
+			// A large value being overwritten is released once the new value is in place
+			optional<BerkeleyBlobStore::Reference> existing = noOverwrite 
+				? optional<BerkeleyBlobStore::Reference>() 
+				: BerkeleyBlobStore::getReference(getImplementation(), keyDbt, activeTransaction);
+
+			// Values are compressed (if enabled) before we decide whether they belong in the btree
+			optional<Data> compressed = compress(data, activeTransaction);
+			const Data& stored = compressed.is_initialized() ? compressed.get() : data;
+
+			if(!blobs.isLarge(stored))
+				getImplementation().put(activeTransaction, &keyDbt, &BerkeleyDatabase::ToDbt(stored), noOverwrite ? DB_NOOVERWRITE : 0);
+			else
+				{
+				BerkeleyBlobStore::Reference reference = blobs.write(stored, activeTransaction);
+				if(getImplementation().put(activeTransaction, &keyDbt, &Dbt(&reference[0], reference.size()), noOverwrite ? DB_NOOVERWRITE : 0) == DB_KEYEXIST)
+					blobs.release(reference, activeTransaction);
+				}
+
+			if(existing.is_initialized())
+				blobs.release(existing.get(), activeTransaction);
+
+			// A freeze that read past this key before we wrote it was published before we could; see freeze
+			ensureNotFrozen(activeTransaction);
+			}
 		catch(DbDeadlockException &e) 
-			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+			{ 
+			endImplicitTransaction(activeTransaction, implicitTransaction, false);
+			throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); 
+			}
 		catch(DbException &e) 
-			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+			{ 
+			endImplicitTransaction(activeTransaction, implicitTransaction, false);
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); 
+			}
+		catch(ImplementationException&)
+			{
+			endImplicitTransaction(activeTransaction, implicitTransaction, false);
+			throw;
+			}
+
+		endImplicitTransaction(activeTransaction, implicitTransaction, true);
 		}
 	
 	void BerkeleyObjectStore::remove(const Key& key, TransactionContext& transactionContext)
@@ -116,11 +203,313 @@ namespace BerkeleyDB
 		else if(readOnly)
 			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
 
+		DbTxn* transaction = BerkeleyTransaction::ToDbTxn(transactionContext);
+		ensureNotFrozen(transaction);
+		DbTxn* implicitTransaction = beginImplicitTransaction(transaction);
+		DbTxn* activeTransaction = implicitTransaction != NULL ? implicitTransaction : transaction;
+		Dbt keyDbt = BerkeleyDatabase::ToDbt(key);
+
 		try 
-			{ getImplementation().del(BerkeleyTransaction::ToDbTxn(transactionContext), &BerkeleyDatabase::ToDbt(key), 0); }
+			{ 
+			optional<BerkeleyBlobStore::Reference> existing = BerkeleyBlobStore::getReference(getImplementation(), keyDbt, activeTransaction);
+
+			getImplementation().del(activeTransaction, &keyDbt, 0); 
+
+			if(existing.is_initialized())
+				database.getBlobStore().release(existing.get(), activeTransaction);
+
+			// As with put, a freeze may have been published while we waited on its reads
+			ensureNotFrozen(activeTransaction);
+			}
 		catch(DbDeadlockException &e) 
-			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+			{ 
+			endImplicitTransaction(activeTransaction, implicitTransaction, false);
+			throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); 
+			}
 		catch(DbException &e) 
+			{ 
+			endImplicitTransaction(activeTransaction, implicitTransaction, false);
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); 
+			}
+		catch(ImplementationException&)
+			{
+			endImplicitTransaction(activeTransaction, implicitTransaction, false);
+			throw;
+			}
+
+		endImplicitTransaction(activeTransaction, implicitTransaction, true);
+		}
+
+	void BerkeleyObjectStore::ensureCompressed(TransactionContext& transactionContext)
+		{
+		DbTxn* transaction = BerkeleyTransaction::ToDbTxn(transactionContext);
+
+		// A store with too few values to train a dictionary (or one that is frozen) is left uncompressed until it is next opened
+		if(!getFrozen(transaction) && !database.getCompression().getDictionary(name, transaction).is_initialized())
+			try
+				{ enableCompression(transactionContext); }
+			catch(ImplementationException& e)
+				{
+				if(e.code != ImplementationException::DATA_ERR)
+					throw;
+				}
+		}
+
+	void BerkeleyObjectStore::enableCompression(TransactionContext& transactionContext)
+		{
+		if(!isOpen)
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		else if(readOnly)
+			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
+
+		DbTxn* transaction = BerkeleyTransaction::ToDbTxn(transactionContext);
+		ensureNotFrozen(transaction);
+		DbTxn* implicitTransaction = beginImplicitTransaction(transaction);
+		DbTxn* activeTransaction = implicitTransaction != NULL ? implicitTransaction : transaction;
+		BerkeleyCompression& compression = database.getCompression();
+		Dbc* cursor = NULL;
+
+		try
+			{
+			BerkeleyCompression::DictionaryId trained = compression.train(sampleValues(activeTransaction), activeTransaction);
+			compression.setDictionary(name, trained, activeTransaction);
+
+			// Recompress the existing values so that the entire store benefits (large values are left in place)
+			Dbt key, value;
+			vector<unsigned char> compressed;
+
+			getImplementation().cursor(activeTransaction, &cursor, 0);
+			while(cursor->get(&key, &value, DB_NEXT | DB_RMW) == 0)
+				if(!BerkeleyBlobStore::isReference(value))
+					{
+					Data current = database.resolveData(value, activeTransaction);
+					if(isCompressible(current) && compression.compress(current, trained, compressed, activeTransaction))
+						cursor->put(&key, &Dbt(&compressed[0], compressed.size()), DB_CURRENT);
+					}
+			cursor->close();
+			cursor = NULL;
+
+			lock_guard<mutex> guard(synchronization);
+			dictionary = trained;
+			isDictionaryLoaded = true;
+			}
+		catch(DbDeadlockException &e) 
+			{ 
+			if(cursor != NULL) cursor->close();
+			endImplicitTransaction(activeTransaction, implicitTransaction, false);
+			throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); 
+			}
+		catch(DbException &e) 
+			{ 
+			if(cursor != NULL) cursor->close();
+			endImplicitTransaction(activeTransaction, implicitTransaction, false);
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); 
+			}
+		catch(ImplementationException&)
+			{
+			if(cursor != NULL) cursor->close();
+			endImplicitTransaction(activeTransaction, implicitTransaction, false);
+			throw;
+			}
+
+		endImplicitTransaction(activeTransaction, implicitTransaction, true);
+		}
+
+	void BerkeleyObjectStore::freeze(const vector<string>& indexNames, TransactionContext& transactionContext)
+		{
+		if(!isOpen)
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		// A frozen store is written in key order, which a hashed object store does not have; and since a freeze is
+		// published at once, it may not be made within a transaction (which could not undo it)
+		else if(readOnly || accessMethod == HASHED || transactionContext.is_initialized())
+			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
+
+		// Transactions over this store are excluded for the whole freeze, so that none may write behind it
+		std::auto_ptr<BerkeleyScopeLocks::Scope> scope = database.lockScope(vector<string>(1, name), true, optional<unsigned int>());
+		DbTxn* implicitTransaction = beginImplicitTransaction(NULL);
+
+		try
+			{ database.getFrozenCatalog().freeze(name, boost::bind(&BerkeleyObjectStore::writeFrozen, this, _1, boost::cref(indexNames), implicitTransaction)); }
+		catch(DbDeadlockException &e) 
+			{ 
+			endImplicitTransaction(implicitTransaction, implicitTransaction, false);
+			throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); 
+			}
+		catch(DbException &e) 
+			{ 
+			endImplicitTransaction(implicitTransaction, implicitTransaction, false);
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); 
+			}
+		catch(ImplementationException&)
+			{
+			endImplicitTransaction(implicitTransaction, implicitTransaction, false);
+			throw;
+			}
+
+		endImplicitTransaction(implicitTransaction, implicitTransaction, true);
+		}
+
+	void BerkeleyObjectStore::thaw(TransactionContext& transactionContext)
+		{
+		if(!isOpen)
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		// As with a freeze, a thaw is published at once and so may not be made within a transaction
+		else if(readOnly || transactionContext.is_initialized())
+			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
+
+		database.getFrozenCatalog().thaw(name);
+		}
+
+	shared_ptr<const BerkeleyFrozenStore> BerkeleyObjectStore::getFrozen(DbTxn* transaction)
+		{ return database.getFrozenCatalog().get(name, transaction); }
+
+	void BerkeleyObjectStore::ensureNotFrozen(DbTxn* transaction)
+		{
+		if(getFrozen(transaction))
+			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
+		}
+
+	void BerkeleyObjectStore::writeFrozen(BerkeleyFrozenStore::Writer& writer, const vector<string>& indexNames, DbTxn* transaction)
+		{
+		Dbc* cursor = NULL;
+		Dbt key, value;
+
+		// Values are written in their resolved form (neither compressed nor held in the blob store)
+		writer.beginTable(string());
+		getImplementation().cursor(transaction, &cursor, 0);
+		try
+			{
+			while(cursor->get(&key, &value, DB_NEXT) == 0)
+				{
+				Data resolved = database.resolveData(value, transaction);
+				writer.add(key.get_data(), key.get_size(), static_cast<const void*>(resolved), resolved.getSize());
+				}
+			}
+		catch(...)
+			{
+			cursor->close();
+			throw;
+			}
+		cursor->close();
+
+		// Each index maps its keys to primary keys; entries of a manual index whose object no longer exists are omitted
+		for(vector<string>::const_iterator indexName = indexNames.begin(); indexName != indexNames.end(); indexName++)
+			{
+			Db index(&database.getEnvironment(), 0);
+			Dbt primaryKey;
+
+			database.openDatabase(index, transaction, *indexName, DB_UNKNOWN, DB_RDONLY);
+			writer.beginTable(*indexName);
+			index.cursor(transaction, &cursor, 0);
+			try
+				{
+				while(cursor->get(&key, &primaryKey, DB_NEXT) == 0)
+					if(getImplementation().exists(transaction, &primaryKey, 0) != DB_NOTFOUND)
+						writer.add(key.get_data(), key.get_size(), primaryKey.get_data(), primaryKey.get_size());
+				}
+			catch(...)
+				{
+				cursor->close();
+				index.close(0);
+				throw;
+				}
+			cursor->close();
+			index.close(0);
+			}
+		}
+
+	optional<Data> BerkeleyObjectStore::compress(const Data& data, DbTxn* transaction)
+		{
+		vector<unsigned char> compressed;
+
+		if(!isCompressible(data))
+			return optional<Data>();
+
+			{
+			lock_guard<mutex> guard(synchronization);
+			if(!isDictionaryLoaded)
+				{
+				dictionary = database.getCompression().getDictionary(name, transaction);
+				isDictionaryLoaded = true;
+				}
+			}
+
+		if(dictionary.is_initialized() && database.getCompression().compress(data, dictionary.get(), compressed, transaction))
+			return Data(compressed);
+		else
+			return optional<Data>();
+		}
+
+	vector<Data> BerkeleyObjectStore::sampleValues(DbTxn* transaction)
+		{
+		vector<Data> samples;
+		Dbc* cursor = NULL;
+		Dbt key, value;
+		size_t count = 0;
+
+		// Reservoir sampling gives every value an equal chance of selection in a single pass
+		getImplementation().cursor(transaction, &cursor, 0);
+		try
+			{
+			while(cursor->get(&key, &value, DB_NEXT) == 0)
+				if(!BerkeleyBlobStore::isReference(value))
+					{
+					Data current = database.resolveData(value, transaction);
+
+					if(!isCompressible(current))
+						continue;
+					else if(samples.size() < compressionSampleSize)
+						samples.push_back(current);
+					else
+						{
+						size_t index = static_cast<size_t>(rand()) % (count + 1);
+						if(index < compressionSampleSize)
+							samples[index] = current;
+						}
+					count++;
+					}
+			}
+		catch(...)
+			{
+			cursor->close();
+			throw;
+			}
+
+		cursor->close();
+		return samples;
+		}
+
+	bool BerkeleyObjectStore::isCompressible(const Data& data)
+		{ return data.getType() == Data::Object || data.getType() == Data::String; }
+
+	DbTxn* BerkeleyObjectStore::beginImplicitTransaction(DbTxn* transaction)
+		{
+		DbTxn* implicitTransaction = NULL;
+
+		if(transaction == NULL)
+			try
+				{ database.getEnvironment().txn_begin(NULL, &implicitTransaction, 0); }
+			catch(DbException& e)
+				{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+
+		return implicitTransaction;
+		}
+
+	void BerkeleyObjectStore::endImplicitTransaction(DbTxn* transaction, DbTxn* implicitTransaction, const bool commit)
+		{
+		if(implicitTransaction == NULL)
+			return;
+
+		try
+			{
+			if(commit)
+				implicitTransaction->commit(0);
+			else
+				implicitTransaction->abort();
+			}
+		catch(DbDeadlockException& e)
+			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
+		catch(DbException& e)
 			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
 		}
 
@@ -132,26 +521,34 @@ namespace BerkeleyDB
 			try 
 				{ 
 				isOpen = false;
+				// The snapshot is aborted (it wrote nothing) before the database it reads is closed, releasing the
+				// log files and page versions it pinned
+				snapshot.reset();
 				getImplementation().close(0); 
 				}
 			catch(DbException &e) 
 				{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
 		}
 
+	TransactionContext BerkeleyObjectStore::getReadContext(TransactionContext& transactionContext)
+		{ 
+		return transactionContext.is_initialized() || snapshot.get() == NULL
+			? transactionContext
+			: TransactionContext(*snapshot);
+		}
+
+	DbTxn* BerkeleyObjectStore::getReadTransaction(TransactionContext& transactionContext)
+		{ return BerkeleyTransaction::ToDbTxn(getReadContext(transactionContext)); }
+
 	void BerkeleyObjectStore::removeIndex(const string& name, TransactionContext& transactionContext)
 		{
 		if(!isOpen)
 			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
 
-		const char* home;
-		getImplementation().get_env()->get_home(&home);
-
 		try
 			{ 
 			DbTxn* transaction = BerkeleyTransaction::ToDbTxn(transactionContext);
-			getImplementation().get_env()->dbremove(BerkeleyTransaction::ToDbTxn(transactionContext), 
-												(string(home) + "\\" + name).c_str(), NULL, 
-												transaction == NULL ? DB_AUTO_COMMIT : 0); 
+			database.removeDatabase(transaction, name, transaction == NULL ? DB_AUTO_COMMIT : 0); 
 			}
 		catch(DbDeadlockException &e) 
 			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
@@ -8,8 +8,14 @@ GNU Lesser General Public License
 #define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYOBJECTSTORE_H
 
 #include <string>
+#include <vector>
+#include <memory>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 #include <db_cxx.h>
+#include "BerkeleyFrozenStore.h"
 #include "../ObjectStore.h"
 
 namespace boost { class mutex; }
@@ -23,14 +29,23 @@ namespace Implementation {
 	
 	namespace BerkeleyDB {
 		class BerkeleyDatabase;
+		class BerkeleyTransaction;
 
 		///<summary>
 		/// This class represents an Indexed Database API object store; it is backed by a Berkeley DB database.
+		/// While the object store is frozen, reads are served from its frozen form (see BerkeleyFrozenStore).  An
+		/// ordered object store is a btree, and a hashed object store a Berkeley DB hash.  An object store opened in
+		/// snapshot mode reads (outside of any transaction) from a snapshot taken when it was opened.
+		///
+		/// That snapshot is a Berkeley DB snapshot transaction, held open until the object store is closed.  While it
+		/// is open, checkpoints cannot release the log files written since it began, and every page written since is
+		/// kept in the version cache for it (spilling to temporary files once the version cache is full).  A snapshot
+		/// object store should therefore be closed as soon as its reads are done, rather than kept for the life of a page.
 		///</summary>
 		class BerkeleyObjectStore : public ObjectStore
 			{
 			public:
-				BerkeleyObjectStore(BerkeleyDatabase& database, const std::string& name, const bool autoIncrement, TransactionContext& transactionContext);
+				BerkeleyObjectStore(BerkeleyDatabase& database, const std::string& name, const bool autoIncrement, const AccessMethod accessMethod, TransactionContext& transactionContext);
 				BerkeleyObjectStore(BerkeleyDatabase& database, const std::string& name, const Mode mode, const bool create, TransactionContext& transactionContext);
 				~BerkeleyObjectStore(void);
 
@@ -38,24 +53,70 @@ namespace Implementation {
 				virtual void put(const Key& key, const Data& data, const bool noOverwrite, TransactionContext& transactionContext);
 				virtual bool exists(const Key& key, TransactionContext& transactionContext);
 				virtual void remove(const Key& key, TransactionContext& transactionContext);
+				virtual void enableCompression(TransactionContext& transactionContext);
+				virtual void freeze(const std::vector<std::string>& indexNames, TransactionContext& transactionContext);
+				virtual void thaw(TransactionContext& transactionContext);
 				virtual void close();
 		
 				virtual void removeIndex(const std::string& name, TransactionContext& transactionContext);
 
+				// Enables compression for this object store, unless it is already enabled (or the store is too sparse to train a dictionary)
+				void ensureCompressed(TransactionContext& transactionContext);
+
+				// Gets the frozen form of this object store, or an empty pointer if it is not frozen
+				boost::shared_ptr<const BerkeleyFrozenStore> getFrozen(DbTxn* transaction);
+				// Gets the context in which to read, given that of the caller (the snapshot, for an object store
+				// opened in snapshot mode and read outside of any transaction)
+				TransactionContext getReadContext(TransactionContext& transactionContext);
+				DbTxn* getReadTransaction(TransactionContext& transactionContext);
+				const std::string& getName() const { return name; }
+				AccessMethod getAccessMethod() const { return accessMethod; }
+				bool isReadOnly() const { return readOnly; }
+
 				/// Get the underlying implementation associated with this object store.  Would have
 				/// preferred to have not exposed this, but that would have required lots of friends.
 				Db& getImplementation() { return implementation; }
 
 			private:
+				// The database (environment) that owns this object store
+				BerkeleyDatabase& database;
 				// Our backing Berkeley DB database for this object store
 				Db implementation;
+				// The name of this object store
+				const std::string name;
 				// Flag indicating whether this object store is read-only
 				const bool readOnly;
+				// The access method of this object store (a Berkeley DB btree or hash)
+				AccessMethod accessMethod;
+				// The snapshot read by this object store (only if it was opened in snapshot mode); aborted on close
+				std::auto_ptr<BerkeleyTransaction> snapshot;
 				// Flag indicating whether this object store is still open
 				volatile bool isOpen;
 
 				// Used to thread-synch critical sections
 				boost::mutex synchronization;
+
+				// The compression dictionary (if any) associated with this object store, loaded on first use
+				boost::optional<boost::uint32_t> dictionary;
+				bool isDictionaryLoaded;
+				// Maximum number of values sampled when training a compression dictionary
+				static const size_t compressionSampleSize;
+
+				// Compresses the given value, if compression is enabled and worthwhile for this value
+				boost::optional<Data> compress(const Data& data, DbTxn* transaction);
+				// Gets a random sample of the (compressible) values in this object store
+				std::vector<Data> sampleValues(DbTxn* transaction);
+				static bool isCompressible(const Data& data);
+
+				// Writes this object store and the given indexes to a new frozen store
+				void writeFrozen(BerkeleyFrozenStore::Writer& writer, const std::vector<std::string>& indexNames, DbTxn* transaction);
+				// Throws NOT_ALLOWED_ERR if this object store is frozen
+				void ensureNotFrozen(DbTxn* transaction);
+
+				// Begins a transaction for an operation that must be atomic, if the caller did not supply one
+				DbTxn* beginImplicitTransaction(DbTxn* transaction);
+				// Commits (or aborts, on failure) a transaction begun by beginImplicitTransaction
+				static void endImplicitTransaction(DbTxn* transaction, DbTxn* implicitTransaction, const bool commit);
 			};
 		}
 	}
@@ -12,8 +12,8 @@ namespace IndexedDB {
 namespace Implementation { 
 namespace BerkeleyDB
 	{
-	BerkeleyObjectStoreCursor::BerkeleyObjectStoreCursor(BerkeleyObjectStore& objectStore, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, TransactionContext& transactionContext)
-		: BerkeleyCursor(objectStore.getImplementation(), left, right, openLeft, openRight, isReversed, omitDuplicates, transactionContext)
+	BerkeleyObjectStoreCursor::BerkeleyObjectStoreCursor(BerkeleyObjectStore& objectStore, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const Isolation isolation, TransactionContext& transactionContext)
+		: BerkeleyCursor(objectStore.getImplementation(), left, right, openLeft, openRight, isReversed, omitDuplicates, objectStore.isReadOnly(), isolation, transactionContext)
 		{ }
 	}
 }
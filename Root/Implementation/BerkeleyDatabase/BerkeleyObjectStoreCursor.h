@@ -26,7 +26,7 @@ namespace Implementation {
 		class BerkeleyObjectStoreCursor : public BerkeleyCursor
 			{
 			public:
-				BerkeleyObjectStoreCursor(BerkeleyObjectStore& objectStore, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, TransactionContext& transactionContext);
+				BerkeleyObjectStoreCursor(BerkeleyObjectStore& objectStore, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const Isolation isolation, TransactionContext& transactionContext);
 			};
 		}
 	}
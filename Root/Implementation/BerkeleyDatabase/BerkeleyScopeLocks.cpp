@@ -0,0 +1,140 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <set>
+#include <algorithm>
+#include <boost/thread/thread_time.hpp>
+#include "BerkeleyScopeLocks.h"
+#include "../ImplementationException.h"
+
+using std::map;
+using std::set;
+using std::vector;
+using std::string;
+using boost::mutex;
+using boost::lock_guard;
+using boost::unique_lock;
+using boost::optional;
+using boost::shared_ptr;
+using boost::weak_ptr;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	map<string, weak_ptr<BerkeleyScopeLocks> > BerkeleyScopeLocks::instances;
+	mutex BerkeleyScopeLocks::instancesSynchronization;
+	const bool BerkeleyScopeLocks::compatible[4][4] = {
+		//					INTENT_SHARED	INTENT_EXCLUSIVE	SHARED	EXCLUSIVE
+		/* INTENT_SHARED */	{ true,			true,				true,	false },
+		/* INTENT_EXCLUSIVE */	{ true,			true,				false,	false },
+		/* SHARED */			{ true,			false,				true,	false },
+		/* EXCLUSIVE */		{ false,		false,				false,	false } };
+
+	shared_ptr<BerkeleyScopeLocks> BerkeleyScopeLocks::getInstance(const string& home)
+		{
+		lock_guard<mutex> guard(instancesSynchronization);
+		shared_ptr<BerkeleyScopeLocks> locks = instances[home].lock();
+
+		if(!locks)
+			{
+			locks.reset(new BerkeleyScopeLocks());
+			instances[home] = locks;
+			}
+
+		return locks;
+		}
+
+	std::auto_ptr<BerkeleyScopeLocks::Scope> BerkeleyScopeLocks::lock(const optional<vector<string> >& objectStoreNames, const bool exclusive, 
+		const boost::posix_time::time_duration& timeout)
+		{
+		unique_lock<mutex> lock(synchronized);
+		const boost::system_time deadline = boost::get_system_time() + timeout;
+		const boost::thread::id thread = boost::this_thread::get_id();
+		LockList requested;
+
+		if(!objectStoreNames.is_initialized())
+			requested.push_back(std::make_pair(&database, exclusive ? EXCLUSIVE : SHARED));
+		else
+			{
+			const set<string> names(objectStoreNames->begin(), objectStoreNames->end());
+			requested.push_back(std::make_pair(&database, exclusive ? INTENT_EXCLUSIVE : INTENT_SHARED));
+			for(set<string>::const_iterator name = names.begin(); name != names.end(); name++)
+				requested.push_back(std::make_pair(&objectStores[*name], exclusive ? EXCLUSIVE : SHARED));
+			}
+
+		// We would otherwise wait on ourselves for the whole of our timeout
+		if(!isGrantable(requested) && isHeldBy(requested, thread))
+			throw ImplementationException("TIMEOUT_ERR", ImplementationException::TIMEOUT_ERR);
+
+		waiting.push_back(&requested);
+		while(!isGrantable(requested) && released.timed_wait(lock, deadline))
+			;
+
+		const bool granted = isGrantable(requested);
+		waiting.remove(&requested);
+
+		if(!granted)
+			{
+			// Those queued behind us (and only in conflict with us) may now proceed
+			released.notify_all();
+			throw ImplementationException("TIMEOUT_ERR", ImplementationException::TIMEOUT_ERR);
+			}
+
+		for(LockList::const_iterator iterator = requested.begin(); iterator != requested.end(); iterator++)
+			iterator->first->holders[iterator->second].insert(thread);
+
+		return std::auto_ptr<Scope>(new Scope(shared_from_this(), requested, thread));
+		}
+
+	bool BerkeleyScopeLocks::isGrantable(const LockList& requested) const
+		{
+		for(LockList::const_iterator iterator = requested.begin(); iterator != requested.end(); iterator++)
+			for(int held = INTENT_SHARED; held <= EXCLUSIVE; held++)
+				if(!iterator->first->holders[held].empty() && !compatible[iterator->second][held])
+					return false;
+
+		// A scope never overtakes one requested before it with which it conflicts
+		for(std::list<const LockList*>::const_iterator earlier = waiting.begin(); *earlier != &requested; earlier++)
+			if(isConflicting(**earlier, requested))
+				return false;
+
+		return true;
+		}
+
+	bool BerkeleyScopeLocks::isHeldBy(const LockList& requested, const boost::thread::id& thread) const
+		{
+		for(LockList::const_iterator iterator = requested.begin(); iterator != requested.end(); iterator++)
+			for(int held = INTENT_SHARED; held <= EXCLUSIVE; held++)
+				if(!compatible[iterator->second][held] && iterator->first->holders[held].count(thread) > 0)
+					return true;
+
+		return false;
+		}
+
+	bool BerkeleyScopeLocks::isConflicting(const LockList& left, const LockList& right)
+		{
+		for(LockList::const_iterator leftLock = left.begin(); leftLock != left.end(); leftLock++)
+			for(LockList::const_iterator rightLock = right.begin(); rightLock != right.end(); rightLock++)
+				if(leftLock->first == rightLock->first && !compatible[leftLock->second][rightLock->second])
+					return true;
+
+		return false;
+		}
+
+	void BerkeleyScopeLocks::release(const LockList& held, const boost::thread::id& thread)
+		{
+		lock_guard<mutex> guard(synchronized);
+
+		for(LockList::const_iterator iterator = held.begin(); iterator != held.end(); iterator++)
+			iterator->first->holders[iterator->second].erase(iterator->first->holders[iterator->second].find(thread));
+		released.notify_all();
+		}
+	}
+}
+}
+}
@@ -0,0 +1,117 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYSCOPELOCKS_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_BERKELEYDB_BERKELEYSCOPELOCKS_H
+
+#include <map>
+#include <set>
+#include <list>
+#include <vector>
+#include <string>
+#include <memory>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace BerkeleyDB
+	{
+	///<summary>
+	/// This class schedules transactions by locking the scope of each (the object stores it declares, or the whole
+	/// database) when it begins, so that transactions whose scopes conflict run one after another while the rest run
+	/// concurrently.  A scope is locked for reading (shared) or writing (exclusive); a scope of object stores also
+	/// holds an intention lock on the database, which conflicts only with a whole-database scope.  Conflicting
+	/// transactions are queued first come, first served: a scope is granted all at once, and only when it conflicts
+	/// neither with the scopes held nor with those requested before it (so that writers are not starved, and since
+	/// nothing is held while waiting, waiting for a scope can never deadlock).  A scope that cannot be granted in the
+	/// given time is not locked at all.
+	///
+	/// A scope that conflicts with one held by the calling thread itself could only be granted once that thread
+	/// released it, which it cannot do while it waits; rather than wait out its timeout, such a scope fails at once.
+	///
+	/// Every handle on an environment in this process shares the same locks.
+	///</summary>
+	class BerkeleyScopeLocks : public boost::enable_shared_from_this<BerkeleyScopeLocks>
+		{
+		private:
+			// The modes in which a node may be held (intention modes apply only to the database)
+			enum Mode { INTENT_SHARED = 0, INTENT_EXCLUSIVE = 1, SHARED = 2, EXCLUSIVE = 3 };
+
+			// A lockable node (the database, or one of its object stores) and the threads holding it in each mode
+			struct Node
+				{
+				std::multiset<boost::thread::id> holders[4];
+				};
+
+			typedef std::vector<std::pair<Node*, Mode> > LockList;
+
+		public:
+			///<summary>
+			/// This class represents a locked scope; its locks are released when it is destroyed.  This class is RAII.
+			///</summary>
+			class Scope
+				{
+				public:
+					~Scope() { locks->release(held, thread); }
+
+				private:
+					Scope(const boost::shared_ptr<BerkeleyScopeLocks>& locks, const LockList& held, const boost::thread::id& thread)
+						: locks(locks), held(held), thread(thread)
+						{ }
+
+					const boost::shared_ptr<BerkeleyScopeLocks> locks;
+					const LockList held;
+					// The thread that locked the scope
+					const boost::thread::id thread;
+
+					friend class BerkeleyScopeLocks;
+				};
+
+			// Gets the locks shared by every handle on the environment at the given home
+			static boost::shared_ptr<BerkeleyScopeLocks> getInstance(const std::string& home);
+
+			// Locks the named object stores (or the whole database, if none are named) for reading or writing, once every
+			// conflicting scope requested earlier has been released; throws TIMEOUT_ERR if the scope could not be locked
+			// within the given time (which it does at once if the scope conflicts with one held by the calling thread)
+			std::auto_ptr<Scope> lock(const boost::optional<std::vector<std::string> >& objectStoreNames, const bool exclusive, 
+				const boost::posix_time::time_duration& timeout);
+
+		private:
+			Node database;
+			std::map<std::string, Node> objectStores;
+
+			// The scopes waiting to be locked, in the order in which they were requested
+			std::list<const LockList*> waiting;
+
+			boost::mutex synchronized;
+			boost::condition_variable released;
+
+			// The locks of each environment in use in this process, by home
+			static std::map<std::string, boost::weak_ptr<BerkeleyScopeLocks> > instances;
+			static boost::mutex instancesSynchronization;
+			// Indicates which modes may be held at once (by mode requested, then mode held)
+			static const bool compatible[4][4];
+
+			bool isGrantable(const LockList& requested) const;
+			// Determines whether the given thread holds a scope that conflicts with the one requested
+			bool isHeldBy(const LockList& requested, const boost::thread::id& thread) const;
+			static bool isConflicting(const LockList& left, const LockList& right);
+			void release(const LockList& held, const boost::thread::id& thread);
+		};
+	}
+}
+}
+}
+
+#endif
@@ -7,29 +7,65 @@ GNU Lesser General Public License
 #include <db_cxx.h>
 #include "BerkeleyTransaction.h"
 #include "BerkeleyDatabase.h"
+#include "BerkeleyGroupCommit.h"
+#include "BerkeleyObjectStore.h"
 #include "../ObjectStore.h"
 #include "../ImplementationException.h"
 
 using ::std::list;
+using ::std::vector;
+using ::std::string;
 using ::boost::optional;
+using ::boost::mutex;
+using ::boost::lock_guard;
 
 namespace BrandonHaynes {
 namespace IndexedDB { 
 namespace Implementation { 
 namespace BerkeleyDB
 	{
-	BerkeleyTransaction::BerkeleyTransaction(BerkeleyDatabase& database, const ObjectStoreImplementationList& objectStores, const optional<unsigned int>& timeout, TransactionContext& transactionContext)
+	BerkeleyTransaction::BerkeleyTransaction(BerkeleyDatabase& database, const ObjectStoreImplementationList& objectStores, const optional<ObjectStore::Mode>& mode, const optional<unsigned int>& timeout, const optional<DatabaseConfiguration::Durability>& durability, TransactionContext& transactionContext)
+		: database(database)
 		{
-		//TODO We're not locking the object stores per spec
+		const DatabaseConfiguration::Durability effectiveDurability = durability.get_value_or(database.getConfiguration().getDurability());
+		// A nested transaction is made durable (or not) along with its parent
+		isGroupCommit = effectiveDurability == DatabaseConfiguration::GROUP_COMMIT && ToDbTxn(transactionContext) == NULL;
+
+		if(mode.is_initialized())
+			{
+			optional<vector<string> > objectStoreNames;
+			if(objectStores.is_initialized())
+				{
+				objectStoreNames = vector<string>();
+				for(list<ObjectStore*>::const_iterator iterator = objectStores->begin(); iterator != objectStores->end(); iterator++)
+					objectStoreNames->push_back(static_cast<BerkeleyObjectStore*>(*iterator)->getName());
+				}
+
+			// Only a writer needs its scope to itself; the locks are released when the transaction ends
+			scope = database.lockScope(objectStoreNames, mode.get() == ObjectStore::READ_WRITE, timeout);
+			}
+
 		try
 			{ 
-			database.getEnvironment().txn_begin(ToDbTxn(transactionContext), &transaction, 0); 
+			database.getEnvironment().txn_begin(ToDbTxn(transactionContext), &transaction, ToFlags(effectiveDurability)); 
 			if(timeout.is_initialized()) transaction->set_timeout(timeout.get(), DB_SET_TXN_TIMEOUT);
 			}
 		catch(DbException e)
 			{ throw ImplementationException(e.what(), ImplementationException::UNKNOWN_ERR, e.get_errno()); }
 		}
 
+	BerkeleyTransaction::BerkeleyTransaction(BerkeleyDatabase& database)
+		: database(database), isGroupCommit(false)
+		{
+		try
+			{ database.getEnvironment().txn_begin(NULL, &transaction, DB_TXN_SNAPSHOT); }
+		catch(DbException e)
+			{ throw ImplementationException(e.what(), ImplementationException::UNKNOWN_ERR, e.get_errno()); }
+		}
+
+	std::auto_ptr<BerkeleyTransaction> BerkeleyTransaction::beginSnapshot(BerkeleyDatabase& database)
+		{ return std::auto_ptr<BerkeleyTransaction>(new BerkeleyTransaction(database)); }
+
 	BerkeleyTransaction::~BerkeleyTransaction()
 		{ 
 		try
@@ -41,6 +77,8 @@ namespace BerkeleyDB
 
 	void BerkeleyTransaction::commit()
 		{ 
+		lock_guard<mutex> guard(synchronization);
+
 		if(!isActive())
 			throw ImplementationException(ImplementationException::NON_TRANSIENT_ERR);
 
@@ -52,10 +90,20 @@ namespace BerkeleyDB
 			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
 
 		transaction = NULL;
+		scope.reset();
+
+		// The commit record has been written, but not flushed; we return once a (shared) flush has passed it
+		if(isGroupCommit)
+			try
+				{ database.getGroupCommit().flush(); }
+			catch(DbException &e) 
+				{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
 		}
 
 	void BerkeleyTransaction::abort()
 		{ 
+		lock_guard<mutex> guard(synchronization);
+
 		if(!isActive())
 			throw ImplementationException(ImplementationException::NON_TRANSIENT_ERR);
 		
@@ -63,12 +111,29 @@ namespace BerkeleyDB
 		this->transaction = NULL;
 
 		try
-			{ transaction->abort(); }
+			{ 
+			transaction->abort(); 
+			scope.reset();
+			}
 		catch(DbDeadlockException& e)
 			{ throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR, e.get_errno()); }
 		catch(DbException &e) 
 			{ throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, e.get_errno()); }
 		}
+
+	u_int32_t BerkeleyTransaction::ToFlags(const DatabaseConfiguration::Durability durability)
+		{
+		switch(durability)
+			{
+			case DatabaseConfiguration::WRITE_NO_SYNC:
+			case DatabaseConfiguration::GROUP_COMMIT:
+				return DB_TXN_WRITE_NOSYNC;
+			case DatabaseConfiguration::NO_SYNC:
+				return DB_TXN_NOSYNC;
+			default:
+				return DB_TXN_SYNC;
+			}
+		}
 	}
 }
 }
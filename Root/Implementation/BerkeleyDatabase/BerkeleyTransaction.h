@@ -10,8 +10,11 @@ GNU Lesser General Public License
 #include <boost/optional.hpp>
 #include <boost/thread/mutex.hpp>
 #include <list>
+#include <memory>
 #include "../Transaction.h"
 #include "../ObjectStore.h"
+#include "../DatabaseConfiguration.h"
+#include "BerkeleyScopeLocks.h"
 
 class ::DbTxn;
 
@@ -26,14 +29,20 @@ namespace BerkeleyDB {
 	/// This class represents a transaction backed by a Berkeley DB transaction; it is used both for
 	/// the singleton transaction in the Indexed Database API, and also for other internal operations
 	/// that are transactional.  Thus, implementations cannot assumed that it will represent "the" Indexed Database
-	/// API singleton.
+	/// API singleton.  A top-level transaction commits with the requested durability (or that configured for the
+	/// database).  A transaction begun with a scope mode first locks its scope (the object stores it declares, or the whole
+	/// database) in that mode; see BerkeleyScopeLocks.  A snapshot transaction reads the database as it was when the transaction began, without blocking
+	/// (or being blocked by) writers.  A transaction may be shared by threads; its commit and abort are serialized.
 	///</summary>
 	class BerkeleyTransaction : public Transaction
 		{
 		public:
-			BerkeleyTransaction(BerkeleyDatabase& database, const ObjectStoreImplementationList& objectStores, const boost::optional<unsigned int>& timeout, TransactionContext& transactionContext);
+			BerkeleyTransaction(BerkeleyDatabase& database, const ObjectStoreImplementationList& objectStores, const boost::optional<ObjectStore::Mode>& mode, const boost::optional<unsigned int>& timeout, const boost::optional<DatabaseConfiguration::Durability>& durability, TransactionContext& transactionContext);
 			virtual ~BerkeleyTransaction();
 
+			// Begins a (read-only) snapshot transaction over the given database
+			static std::auto_ptr<BerkeleyTransaction> beginSnapshot(BerkeleyDatabase& database);
+
 			virtual void commit();
 			virtual void abort();
 
@@ -48,12 +57,22 @@ namespace BerkeleyDB {
 		private:
 			// The Berkeley DB transaction that backs this class
 			DbTxn* transaction;
+			// The database in which this transaction was begun
+			BerkeleyDatabase& database;
+			// The locks held over the scope of this transaction (only if it was begun with a scope mode)
+			std::auto_ptr<BerkeleyScopeLocks::Scope> scope;
+			// Flag indicating whether this transaction shares a flush of the log with concurrent commits
+			bool isGroupCommit;
 
-			// Used for thread safety within critical sectinos
+			// Serializes commit and abort, which may be called from different threads
 			boost::mutex synchronization;
 
+			explicit BerkeleyTransaction(BerkeleyDatabase& database);
+
 			// Helper method to determine if this transaction remains active
 			const bool isActive() const { return transaction != NULL; }
+			// Helper method to convert a durability into the flags with which a Berkeley DB transaction is begun
+			static u_int32_t ToFlags(const DatabaseConfiguration::Durability durability);
 		};
 	}
 }
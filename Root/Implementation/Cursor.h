@@ -23,6 +23,11 @@ namespace Implementation {
 	class Cursor
 		{
 		public:
+			// The isolation with which a cursor reads: a serializable cursor holds a read lock on everything it visits
+			// until its transaction ends, a read-committed cursor only on the page at which it is positioned, and a
+			// read-uncommitted cursor takes no read locks at all (and so may read writes that are later aborted)
+			enum Isolation { SERIALIZABLE = 0, READ_COMMITTED = 1, READ_UNCOMMITTED = 2 };
+
 			virtual ~Cursor() { }
 
 			// Gets the key associated with the current cursor position
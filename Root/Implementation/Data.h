@@ -22,7 +22,7 @@ namespace Implementation {
 		{
 		public:
 			// An enumeration of available ECMA types (see ECMA-262 5th Ed 8)
-			enum ECMAType { Undefined, Null, Boolean, Number, Integer, String, Object };
+			enum ECMAType { Undefined, Null, Boolean, Number, Integer, String, Object, Array, Binary, Date };
 
 			// Utility method to generate an undefined data value
 			static const Data getUndefinedData() { return Data(0, 0, Data::Undefined); }
@@ -39,6 +39,11 @@ namespace Implementation {
 			Data(const std::string& value)
 				{ initializeData(data, Data::String, value.c_str(), value.size() + 1); }
 
+			// Creates a data value by taking ownership of an already-encoded buffer (a type byte followed 
+			// by the raw value); the contents of the given buffer are swapped out and it is left empty
+			explicit Data(std::vector<unsigned char>& encoded)
+				{ data.swap(encoded); }
+
 			// Gets the type associated with this data instance
 			const Data::ECMAType getType() const { return (Data::ECMAType)data[0]; }
 			// Gets the raw data associated with this instance
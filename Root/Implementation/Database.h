@@ -7,6 +7,8 @@ GNU Lesser General Public License
 #ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_DATABASE_H
 #define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_DATABASE_H
 
+#include <string>
+#include <boost/optional.hpp>
 #include "Transaction.h"
 
 namespace BrandonHaynes {
@@ -14,6 +16,7 @@ namespace IndexedDB {
 namespace Implementation { 
 
 	class ObjectStore;
+	class AbstractDatabaseFactory;
 
 	///<summary>
 	/// This class represents a data value in the Indexed Database API implementation.  Data instances
@@ -29,6 +32,17 @@ namespace Implementation {
 			
 			// Gets the metadata associated with this database
 			virtual ObjectStore& getMetadata() = 0;
+
+			// Gets the factory for the engine that backs this database
+			virtual AbstractDatabaseFactory& getFactory() = 0;
+
+			// Gets the position in the log (e.g. "3/1024") of the most recent checkpoint, if the engine keeps a
+			// log and has taken a checkpoint
+			virtual boost::optional<std::string> getLastCheckpoint() { return boost::optional<std::string>(); }
+			// Takes a checkpoint now (blocking until it is complete), if the engine keeps a log
+			virtual void checkpoint() { }
+			// Gets the number of database files the engine holds open (each with a file handle), if it tracks them
+			virtual boost::optional<size_t> getOpenFileCount() { return boost::optional<size_t>(); }
 		};
 	}
 }
@@ -0,0 +1,205 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/ini_parser.hpp>
+#include <boost/algorithm/string.hpp>
+#include "DatabaseConfiguration.h"
+#include "ImplementationException.h"
+#include "../Support/DatabaseLocation.h"
+
+using std::string;
+using boost::uint32_t;
+using boost::uint64_t;
+using boost::property_tree::ptree;
+using boost::property_tree::ini_parser_error;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+
+	const string DatabaseConfiguration::fileName = "indexedDB.ini";
+	const string DatabaseConfiguration::defaultSection = "default";
+
+	DatabaseConfiguration DatabaseConfiguration::load(const string& origin, const string& databaseName)
+		{
+		DatabaseConfiguration configuration;
+		const string path = DatabaseLocation::getConfigurationPath(origin, fileName);
+		ptree sections;
+
+		if(!boost::filesystem::exists(path))
+			return configuration;
+
+		try
+			{ boost::property_tree::ini_parser::read_ini(path, sections); }
+		catch(ini_parser_error& e)
+			{ throw ImplementationException(e.what(), ImplementationException::NON_TRANSIENT_ERR); }
+
+		// Settings specific to the database override those that apply to the whole origin (we avoid
+		// get_child here, since a database name may contain the property tree path separator)
+		const string names[] = { defaultSection, databaseName };
+		for(size_t index = 0; index < sizeof(names) / sizeof(names[0]); index++)
+			{
+			ptree::const_assoc_iterator section = sections.find(names[index]);
+			if(section != sections.not_found())
+				for(ptree::const_iterator setting = section->second.begin(); setting != section->second.end(); setting++)
+					configuration.set(setting->first, setting->second.data());
+			}
+
+		return configuration;
+		}
+
+	void DatabaseConfiguration::set(const string& setting, const string& value)
+		{
+		const string trimmed = boost::trim_copy(value);
+
+		if(boost::iequals(setting, "engine"))
+			engine = boost::to_lower_copy(trimmed);
+		else if(boost::iequals(setting, "cacheSize"))
+			cacheSize = parseSize(trimmed);
+		else if(boost::iequals(setting, "cacheBudget"))
+			cacheBudget = parseSize(trimmed);
+		else if(boost::iequals(setting, "versionCacheSize"))
+			versionCacheSize = parseSize(trimmed);
+		else if(boost::iequals(setting, "logFileSize"))
+			logFileSize = parseSmallSize(trimmed);
+		else if(boost::iequals(setting, "logBufferSize"))
+			logBufferSize = parseSmallSize(trimmed);
+		else if(boost::iequals(setting, "lockTimeout"))
+			lockTimeout = parseDuration(trimmed);
+		else if(boost::iequals(setting, "transactionTimeout"))
+			transactionTimeout = parseDuration(trimmed);
+		else if(boost::iequals(setting, "scopeTimeout"))
+			scopeTimeout = parseDuration(trimmed);
+		else if(boost::iequals(setting, "checkpointLogSize"))
+			checkpointLogSize = parseSmallSize(trimmed);
+		else if(boost::iequals(setting, "checkpointInterval"))
+			checkpointInterval = parseDuration(trimmed);
+		else if(boost::iequals(setting, "pageSize"))
+			{
+			uint64_t size = parseSize(trimmed);
+			// Page sizes must be a power of two between 512 bytes and 64KB
+			if(size < 512 || size > 65536 || (size & (size - 1)) != 0)
+				throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+			pageSize = static_cast<uint32_t>(size);
+			}
+		else if(boost::iequals(setting, "durability"))
+			durability = parseDurability(trimmed);
+		else if(boost::iequals(setting, "compression"))
+			compression = parseFlag(trimmed);
+		else if(boost::iequals(setting, "snapshots"))
+			snapshots = parseFlag(trimmed);
+		else if(boost::iequals(setting, "layout"))
+			layout = parseLayout(trimmed);
+		else
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		}
+
+	uint64_t DatabaseConfiguration::parseSize(const string& value)
+		{
+		// Sizes are given in bytes, optionally suffixed by a (binary) unit, e.g. "64K" or "16MB"
+		string digits = boost::to_upper_copy(value);
+		uint64_t multiplier = 1;
+
+		if(boost::ends_with(digits, "B"))
+			digits.erase(digits.size() - 1);
+		if(boost::ends_with(digits, "K"))
+			multiplier = 1024;
+		else if(boost::ends_with(digits, "M"))
+			multiplier = 1024 * 1024;
+		else if(boost::ends_with(digits, "G"))
+			multiplier = 1024 * 1024 * 1024;
+		if(multiplier != 1)
+			digits.erase(digits.size() - 1);
+
+		if(digits.empty() || digits.find_first_not_of("0123456789") != string::npos)
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+
+		try
+			{ return boost::lexical_cast<uint64_t>(digits) * multiplier; }
+		catch(boost::bad_lexical_cast&)
+			{ throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR); }
+		}
+
+	uint32_t DatabaseConfiguration::parseSmallSize(const string& value)
+		{
+		const uint64_t size = parseSize(value);
+
+		if(size == 0 || size > 0xFFFFFFFF)
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		return static_cast<uint32_t>(size);
+		}
+
+	uint32_t DatabaseConfiguration::parseDuration(const string& value)
+		{
+		// Durations are given in microseconds, optionally suffixed by a unit, e.g. "2500us", "500ms" or "2s"
+		string digits = boost::to_lower_copy(value);
+		uint64_t multiplier = 1;
+
+		if(boost::ends_with(digits, "us"))
+			digits.erase(digits.size() - 2);
+		else if(boost::ends_with(digits, "ms"))
+			{
+			digits.erase(digits.size() - 2);
+			multiplier = 1000;
+			}
+		else if(boost::ends_with(digits, "s"))
+			{
+			digits.erase(digits.size() - 1);
+			multiplier = 1000 * 1000;
+			}
+
+		if(digits.empty() || digits.find_first_not_of("0123456789") != string::npos)
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+
+		try
+			{
+			const uint64_t duration = boost::lexical_cast<uint64_t>(digits) * multiplier;
+			if(duration > 0xFFFFFFFF)
+				throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+			return static_cast<uint32_t>(duration);
+			}
+		catch(boost::bad_lexical_cast&)
+			{ throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR); }
+		}
+
+	bool DatabaseConfiguration::parseFlag(const string& value)
+		{
+		if(boost::iequals(value, "true") || value == "1")
+			return true;
+		else if(boost::iequals(value, "false") || value == "0")
+			return false;
+		else
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		}
+
+	DatabaseConfiguration::Durability DatabaseConfiguration::parseDurability(const string& value)
+		{
+		if(boost::iequals(value, "durable"))
+			return DURABLE;
+		else if(boost::iequals(value, "writeNoSync"))
+			return WRITE_NO_SYNC;
+		else if(boost::iequals(value, "noSync"))
+			return NO_SYNC;
+		else if(boost::iequals(value, "groupCommit"))
+			return GROUP_COMMIT;
+		else
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		}
+
+	DatabaseConfiguration::Layout DatabaseConfiguration::parseLayout(const string& value)
+		{
+		if(boost::iequals(value, "files"))
+			return FILE_PER_OBJECT_STORE;
+		else if(boost::iequals(value, "singleFile"))
+			return SINGLE_FILE;
+		else
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		}
+}
+}
+}
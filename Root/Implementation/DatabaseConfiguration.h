@@ -0,0 +1,143 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_DATABASECONFIGURATION_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_DATABASECONFIGURATION_H
+
+#include <string>
+#include <boost/optional.hpp>
+#include <boost/cstdint.hpp>
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+
+	///<summary>
+	/// This class represents the engine (and engine tuning) selected for a database when it is opened.  Settings
+	/// are read from the configuration file for the origin (if any), where a [default] section applies to every
+	/// database and a section named for a database applies to that database alone; settings passed when the
+	/// database is opened are applied last.  For example:
+	///
+	///     [default]
+	///     engine = berkeleydb
+	///     cacheSize = 16777216
+	///     cacheBudget = 256MB
+	///     lockTimeout = 500ms
+	///     scopeTimeout = 5s
+	///     checkpointInterval = 30s
+	///
+	///     [scratch]
+	///     engine = memory
+	///
+	/// Tuning that does not apply to the selected engine (e.g. the page size of an in-memory database) is ignored.
+	///</summary>
+	class DatabaseConfiguration
+		{
+		public:
+			// The degree to which a committed transaction is guaranteed to survive a failure
+			enum Durability {
+				// Survives an operating system or hardware failure (the log is flushed on commit)
+				DURABLE = 0,
+				// Survives a failure of the application (the log is written, but not flushed, on commit)
+				WRITE_NO_SYNC = 1,
+				// May be lost on any failure (the log is written only as its buffer fills)
+				NO_SYNC = 2,
+				// Survives an operating system or hardware failure, but the commits of concurrent transactions share
+				// a single flush of the log (operations outside of a transaction are simply durable)
+				GROUP_COMMIT = 3 };
+
+			// The arrangement of the object stores and indexes of a database on disk
+			enum Layout {
+				// Each object store and index is a file of its own
+				FILE_PER_OBJECT_STORE = 0,
+				// Every object store and index is a named sub-database of a single file
+				SINGLE_FILE = 1 };
+
+			DatabaseConfiguration()
+				: durability(DURABLE), compression(false), snapshots(false), layout(FILE_PER_OBJECT_STORE)
+				{ }
+
+			// Loads the configuration for the given database from the configuration file for its origin
+			static DatabaseConfiguration load(const std::string& origin, const std::string& databaseName);
+
+			// Applies a named setting, given in its textual form; throws NON_TRANSIENT_ERR if the setting
+			// is unknown or its value is invalid
+			void set(const std::string& setting, const std::string& value);
+
+			// The engine backing the database (the default engine, if empty)
+			const std::string& getEngine() const { return engine; }
+			// The size (in bytes) of the cache for the database, if other than the engine default
+			const boost::optional<boost::uint64_t>& getCacheSize() const { return cacheSize; }
+			// The size (in bytes) to which the cache may be grown as the database is used; if given, the engine
+			// tunes the size of its cache within this budget
+			const boost::optional<boost::uint64_t>& getCacheBudget() const { return cacheBudget; }
+			// The size (in bytes) of the cache set aside for the page versions read by snapshots (if enabled), if other
+			// than the engine default; versions kept for a long-lived snapshot beyond this size spill to temporary files
+			const boost::optional<boost::uint64_t>& getVersionCacheSize() const { return versionCacheSize; }
+			// The page size (in bytes) for newly-created object stores and indexes, if other than the engine default
+			const boost::optional<boost::uint32_t>& getPageSize() const { return pageSize; }
+			// The maximum size (in bytes) of each log file, and the size of the in-memory log buffer, if other than the engine default
+			const boost::optional<boost::uint32_t>& getLogFileSize() const { return logFileSize; }
+			const boost::optional<boost::uint32_t>& getLogBufferSize() const { return logBufferSize; }
+			// The time (in microseconds) after which a lock request or a transaction expires, if other than the engine default
+			const boost::optional<boost::uint32_t>& getLockTimeout() const { return lockTimeout; }
+			const boost::optional<boost::uint32_t>& getTransactionTimeout() const { return transactionTimeout; }
+			// The time (in microseconds) for which a transaction waits to lock its scope, if other than the engine default.
+			// The wait blocks the calling thread until transactions on other threads release a conflicting scope, so it is
+			// typically measured in seconds rather than in the microseconds of a lock timeout; a scope that conflicts with one
+			// held on the calling thread (i.e. any other, on the browser thread) fails without waiting.
+			const boost::optional<boost::uint32_t>& getScopeTimeout() const { return scopeTimeout; }
+			// The volume of log (in bytes) and the time (in microseconds) after which the engine takes a checkpoint,
+			// if other than the engine default; together these bound the work of recovery after a failure
+			const boost::optional<boost::uint32_t>& getCheckpointLogSize() const { return checkpointLogSize; }
+			const boost::optional<boost::uint32_t>& getCheckpointInterval() const { return checkpointInterval; }
+			// The durability of committed transactions (individual transactions may request otherwise)
+			Durability getDurability() const { return durability; }
+			// Flag indicating whether object stores opened for writing should have compression enabled
+			bool getCompression() const { return compression; }
+			// Flag indicating whether object stores may be opened for snapshot reads.  Snapshots are multi-version, so
+			// while enabled every write copies the pages it changes and the cache is enlarged to hold their versions.
+			bool getSnapshots() const { return snapshots; }
+			// The arrangement of object stores and indexes for a newly-created database
+			Layout getLayout() const { return layout; }
+
+			// The name of the per-origin configuration file (e.g. "indexedDB.ini")
+			static const std::string fileName;
+
+		private:
+			std::string engine;
+			boost::optional<boost::uint64_t> cacheSize;
+			boost::optional<boost::uint32_t> pageSize;
+			boost::optional<boost::uint64_t> cacheBudget;
+			boost::optional<boost::uint64_t> versionCacheSize;
+			boost::optional<boost::uint32_t> logFileSize;
+			boost::optional<boost::uint32_t> logBufferSize;
+			boost::optional<boost::uint32_t> lockTimeout;
+			boost::optional<boost::uint32_t> transactionTimeout;
+			boost::optional<boost::uint32_t> scopeTimeout;
+			boost::optional<boost::uint32_t> checkpointLogSize;
+			boost::optional<boost::uint32_t> checkpointInterval;
+			Durability durability;
+			bool compression;
+			bool snapshots;
+			Layout layout;
+
+			// The section whose settings apply to every database in an origin (e.g. "default")
+			static const std::string defaultSection;
+
+			// Utility methods to parse setting values; throw NON_TRANSIENT_ERR on failure
+			static boost::uint64_t parseSize(const std::string& value);
+			static boost::uint32_t parseSmallSize(const std::string& value);
+			static boost::uint32_t parseDuration(const std::string& value);
+			static bool parseFlag(const std::string& value);
+			static Durability parseDurability(const std::string& value);
+			static Layout parseLayout(const std::string& value);
+		};
+	}
+}
+}
+
+#endif
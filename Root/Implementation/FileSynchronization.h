@@ -0,0 +1,46 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_FILESYNCHRONIZATION_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_FILESYNCHRONIZATION_H
+
+#include <cstdio>
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32) || defined(__CYGWIN__)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+
+	///<summary>
+	/// This utility class forces the contents of a file out to stable storage, for those of our stores that
+	/// write their own files alongside Berkeley DB.  Callers flush the stdio buffer first.
+	///</summary>
+	class FileSynchronization
+		{
+		public:
+			// Synchronizes the given (flushed) file with the underlying device; returns zero on success
+			static int synchronize(FILE* file)
+				{
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32) || defined(__CYGWIN__)
+				return _commit(_fileno(file));
+#else
+				return fsync(fileno(file));
+#endif
+				}
+
+		private:
+			FileSynchronization() { }
+		};
+	}
+}
+}
+
+#endif
@@ -31,9 +31,15 @@ namespace Implementation {
 			virtual Key getPrimaryKey(const Key& secondaryKey, TransactionContext& transactionContext) = 0;
 
 		private:
-			// We don't implement this part of the object store interface, so shield it from consumers
+			// We don't implement these parts of the object store interface, so shield them from consumers
 			void removeIndex(const std::string& name, TransactionContext& transactionContext) 
 				{ throw ImplementationException(ImplementationException::NOT_ALLOWED_ERR); } 
+			void enableCompression(TransactionContext& transactionContext) 
+				{ throw ImplementationException(ImplementationException::NOT_ALLOWED_ERR); } 
+			void freeze(const std::vector<std::string>& indexNames, TransactionContext& transactionContext)
+				{ throw ImplementationException(ImplementationException::NOT_ALLOWED_ERR); }
+			void thaw(TransactionContext& transactionContext)
+				{ throw ImplementationException(ImplementationException::NOT_ALLOWED_ERR); }
 		};
 	}
 }
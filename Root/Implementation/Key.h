@@ -41,6 +41,11 @@ namespace Implementation {
 				: Data(value)
 				{ }
 
+			// Creates a key by taking ownership of an already-encoded buffer (see Data)
+			explicit Key(std::vector<unsigned char>& encoded)
+				: Data(encoded)
+				{ }
+
 			// Create a key based off of another Data instance (or Key instance)
 			Key(const Data& data)
 				: Data(data)
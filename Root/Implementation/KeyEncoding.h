@@ -0,0 +1,247 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_KEYENCODING_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_KEYENCODING_H
+
+#include <cstring>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include "Data.h"
+#include "ImplementationException.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+
+	///<summary>
+	/// This utility class implements the order-preserving encoding used for compound (array) keys.
+	/// An array key is encoded as a sequence of elements, each consisting of a type byte followed by
+	/// an encoding of the value whose unsigned byte order matches the natural order of the value, and
+	/// is closed by a zero terminator.  Since the encoded form sorts correctly under a bytewise
+	/// comparison, array keys may be used with the default btree comparison, in index keys and as
+	/// key range bounds.
+	///
+	/// Integers and floating-point numbers share a single type byte and are both stored as doubles,
+	/// big-endian with their sign bit flipped (and complemented when negative), so that numeric elements
+	/// order by value regardless of their representation; strings and binary values are terminated with a pair of zero bytes, with embedded
+	/// zeros escaped as 0x00 0xFF.
+	/// Nested arrays are encoded recursively.  Undefined and null values may not appear in an array key.
+	///
+	/// Dates use the same big-endian, sign-flipped representation of their millisecond timestamp both 
+	/// inside and outside of an array key, so a date key occupies nine bytes and sorts chronologically.
+	///</summary>
+	class KeyEncoding
+		{
+		public:
+			// Appends the order-preserving encoding of the given element to an array key buffer
+			static void appendElement(std::vector<unsigned char>& buffer, const Data& element)
+				{
+				const unsigned char* value = static_cast<const unsigned char*>(element.getRawValue());
+				size_t size = element.getSize() - 1;
+
+				switch(element.getType())
+					{
+					case Data::Boolean:
+						buffer.push_back(Data::Boolean);
+						buffer.push_back(*reinterpret_cast<const bool*>(value) ? 1 : 0);
+						break;
+					case Data::Integer:
+						{
+						boost::int32_t integer;
+						memcpy(&integer, value, sizeof(integer));
+						buffer.push_back(Data::Number);
+						appendBigEndian(buffer, encodeDouble(static_cast<double>(integer)), sizeof(double));
+						break;
+						}
+					case Data::Number:
+						{
+						double number;
+						memcpy(&number, value, sizeof(number));
+						buffer.push_back(Data::Number);
+						appendBigEndian(buffer, encodeDouble(number), sizeof(number));
+						break;
+						}
+					case Data::String:
+					case Data::Object:
+						// Both are stored zero-terminated; the terminator is replaced by our own
+						buffer.push_back(static_cast<unsigned char>(element.getType()));
+						appendEscaped(buffer, value, size > 0 ? size - 1 : 0);
+						break;
+					case Data::Binary:
+						buffer.push_back(Data::Binary);
+						appendEscaped(buffer, value, size);
+						break;
+					case Data::Date:
+						// Dates are order-preserving as stored
+						buffer.push_back(Data::Date);
+						buffer.insert(buffer.end(), value, value + size);
+						break;
+					case Data::Array:
+						// Nested arrays are already encoded (and terminated)
+						buffer.push_back(Data::Array);
+						buffer.insert(buffer.end(), value, value + size);
+						break;
+					default:
+						throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+					}
+				}
+
+			// Creates a date value from the given millisecond timestamp
+			static Data fromMilliseconds(const boost::int64_t milliseconds)
+				{
+				std::vector<unsigned char> buffer(1, Data::Date);
+				appendBigEndian(buffer, static_cast<boost::uint64_t>(milliseconds) ^ 0x8000000000000000ULL, sizeof(milliseconds));
+				return Data(buffer);
+				}
+
+			// Gets the millisecond timestamp associated with a date value
+			static boost::int64_t toMilliseconds(const Data& date)
+				{
+				const unsigned char* position = static_cast<const unsigned char*>(date.getRawValue());
+
+				if(date.getType() != Data::Date || position == NULL)
+					throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+
+				return static_cast<boost::int64_t>(readBigEndian(position, position + date.getSize() - 1, sizeof(boost::int64_t)) ^ 0x8000000000000000ULL);
+				}
+
+			// Closes an array key buffer
+			static void appendTerminator(std::vector<unsigned char>& buffer)
+				{ buffer.push_back(static_cast<unsigned char>(terminator)); }
+
+			// Decodes the elements of an array key into their (non-compound) data representations
+			static std::vector<Data> decodeArray(const Data& array)
+				{
+				std::vector<Data> elements;
+				const unsigned char* position = static_cast<const unsigned char*>(array.getRawValue());
+				const unsigned char* end = position + array.getSize() - 1;
+
+				if(array.getType() != Data::Array || position == NULL)
+					throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+
+				while(position < end && *position != terminator)
+					elements.push_back(decodeElement(position, end));
+
+				return elements;
+				}
+
+		private:
+			enum Marker { terminator = 0x00, escape = 0xFF };
+
+			KeyEncoding() { }
+
+			static void appendBigEndian(std::vector<unsigned char>& buffer, boost::uint64_t value, size_t size)
+				{
+				for(size_t index = size; index > 0; index--)
+					buffer.push_back(static_cast<unsigned char>(value >> ((index - 1) * 8)));
+				}
+
+			static boost::uint64_t readBigEndian(const unsigned char*& position, const unsigned char* end, size_t size)
+				{
+				boost::uint64_t value = 0;
+
+				if(position + size > end)
+					throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+				for(size_t index = 0; index < size; index++)
+					value = (value << 8) | *position++;
+				return value;
+				}
+
+			static boost::uint64_t encodeDouble(const double value)
+				{
+				boost::uint64_t bits;
+				memcpy(&bits, &value, sizeof(bits));
+				return bits & 0x8000000000000000ULL ? ~bits : bits ^ 0x8000000000000000ULL;
+				}
+
+			static double decodeDouble(const boost::uint64_t encoded)
+				{
+				boost::uint64_t bits = encoded & 0x8000000000000000ULL ? encoded ^ 0x8000000000000000ULL : ~encoded;
+				double value;
+				memcpy(&value, &bits, sizeof(value));
+				return value;
+				}
+
+			static void appendEscaped(std::vector<unsigned char>& buffer, const unsigned char* value, size_t size)
+				{
+				for(size_t index = 0; index < size; index++)
+					{
+					buffer.push_back(value[index]);
+					if(value[index] == terminator)
+						buffer.push_back(static_cast<unsigned char>(escape));
+					}
+				buffer.push_back(static_cast<unsigned char>(terminator));
+				buffer.push_back(static_cast<unsigned char>(terminator));
+				}
+
+			static Data decodeElement(const unsigned char*& position, const unsigned char* end)
+				{
+				Data::ECMAType type = static_cast<Data::ECMAType>(*position++);
+
+				switch(type)
+					{
+					case Data::Boolean:
+						{
+						bool value = readBigEndian(position, end, 1) != 0;
+						return Data(&value, sizeof(value), Data::Boolean);
+						}
+					case Data::Number:
+						{
+						double value = decodeDouble(readBigEndian(position, end, sizeof(value)));
+						boost::int32_t integer = static_cast<boost::int32_t>(value);
+
+						// Integral values are handed back as integers, as they would have been converted originally
+						if(value >= -2147483648.0 && value <= 2147483647.0 && static_cast<double>(integer) == value)
+							return Data(&integer, sizeof(integer), Data::Integer);
+						else
+							return Data(&value, sizeof(value), Data::Number);
+						}
+					case Data::Date:
+						{
+						const unsigned char* start = position;
+						readBigEndian(position, end, sizeof(boost::int64_t));
+						return Data(start, sizeof(boost::int64_t), Data::Date);
+						}
+					case Data::String:
+					case Data::Object:
+					case Data::Binary:
+						{
+						std::vector<unsigned char> value(1, static_cast<unsigned char>(type));
+						while(position + 1 < end && !(position[0] == terminator && position[1] == terminator))
+							{
+							value.push_back(*position);
+							position += *position == terminator ? 2 : 1;
+							}
+						if(position + 1 >= end)
+							throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+						position += 2;
+						// Strings are stored zero-terminated outside of an array key; binary values are not
+						if(type != Data::Binary)
+							value.push_back(static_cast<unsigned char>(terminator));
+						return Data(value);
+						}
+					case Data::Array:
+						{
+						// Scan past the nested elements to find the extent of the nested array
+						const unsigned char* start = position;
+						while(position < end && *position != terminator)
+							decodeElement(position, end);
+						if(position >= end)
+							throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+						position++;
+						return Data(start, position - start, Data::Array);
+						}
+					default:
+						throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+					}
+				}
+		};
+	}
+}
+}
+
+#endif
@@ -0,0 +1,72 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <algorithm>
+#include "LsmBloomFilter.h"
+#include "../Data.h"
+
+using std::vector;
+using boost::uint32_t;
+using boost::uint64_t;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Lsm
+	{
+	const size_t LsmBloomFilter::bitsPerKey = 10;
+
+	LsmBloomFilter::LsmBloomFilter(const size_t expectedKeys)
+		// The false positive rate is minimized with (bits per key * ln 2) hash functions
+		: bits((std::max<size_t>(expectedKeys * bitsPerKey, 64) + 7) / 8), hashCount(7)
+		{ }
+
+	LsmBloomFilter::LsmBloomFilter(const vector<unsigned char>& bits, const unsigned int hashCount)
+		: bits(bits), hashCount(hashCount)
+		{ }
+
+	void LsmBloomFilter::add(const Data& key)
+		{
+		const uint64_t value = hash(key);
+		const uint32_t delta = static_cast<uint32_t>(value >> 32) | 1;
+		uint32_t position = static_cast<uint32_t>(value);
+
+		// Double hashing derives each of the hash functions from a single hash of the key
+		for(unsigned int index = 0; index < hashCount; index++, position += delta)
+			bits[(position % (bits.size() * 8)) / 8] |= 1 << (position % 8);
+		}
+
+	bool LsmBloomFilter::mayContain(const Data& key) const
+		{
+		const uint64_t value = hash(key);
+		const uint32_t delta = static_cast<uint32_t>(value >> 32) | 1;
+		uint32_t position = static_cast<uint32_t>(value);
+
+		if(bits.empty())
+			return true;
+
+		for(unsigned int index = 0; index < hashCount; index++, position += delta)
+			if((bits[(position % (bits.size() * 8)) / 8] & (1 << (position % 8))) == 0)
+				return false;
+
+		return true;
+		}
+
+	uint64_t LsmBloomFilter::hash(const Data& key)
+		{
+		// 64-bit FNV-1a over the encoded key
+		const unsigned char* value = static_cast<const unsigned char*>(static_cast<const void*>(key));
+		uint64_t result = 14695981039346656037ULL;
+
+		for(size_t index = 0; index < key.getSize(); index++)
+			result = (result ^ value[index]) * 1099511628211ULL;
+
+		return result;
+		}
+	}
+}
+}
+}
@@ -0,0 +1,53 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMBLOOMFILTER_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMBLOOMFILTER_H
+
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+
+	class Data;
+
+	namespace Lsm {
+
+		///<summary>
+		/// This class represents a Bloom filter over the keys in a run.  A lookup for a key that the filter
+		/// excludes need not read the run at all; with ten bits per key, roughly one lookup in a hundred for an
+		/// absent key is a false positive.
+		///</summary>
+		class LsmBloomFilter
+			{
+			public:
+				// Creates an empty filter sized for the given number of keys
+				explicit LsmBloomFilter(const size_t expectedKeys);
+				// Creates a filter from its (previously written) bits
+				LsmBloomFilter(const std::vector<unsigned char>& bits, const unsigned int hashCount);
+
+				void add(const Data& key);
+				// Determines whether the given key may have been added (false positives are possible, false negatives are not)
+				bool mayContain(const Data& key) const;
+
+				const std::vector<unsigned char>& getBits() const { return bits; }
+				unsigned int getHashCount() const { return hashCount; }
+
+			private:
+				std::vector<unsigned char> bits;
+				unsigned int hashCount;
+
+				static const size_t bitsPerKey;
+				static boost::uint64_t hash(const Data& key);
+			};
+		}
+	}
+}
+}
+
+#endif
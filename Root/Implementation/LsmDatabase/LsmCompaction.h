@@ -0,0 +1,117 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMCOMPACTION_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMCOMPACTION_H
+
+#include <memory>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include "../ImplementationException.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB { 
+namespace Implementation { 
+namespace Lsm
+	{
+	///<summary>
+	/// This class is spawned on a per-LsmStorage basis; it merges runs in the background, both on an interval
+	/// and whenever notified (e.g. after a memtable is flushed).  This class is fully managed by LsmStorage,
+	/// including initiation and termination.  This class is RAII.
+	///</summary>
+	class LsmCompaction
+		{
+		public:
+			// Create a compaction thread that invokes the given compaction method at (at most) the given interval
+			LsmCompaction(const boost::function<void()>& compaction, int millisecondsBetweenCompaction)
+				: isRunning(false), 
+				  isRequested(false),
+				  compaction(compaction), 
+				  millisecondsBetweenCompaction(millisecondsBetweenCompaction)
+				{ }
+
+			~LsmCompaction()
+				{ stop(); }
+
+			// Start compaction on this thread
+			void start()
+				{ 
+				boost::lock_guard<boost::mutex> guard(synchronized);
+				if(!isRunning)
+					{
+					isRunning = true; 
+					compactionThread = std::auto_ptr<boost::thread>(new boost::thread(boost::bind(
+						&LsmCompaction::compact, this)));
+					}
+				}
+
+			// Conclude compaction on this thread (after any compaction in progress completes)
+			void stop()
+				{
+					{
+					boost::lock_guard<boost::mutex> guard(synchronized);
+					if(!isRunning)
+						return;
+					isRunning = false;
+					}
+
+				requested.notify_one();
+				compactionThread->join();
+				}
+
+			// Requests a compaction without waiting for the interval to elapse
+			void notify()
+				{
+					{
+					boost::lock_guard<boost::mutex> guard(synchronized);
+					isRequested = true;
+					}
+
+				requested.notify_one();
+				}
+
+		private:
+			// The thead associated with this class
+			std::auto_ptr<boost::thread> compactionThread;
+			// Several operations need to be synchronized; we use a Boost mutex for this purpose
+			boost::mutex synchronized;
+			boost::condition_variable requested;
+			// Indicates whether our thread is currently running, and whether a compaction has been requested
+			volatile bool isRunning;
+			bool isRequested;
+			const boost::function<void()> compaction;
+			const int millisecondsBetweenCompaction;
+		    
+			// Method fired once every interval (or when notified); performs any compaction that is warranted
+			void compact()
+				{
+				boost::unique_lock<boost::mutex> guard(synchronized);
+
+				// Automatically terminate whenever the isRunning flag is cleared
+				while(isRunning)
+					{
+					isRequested = false;
+					guard.unlock();
+
+					// A failed compaction leaves its inputs in place; we simply try again later
+					try
+						{ compaction(); }
+					catch(ImplementationException&) { }
+
+					guard.lock();
+					if(isRunning && !isRequested)
+						requested.timed_wait(guard, boost::posix_time::milliseconds(millisecondsBetweenCompaction));
+					}
+				}
+		};
+	}
+}
+}
+}
+
+#endif
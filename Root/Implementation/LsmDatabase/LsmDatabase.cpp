@@ -0,0 +1,27 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include "LsmDatabase.h"
+#include "LsmDatabaseFactory.h"
+#include "LsmStorage.h"
+
+using std::string;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Lsm
+	{
+	LsmDatabase::LsmDatabase(const string& origin, const string& name, const string& description, const bool modifyDatabase, const DatabaseConfiguration& configuration)
+		: MemoryDatabase(LsmStorage::getInstance(origin, name, configuration), name)
+		{ }
+
+	AbstractDatabaseFactory& LsmDatabase::getFactory()
+		{ return AbstractDatabaseFactory::getInstance(LsmDatabaseFactory::engineName); }
+	}
+}
+}
+}
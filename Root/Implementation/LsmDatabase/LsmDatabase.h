@@ -0,0 +1,38 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMDATABASE_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMDATABASE_H
+
+#include <string>
+#include "../MemoryDatabase/MemoryDatabase.h"
+#include "../DatabaseConfiguration.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Lsm {
+
+	///<summary>
+	/// This class represents an Indexed Database API database held in a log-structured merge tree, which
+	/// favors write-heavy workloads: a commit appends to a log rather than updating pages in place.  Object
+	/// stores, indexes, cursors and transactions are those of the in-memory engine; only the storage of the
+	/// tables differs (see LsmStorage).  The cache size bounds the memtables, and the page size sets the size
+	/// of the blocks in a run; compression is ignored.
+	///</summary>
+	class LsmDatabase : public Memory::MemoryDatabase
+		{
+		public:
+			LsmDatabase(const std::string& origin, const std::string& name, const std::string& description, const bool modifyDatabase, const DatabaseConfiguration& configuration);
+
+			virtual AbstractDatabaseFactory& getFactory();
+		};
+	}
+}
+}
+}
+
+#endif
@@ -0,0 +1,25 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include "LsmDatabaseFactory.h"
+#include "LsmDatabase.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Lsm
+	{
+	using ::std::auto_ptr;
+	using ::std::string;
+
+	const string LsmDatabaseFactory::engineName = "lsm";
+
+	auto_ptr<Database> LsmDatabaseFactory::createDatabase(const string& origin, const string& name, const string& description, const bool modifyDatabase, const DatabaseConfiguration& configuration)
+		{ return auto_ptr<Database>(new LsmDatabase(origin, name, description, modifyDatabase, configuration)); }
+	}
+}
+}
+}
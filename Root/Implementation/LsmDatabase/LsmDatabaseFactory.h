@@ -0,0 +1,38 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMDATABASEFACTORY_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMDATABASEFACTORY_H
+
+#include "../MemoryDatabase/MemoryDatabaseFactory.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Lsm {
+
+	///<summary>
+	/// This class is a concrete realization of the abstract implementation factory; it produces databases
+	/// held in a log-structured merge tree.  Everything created over such a database is produced by the
+	/// in-memory engine.
+	///</summary>
+	class LsmDatabaseFactory : public Memory::MemoryDatabaseFactory
+		{
+		public:
+			LsmDatabaseFactory(void) { }
+			~LsmDatabaseFactory(void) { }
+
+			// The name by which this engine is selected (e.g. "lsm")
+			static const std::string engineName;
+
+			virtual std::auto_ptr<Database> createDatabase(const std::string& origin, const std::string& name, const std::string& description, const bool modifyDatabase = true, const DatabaseConfiguration& configuration = DatabaseConfiguration());
+		};
+	}
+}
+}
+}
+
+#endif
@@ -0,0 +1,96 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMENCODING_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMENCODING_H
+
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include "../Data.h"
+#include "../ImplementationException.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Lsm {
+
+	///<summary>
+	/// This utility class encodes and decodes the fields of the files written by the LSM engine (the log, the
+	/// manifest and the runs).  Integers are written little-endian, and variable-length fields are preceded
+	/// by their size.  Decoding past the end of a buffer throws DATA_ERR, since the file must be corrupt.
+	///</summary>
+	class LsmEncoding
+		{
+		public:
+			static void appendInteger(std::vector<unsigned char>& buffer, const boost::uint64_t value, const size_t size)
+				{
+				for(size_t index = 0; index < size; index++)
+					buffer.push_back(static_cast<unsigned char>(value >> (8 * index)));
+				}
+
+			static void appendBytes(std::vector<unsigned char>& buffer, const void* value, const size_t size)
+				{
+				appendInteger(buffer, size, 4);
+				buffer.insert(buffer.end(), static_cast<const unsigned char*>(value), static_cast<const unsigned char*>(value) + size);
+				}
+
+			static void appendData(std::vector<unsigned char>& buffer, const Data& data)
+				{ appendBytes(buffer, static_cast<const void*>(data), data.getSize()); }
+
+			static void appendString(std::vector<unsigned char>& buffer, const std::string& value)
+				{ appendBytes(buffer, value.data(), value.size()); }
+
+			static boost::uint64_t readInteger(const std::vector<unsigned char>& buffer, size_t& position, const size_t size)
+				{
+				boost::uint64_t value = 0;
+
+				ensureAvailable(buffer, position, size);
+				for(size_t index = 0; index < size; index++)
+					value |= static_cast<boost::uint64_t>(buffer[position + index]) << (8 * index);
+
+				position += size;
+				return value;
+				}
+
+			static Data readData(const std::vector<unsigned char>& buffer, size_t& position)
+				{
+				size_t size = static_cast<size_t>(readInteger(buffer, position, 4));
+				ensureAvailable(buffer, position, size);
+
+				// Every encoded value carries at least its type
+				if(size == 0)
+					throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+
+				std::vector<unsigned char> encoded(buffer.begin() + position, buffer.begin() + position + size);
+				position += size;
+				return Data(encoded);
+				}
+
+			static std::string readString(const std::vector<unsigned char>& buffer, size_t& position)
+				{
+				size_t size = static_cast<size_t>(readInteger(buffer, position, 4));
+				ensureAvailable(buffer, position, size);
+
+				position += size;
+				return std::string(buffer.begin() + position - size, buffer.begin() + position);
+				}
+
+		private:
+			LsmEncoding() { }
+
+			static void ensureAvailable(const std::vector<unsigned char>& buffer, const size_t position, const size_t size)
+				{
+				if(position > buffer.size() || buffer.size() - position < size)
+					throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+				}
+		};
+	}
+}
+}
+}
+
+#endif
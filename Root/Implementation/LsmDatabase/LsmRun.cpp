@@ -0,0 +1,266 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <cerrno>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include "LsmRun.h"
+#include "LsmEncoding.h"
+#include "../FileSynchronization.h"
+#include "../ImplementationException.h"
+
+using std::string;
+using std::vector;
+using boost::mutex;
+using boost::lock_guard;
+using boost::optional;
+using boost::shared_ptr;
+using boost::uint32_t;
+using boost::uint64_t;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Lsm
+	{
+	const uint32_t LsmRun::magic = 0x4e55524c; // "LRUN"
+	const size_t LsmRun::footerSize = 32;
+
+	LsmRun::LsmRun(const string& path)
+		: path(path), file(fopen(path.c_str(), "rb")), filter(0), size(0), recordCount(0), isObsolete(false),
+		  cachedIndex(0)
+		{
+		if(file == NULL)
+			throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR, errno);
+
+		try
+			{
+			vector<unsigned char> buffer;
+			size_t position = 0;
+
+			if(fseek(file, 0, SEEK_END) != 0)
+				throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR, errno);
+			size = static_cast<uint64_t>(ftell(file));
+			if(size < footerSize)
+				throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+
+			read(size - footerSize, footerSize, buffer);
+			const uint64_t indexOffset = LsmEncoding::readInteger(buffer, position, 8);
+			const uint64_t filterOffset = LsmEncoding::readInteger(buffer, position, 8);
+			recordCount = LsmEncoding::readInteger(buffer, position, 8);
+			const uint32_t blockCount = static_cast<uint32_t>(LsmEncoding::readInteger(buffer, position, 4));
+
+			if(LsmEncoding::readInteger(buffer, position, 4) != magic || 
+			   indexOffset > filterOffset || filterOffset > size - footerSize)
+				throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+
+			// The block index: the first entry of each block, and its location
+			read(indexOffset, static_cast<size_t>(filterOffset - indexOffset), buffer);
+			position = 0;
+			for(uint32_t index = 0; index < blockCount; index++)
+				{
+				Data key = LsmEncoding::readData(buffer, position);
+				Data value = LsmEncoding::readData(buffer, position);
+				BlockLocation block = { Entry(key, value), 0, 0 };
+				block.offset = LsmEncoding::readInteger(buffer, position, 8);
+				block.size = static_cast<uint32_t>(LsmEncoding::readInteger(buffer, position, 4));
+				blocks.push_back(block);
+				}
+
+			// The Bloom filter: the number of hash functions, and then the bits
+			read(filterOffset, static_cast<size_t>(size - footerSize - filterOffset), buffer);
+			position = 0;
+			const unsigned int hashCount = static_cast<unsigned int>(LsmEncoding::readInteger(buffer, position, 4));
+			filter = LsmBloomFilter(vector<unsigned char>(buffer.begin() + position, buffer.end()), hashCount);
+			}
+		catch(ImplementationException&)
+			{
+			fclose(file);
+			throw;
+			}
+		}
+
+	LsmRun::~LsmRun()
+		{
+		fclose(file);
+
+		if(isObsolete)
+			try
+				{ boost::filesystem::remove(path); }
+			// The file is removed at the next recovery if we are unable to remove it now
+			catch(boost::filesystem::basic_filesystem_error<boost::filesystem::path>&) { }
+		}
+
+	optional<Record> LsmRun::next(const Entry& entry, const bool inclusive) const
+		{
+		// Start with the last block beginning at or before the entry
+		vector<BlockLocation>::const_iterator location = std::upper_bound(blocks.begin(), blocks.end(), entry, isBlockAfter);
+		size_t index = location != blocks.begin() ? (location - blocks.begin()) - 1 : 0;
+
+		for(; index < blocks.size(); index++)
+			{
+			shared_ptr<const Block> block = load(index);
+			Block::const_iterator record = inclusive
+				? std::lower_bound(block->begin(), block->end(), entry, isBefore)
+				: std::upper_bound(block->begin(), block->end(), entry, isAfter);
+
+			if(record != block->end())
+				return *record;
+			}
+
+		return optional<Record>();
+		}
+
+	optional<Record> LsmRun::previous(const Entry& entry, const bool inclusive) const
+		{
+		// The last block beginning before the entry (or at it, if inclusive) contains the record we seek
+		vector<BlockLocation>::const_iterator location = inclusive
+			? std::upper_bound(blocks.begin(), blocks.end(), entry, isBlockAfter)
+			: std::lower_bound(blocks.begin(), blocks.end(), entry, isBlockBefore);
+
+		if(location == blocks.begin())
+			return optional<Record>();
+
+		shared_ptr<const Block> block = load((location - blocks.begin()) - 1);
+		Block::const_iterator record = inclusive
+			? std::upper_bound(block->begin(), block->end(), entry, isAfter)
+			: std::lower_bound(block->begin(), block->end(), entry, isBefore);
+
+		return record != block->begin() ? *--record : optional<Record>();
+		}
+
+	optional<Record> LsmRun::first() const
+		{ return !blocks.empty() ? load(0)->front() : optional<Record>(); }
+
+	optional<Record> LsmRun::last() const
+		{ return !blocks.empty() ? load(blocks.size() - 1)->back() : optional<Record>(); }
+
+	shared_ptr<const LsmRun::Block> LsmRun::load(const size_t index) const
+		{
+		lock_guard<mutex> guard(synchronization);
+
+		if(cachedBlock && cachedIndex == index)
+			return cachedBlock;
+
+		vector<unsigned char> buffer;
+		size_t position = 0;
+		shared_ptr<Block> block(new Block());
+
+		read(blocks[index].offset, blocks[index].size, buffer);
+		while(position < buffer.size())
+			{
+			const bool live = LsmEncoding::readInteger(buffer, position, 1) != 0;
+			Data key = LsmEncoding::readData(buffer, position);
+			Data value = LsmEncoding::readData(buffer, position);
+			block->push_back(Record(Entry(key, value), live));
+			}
+
+		if(block->empty())
+			throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+
+		cachedIndex = index;
+		cachedBlock = block;
+		return block;
+		}
+
+	void LsmRun::read(const uint64_t offset, const size_t size, vector<unsigned char>& buffer) const
+		{
+		buffer.resize(size);
+
+		if(fseek(file, static_cast<long>(offset), SEEK_SET) != 0 ||
+		   (size > 0 && fread(&buffer[0], 1, size, file) != size))
+			throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR, errno);
+		}
+
+	LsmRunWriter::LsmRunWriter(const string& path, const size_t blockSize, const size_t expectedRecords)
+		: path(path), file(fopen(path.c_str(), "wb")), blockSize(blockSize), filter(expectedRecords),
+		  offset(0), recordCount(0), blockCount(0), isFinished(false)
+		{
+		if(file == NULL)
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, errno);
+		}
+
+	LsmRunWriter::~LsmRunWriter()
+		{
+		if(!isFinished)
+			{
+			fclose(file);
+			try
+				{ boost::filesystem::remove(path); }
+			catch(boost::filesystem::basic_filesystem_error<boost::filesystem::path>&) { }
+			}
+		}
+
+	void LsmRunWriter::add(const Entry& entry, const bool live)
+		{
+		if(!blockFirst.is_initialized())
+			blockFirst = entry;
+
+		LsmEncoding::appendInteger(block, live ? 1 : 0, 1);
+		LsmEncoding::appendData(block, entry.first);
+		LsmEncoding::appendData(block, entry.second);
+		filter.add(entry.first);
+		recordCount++;
+
+		if(block.size() >= blockSize)
+			writeBlock();
+		}
+
+	void LsmRunWriter::finish()
+		{
+		vector<unsigned char> buffer;
+
+		writeBlock();
+
+		const uint64_t indexOffset = offset;
+		write(index);
+
+		const uint64_t filterOffset = offset;
+		LsmEncoding::appendInteger(buffer, filter.getHashCount(), 4);
+		buffer.insert(buffer.end(), filter.getBits().begin(), filter.getBits().end());
+		write(buffer);
+
+		buffer.clear();
+		LsmEncoding::appendInteger(buffer, indexOffset, 8);
+		LsmEncoding::appendInteger(buffer, filterOffset, 8);
+		LsmEncoding::appendInteger(buffer, recordCount, 8);
+		LsmEncoding::appendInteger(buffer, blockCount, 4);
+		LsmEncoding::appendInteger(buffer, LsmRun::magic, 4);
+		write(buffer);
+
+		if(fflush(file) != 0 || FileSynchronization::synchronize(file) != 0)
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, errno);
+
+		fclose(file);
+		isFinished = true;
+		}
+
+	void LsmRunWriter::writeBlock()
+		{
+		if(block.empty())
+			return;
+
+		LsmEncoding::appendData(index, blockFirst->first);
+		LsmEncoding::appendData(index, blockFirst->second);
+		LsmEncoding::appendInteger(index, offset, 8);
+		LsmEncoding::appendInteger(index, block.size(), 4);
+
+		write(block);
+		block.clear();
+		blockFirst.reset();
+		blockCount++;
+		}
+
+	void LsmRunWriter::write(const vector<unsigned char>& buffer)
+		{
+		if(!buffer.empty() && fwrite(&buffer[0], 1, buffer.size(), file) != buffer.size())
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, errno);
+		offset += buffer.size();
+		}
+	}
+}
+}
+}
@@ -0,0 +1,141 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMRUN_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMRUN_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <utility>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "LsmBloomFilter.h"
+#include "../MemoryDatabase/MemoryStorage.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Lsm {
+
+	typedef Memory::Entry Entry;
+	// A record in a run (or memtable): an entry, and whether it is live (rather than a tombstone masking older records)
+	typedef std::pair<Entry, bool> Record;
+
+	///<summary>
+	/// This class represents a run: an immutable file of records in entry order.  Records are grouped into
+	/// blocks, and the first entry of each block is held (with a Bloom filter over the keys in the run) in
+	/// memory, so that a seek reads a single block.  The most recently read block is cached, which makes a
+	/// sequential scan (e.g. by a cursor or a compaction) inexpensive.
+	///
+	///     [blocks][block index][Bloom filter][footer]
+	///
+	/// A run is shared by the readers that are using it; once superseded (by a compaction), it is marked
+	/// obsolete and its file is removed when the last reader releases it.
+	///</summary>
+	class LsmRun
+		{
+		public:
+			explicit LsmRun(const std::string& path);
+			~LsmRun();
+
+			// Gets the first record ordered after the given entry (or at it, if inclusive)
+			boost::optional<Record> next(const Entry& entry, const bool inclusive) const;
+			// Gets the last record ordered before the given entry (or at it, if inclusive)
+			boost::optional<Record> previous(const Entry& entry, const bool inclusive) const;
+			boost::optional<Record> first() const;
+			boost::optional<Record> last() const;
+
+			// Determines whether the run may contain a record with the given key
+			bool mayContain(const Data& key) const { return filter.mayContain(key); }
+
+			const std::string& getPath() const { return path; }
+			// Gets the size of the run (in bytes)
+			boost::uint64_t getSize() const { return size; }
+			boost::uint64_t getRecordCount() const { return recordCount; }
+
+			// Marks the run as superseded; its file is removed once the run is no longer in use
+			void markObsolete() { isObsolete = true; }
+
+			// Identifies a run file, and the size of its footer
+			static const boost::uint32_t magic;
+			static const size_t footerSize;
+
+		private:
+			typedef std::vector<Record> Block;
+
+			struct BlockLocation
+				{
+				Entry first;
+				boost::uint64_t offset;
+				boost::uint32_t size;
+				};
+
+			const std::string path;
+			FILE* file;
+			std::vector<BlockLocation> blocks;
+			LsmBloomFilter filter;
+			boost::uint64_t size;
+			boost::uint64_t recordCount;
+			volatile bool isObsolete;
+
+			// The most recently read block, and the synchronization used to read blocks from the file
+			mutable boost::mutex synchronization;
+			mutable size_t cachedIndex;
+			mutable boost::shared_ptr<const Block> cachedBlock;
+
+			boost::shared_ptr<const Block> load(const size_t index) const;
+			void read(const boost::uint64_t offset, const size_t size, std::vector<unsigned char>& buffer) const;
+
+			// Comparisons used to search blocks and block locations
+			static bool isBefore(const Record& record, const Entry& entry) { return record.first < entry; }
+			static bool isAfter(const Entry& entry, const Record& record) { return entry < record.first; }
+			static bool isBlockBefore(const BlockLocation& block, const Entry& entry) { return block.first < entry; }
+			static bool isBlockAfter(const Entry& entry, const BlockLocation& block) { return entry < block.first; }
+		};
+
+	///<summary>
+	/// This class writes a new run; records must be added in entry order.  A run that is not finished (e.g.
+	/// because a write failed) is removed.
+	///</summary>
+	class LsmRunWriter
+		{
+		public:
+			LsmRunWriter(const std::string& path, const size_t blockSize, const size_t expectedRecords);
+			~LsmRunWriter();
+
+			void add(const Entry& entry, const bool live);
+			// Completes the run, and flushes it to disk
+			void finish();
+
+			boost::uint64_t getRecordCount() const { return recordCount; }
+
+		private:
+			const std::string path;
+			FILE* file;
+			const size_t blockSize;
+
+			std::vector<unsigned char> block;
+			boost::optional<Entry> blockFirst;
+			std::vector<unsigned char> index;
+			LsmBloomFilter filter;
+
+			boost::uint64_t offset;
+			boost::uint64_t recordCount;
+			boost::uint32_t blockCount;
+			bool isFinished;
+
+			void writeBlock();
+			void write(const std::vector<unsigned char>& buffer);
+		};
+	}
+}
+}
+}
+
+#endif
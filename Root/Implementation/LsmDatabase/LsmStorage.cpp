@@ -0,0 +1,458 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <set>
+#include <cerrno>
+#include <zlib.h>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include "LsmStorage.h"
+#include "LsmEncoding.h"
+#include "../FileSynchronization.h"
+#include "../ImplementationException.h"
+#include "../../Support/DatabaseLocation.h"
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+using boost::mutex;
+using boost::lock_guard;
+using boost::shared_ptr;
+using boost::weak_ptr;
+using boost::uint32_t;
+using boost::uint64_t;
+using boost::filesystem::path;
+using boost::filesystem::directory_iterator;
+using BrandonHaynes::IndexedDB::Implementation::Memory::TablePtr;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Lsm
+	{
+	const string LsmStorage::logName = "LOG";
+	const string LsmStorage::manifestName = "MANIFEST";
+	const uint32_t LsmStorage::manifestMagic = 0x4e414d4c; // "LMAN"
+	const uint64_t LsmStorage::defaultMemtableBudget = 4 * 1024 * 1024;
+	const size_t LsmStorage::defaultBlockSize = 4096;
+
+	map<string, weak_ptr<LsmStorage> > LsmStorage::instances;
+	mutex LsmStorage::instancesSynchronization;
+
+	shared_ptr<LsmStorage> LsmStorage::getInstance(const string& origin, const string& name, const DatabaseConfiguration& configuration)
+		{
+		// Kept apart from any Berkeley DB environment for a database of the same name
+		const string directory = DatabaseLocation::getDatabasePath(origin, name + "__lsm");
+
+		lock_guard<mutex> guard(instancesSynchronization);
+		shared_ptr<LsmStorage> instance = instances[directory].lock();
+
+		// Tuning applies only as the storage is opened; later handles share it as-is
+		if(!instance)
+			{
+			instance.reset(new LsmStorage(directory, configuration));
+			instances[directory] = instance;
+			}
+		return instance;
+		}
+
+	LsmStorage::LsmStorage(const string& directory, const DatabaseConfiguration& configuration)
+		: directory(directory), 
+		  durability(configuration.getDurability()),
+		  memtableBudget(configuration.getCacheSize().get_value_or(defaultMemtableBudget)),
+		  blockSize(configuration.getPageSize().get_value_or(defaultBlockSize)),
+		  logFile(NULL), memtableSize(0), nextTable(1), nextRun(1)
+		{
+		if(!readManifest(getPath(manifestName)))
+			// The manifest may have been removed just before its replacement was renamed
+			readManifest(getPath(manifestName + ".tmp"));
+		replay();
+
+		collect();
+		checkpoint();
+		removeOrphans();
+
+		compaction.reset(new LsmCompaction(boost::bind(&LsmStorage::compact, this), 1000));
+		compaction->start();
+		}
+
+	LsmStorage::~LsmStorage()
+		{
+		// Stop compacting before the trees are released; the log needs no checkpoint (it is replayed when reopened)
+		compaction.reset();
+
+		if(logFile != NULL)
+			fclose(logFile);
+		}
+
+	TablePtr LsmStorage::createTable()
+		{
+		lock_guard<mutex> guard(synchronization);
+		shared_ptr<LsmTree> tree(new LsmTree(*this, nextTable++));
+
+		trees[tree->getIdentifier()] = tree;
+		return tree;
+		}
+
+	void LsmStorage::setTable(const string& name, const TablePtr& table)
+		{
+		MemoryStorage::setTable(name, table);
+
+		shared_ptr<LsmTree> tree = boost::static_pointer_cast<LsmTree>(table);
+		names[name] = tree;
+
+		pending.push_back(CREATE);
+		LsmEncoding::appendInteger(pending, tree->getIdentifier(), 8);
+		LsmEncoding::appendString(pending, name);
+		}
+
+	void LsmStorage::removeTable(const string& name)
+		{
+		MemoryStorage::removeTable(name);
+		names.erase(name);
+
+		pending.push_back(DROP);
+		LsmEncoding::appendString(pending, name);
+		}
+
+	void LsmStorage::log(const uint64_t identifier, const Entry& entry, const bool live)
+		{
+		pending.push_back(live ? PUT : REMOVE);
+		LsmEncoding::appendInteger(pending, identifier, 8);
+		LsmEncoding::appendData(pending, entry.first);
+		LsmEncoding::appendData(pending, entry.second);
+
+		// Approximates the overhead of a memtable node
+		memtableSize += entry.first.getSize() + entry.second.getSize() + 64;
+		}
+
+	string LsmStorage::allocateRunPath()
+		{
+		lock_guard<mutex> guard(synchronization);
+		return getPath(boost::lexical_cast<string>(nextRun++) + ".run");
+		}
+
+	void LsmStorage::persist()
+		{
+		if(pending.empty())
+			return;
+
+		vector<unsigned char> header;
+		LsmEncoding::appendInteger(header, pending.size(), 4);
+		LsmEncoding::appendInteger(header, crc32(0, &pending[0], static_cast<uInt>(pending.size())), 4);
+
+		const long position = ftell(logFile);
+		bool failed = position < 0 ||
+					  fwrite(&header[0], 1, header.size(), logFile) != header.size() ||
+					  fwrite(&pending[0], 1, pending.size(), logFile) != pending.size();
+
+		if(!failed && durability != DatabaseConfiguration::NO_SYNC)
+			failed = fflush(logFile) != 0;
+		// Commits are already serialized by the database lock, so a group commit has no one to share its flush
+		if(!failed && (durability == DatabaseConfiguration::DURABLE || durability == DatabaseConfiguration::GROUP_COMMIT))
+			failed = FileSynchronization::synchronize(logFile) != 0;
+
+		if(failed)
+			{
+			const int error = errno;
+
+			// The caller undoes the changes, so whatever part of the group reached the log is cut off by an empty group
+			// (at which replay stops) and later overwritten; this is only an attempt, as the log has already failed us
+			if(position >= 0 && fseek(logFile, position, SEEK_SET) == 0)
+				{
+				const vector<unsigned char> empty(header.size(), 0);
+				fwrite(&empty[0], 1, empty.size(), logFile);
+				fflush(logFile);
+				FileSynchronization::synchronize(logFile);
+				fseek(logFile, position, SEEK_SET);
+				}
+
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, error);
+			}
+		}
+
+	void LsmStorage::onRelease(const bool committed)
+		{
+		// Committed changes were logged as they were persisted; aborted (or unpersisted) changes have already been
+		// undone in memory, and their records are discarded
+		pending.clear();
+		collect();
+
+		if(memtableSize > memtableBudget)
+			{
+			checkpoint();
+			compaction->notify();
+			}
+		}
+
+	void LsmStorage::compact()
+		{
+		bool compacted = true;
+
+		while(compacted)
+			{
+			vector<shared_ptr<LsmTree> > snapshot;
+				{
+				lock_guard<mutex> guard(synchronization);
+				for(Trees::const_iterator tree = trees.begin(); tree != trees.end(); tree++)
+					snapshot.push_back(tree->second);
+				}
+
+			compacted = false;
+			for(vector<shared_ptr<LsmTree> >::const_iterator tree = snapshot.begin(); tree != snapshot.end(); tree++)
+				{
+				// Holding the prior runs keeps their files in place until the manifest no longer refers to them
+				Levels inputs = (*tree)->getLevels();
+
+				if((*tree)->compact())
+					{
+					writeManifest();
+					compacted = true;
+					}
+				}
+			}
+		}
+
+	void LsmStorage::collect()
+		{
+		vector<shared_ptr<LsmTree> > unnamed;
+
+			{
+			lock_guard<mutex> guard(synchronization);
+			committedNames = names;
+
+			set<uint64_t> named;
+			for(Names::const_iterator name = names.begin(); name != names.end(); name++)
+				named.insert(name->second->getIdentifier());
+
+			for(Trees::iterator tree = trees.begin(); tree != trees.end(); )
+				if(named.find(tree->first) == named.end())
+					{
+					unnamed.push_back(tree->second);
+					trees.erase(tree++);
+					}
+				else
+					tree++;
+			}
+
+		if(!unnamed.empty())
+			{
+			writeManifest();
+			for(vector<shared_ptr<LsmTree> >::const_iterator tree = unnamed.begin(); tree != unnamed.end(); tree++)
+				(*tree)->drop();
+			}
+		}
+
+	void LsmStorage::checkpoint()
+		{
+		for(Trees::const_iterator tree = trees.begin(); tree != trees.end(); tree++)
+			tree->second->flush();
+
+		writeManifest();
+		openLog("wb");
+		memtableSize = 0;
+		}
+
+	void LsmStorage::writeManifest()
+		{
+		lock_guard<mutex> guard(synchronization);
+		vector<unsigned char> buffer;
+
+		LsmEncoding::appendInteger(buffer, manifestMagic, 4);
+		LsmEncoding::appendInteger(buffer, nextTable, 8);
+		LsmEncoding::appendInteger(buffer, nextRun, 8);
+		LsmEncoding::appendInteger(buffer, committedNames.size(), 4);
+
+		for(Names::const_iterator name = committedNames.begin(); name != committedNames.end(); name++)
+			{
+			Levels levels = name->second->getLevels();
+
+			LsmEncoding::appendString(buffer, name->first);
+			LsmEncoding::appendInteger(buffer, name->second->getIdentifier(), 8);
+			LsmEncoding::appendInteger(buffer, levels.size(), 4);
+
+			for(Levels::const_iterator level = levels.begin(); level != levels.end(); level++)
+				{
+				LsmEncoding::appendInteger(buffer, level->size(), 4);
+				for(vector<LsmRunPtr>::const_iterator run = level->begin(); run != level->end(); run++)
+					LsmEncoding::appendString(buffer, path((*run)->getPath()).leaf());
+				}
+			}
+
+		LsmEncoding::appendInteger(buffer, crc32(0, &buffer[0], static_cast<uInt>(buffer.size())), 4);
+
+		// Written aside and then renamed, so that a failure leaves either the prior manifest or this one intact
+		const string manifestPath = getPath(manifestName);
+		const string temporaryPath = getPath(manifestName + ".tmp");
+		FILE* file = fopen(temporaryPath.c_str(), "wb");
+
+		if(file == NULL)
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, errno);
+		else if(fwrite(&buffer[0], 1, buffer.size(), file) != buffer.size() || fflush(file) != 0 || FileSynchronization::synchronize(file) != 0)
+			{
+			fclose(file);
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, errno);
+			}
+		fclose(file);
+
+		try
+			{
+			boost::filesystem::remove(manifestPath);
+			boost::filesystem::rename(temporaryPath, manifestPath);
+			}
+		catch(boost::filesystem::basic_filesystem_error<path>& e)
+			{ throw ImplementationException(e.what(), ImplementationException::UNKNOWN_ERR); }
+		}
+
+	bool LsmStorage::readManifest(const string& manifestPath)
+		{
+		FILE* file = fopen(manifestPath.c_str(), "rb");
+		vector<unsigned char> buffer;
+		unsigned char chunk[4096];
+		size_t read;
+
+		if(file == NULL)
+			return false;
+		while((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+			buffer.insert(buffer.end(), chunk, chunk + read);
+		fclose(file);
+
+		// A manifest that was not completely written is ignored (its predecessor is intact)
+		if(buffer.size() < 8)
+			return false;
+		size_t position = buffer.size() - 4;
+		if(LsmEncoding::readInteger(buffer, position, 4) != crc32(0, &buffer[0], static_cast<uInt>(buffer.size() - 4)))
+			return false;
+
+		position = 0;
+		if(LsmEncoding::readInteger(buffer, position, 4) != manifestMagic)
+			throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+
+		nextTable = LsmEncoding::readInteger(buffer, position, 8);
+		nextRun = LsmEncoding::readInteger(buffer, position, 8);
+
+		for(uint64_t count = LsmEncoding::readInteger(buffer, position, 4); count > 0; count--)
+			{
+			const string name = LsmEncoding::readString(buffer, position);
+			shared_ptr<LsmTree> tree = getTree(LsmEncoding::readInteger(buffer, position, 8));
+			Levels levels(static_cast<size_t>(LsmEncoding::readInteger(buffer, position, 4)));
+
+			for(Levels::iterator level = levels.begin(); level != levels.end(); level++)
+				for(uint64_t runs = LsmEncoding::readInteger(buffer, position, 4); runs > 0; runs--)
+					level->push_back(LsmRunPtr(new LsmRun(getPath(LsmEncoding::readString(buffer, position)))));
+
+			tree->setLevels(levels);
+			names[name] = tree;
+			MemoryStorage::setTable(name, tree);
+			}
+
+		return true;
+		}
+
+	void LsmStorage::replay()
+		{
+		FILE* file = fopen(getPath(logName).c_str(), "rb");
+		vector<unsigned char> header(8), group;
+
+		if(file == NULL)
+			return;
+
+		// Replay stops at the first group that was not completely written (i.e. that was never committed)
+		while(fread(&header[0], 1, header.size(), file) == header.size())
+			{
+			size_t position = 0;
+			group.resize(static_cast<size_t>(LsmEncoding::readInteger(header, position, 4)));
+			const uint64_t checksum = LsmEncoding::readInteger(header, position, 4);
+
+			if(group.empty() || fread(&group[0], 1, group.size(), file) != group.size() ||
+			   crc32(0, &group[0], static_cast<uInt>(group.size())) != checksum)
+				break;
+
+			for(position = 0; position < group.size(); )
+				{
+				const unsigned char type = group[position++];
+
+				if(type == PUT || type == REMOVE)
+					{
+					shared_ptr<LsmTree> tree = getTree(LsmEncoding::readInteger(group, position, 8));
+					const Data key = LsmEncoding::readData(group, position);
+					const Data value = LsmEncoding::readData(group, position);
+					tree->apply(Entry(key, value), type == PUT);
+					}
+				else if(type == CREATE)
+					{
+					shared_ptr<LsmTree> tree = getTree(LsmEncoding::readInteger(group, position, 8));
+					const string name = LsmEncoding::readString(group, position);
+					names[name] = tree;
+					MemoryStorage::setTable(name, tree);
+					}
+				else if(type == DROP)
+					{
+					const string name = LsmEncoding::readString(group, position);
+					names.erase(name);
+					MemoryStorage::removeTable(name);
+					}
+				else
+					{
+					fclose(file);
+					throw ImplementationException("DATA_ERR", ImplementationException::DATA_ERR);
+					}
+				}
+			}
+
+		fclose(file);
+		}
+
+	void LsmStorage::removeOrphans()
+		{
+		set<string> referenced;
+
+		for(Trees::const_iterator tree = trees.begin(); tree != trees.end(); tree++)
+			{
+			Levels levels = tree->second->getLevels();
+			for(Levels::const_iterator level = levels.begin(); level != levels.end(); level++)
+				for(vector<LsmRunPtr>::const_iterator run = level->begin(); run != level->end(); run++)
+					referenced.insert(path((*run)->getPath()).leaf());
+			}
+
+		try
+			{
+			for(directory_iterator file(directory); file != directory_iterator(); file++)
+				if(file->path().extension() == ".run" && referenced.find(file->path().leaf()) == referenced.end())
+					boost::filesystem::remove(file->path());
+			}
+		// Orphans are merely wasted space; we'll try again when next opened
+		catch(boost::filesystem::basic_filesystem_error<path>&) { }
+		}
+
+	void LsmStorage::openLog(const char* mode)
+		{
+		if(logFile != NULL)
+			fclose(logFile);
+
+		logFile = fopen(getPath(logName).c_str(), mode);
+		if(logFile == NULL)
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR, errno);
+		}
+
+	string LsmStorage::getPath(const string& fileName) const
+		{ return (path(directory) / fileName).file_string(); }
+
+	shared_ptr<LsmTree> LsmStorage::getTree(const uint64_t identifier)
+		{
+		shared_ptr<LsmTree>& tree = trees[identifier];
+
+		if(!tree)
+			tree.reset(new LsmTree(*this, identifier));
+		if(identifier >= nextTable)
+			nextTable = identifier + 1;
+		return tree;
+		}
+	}
+}
+}
+}
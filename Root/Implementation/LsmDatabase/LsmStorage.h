@@ -0,0 +1,139 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMSTORAGE_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMSTORAGE_H
+
+#include <map>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "LsmTree.h"
+#include "LsmCompaction.h"
+#include "../MemoryDatabase/MemoryStorage.h"
+#include "../DatabaseConfiguration.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Lsm {
+
+	///<summary>
+	/// This class holds the tables that make up an LSM database, and persists them in a directory of their own:
+	///
+	///     LOG         changes committed since the last checkpoint, in groups (one per holder of the lock)
+	///     MANIFEST    the tables in the database and the runs that make up each
+	///     <n>.run     the runs themselves
+	///
+	/// The changes made by a holder of the database lock are appended to the log as it commits (and flushed
+	/// per the configured durability); once the memtables grow beyond their budget (the configured cache size),
+	/// a checkpoint flushes every memtable to a new run, rewrites the manifest and truncates the log.  When a
+	/// database is opened, any groups in the log that were completely written are replayed.
+	///
+	/// Storage is shared by every handle opened on the same database in this process, and is closed when the
+	/// last is released.
+	///</summary>
+	class LsmStorage : public Memory::MemoryStorage
+		{
+		public:
+			// Gets the storage associated with the given database, opening (and recovering) it if necessary
+			static boost::shared_ptr<LsmStorage> getInstance(const std::string& origin, const std::string& name, const DatabaseConfiguration& configuration);
+			virtual ~LsmStorage();
+
+			virtual Memory::TablePtr createTable();
+			virtual void setTable(const std::string& name, const Memory::TablePtr& table);
+			virtual void removeTable(const std::string& name);
+
+			// Records a change to a tree, to be logged when the current holder of the lock commits
+			void log(const boost::uint64_t identifier, const Entry& entry, const bool live);
+			// Allocates the path of a new run
+			std::string allocateRunPath();
+			// Gets the size (in bytes) of the blocks in new runs
+			size_t getBlockSize() const { return blockSize; }
+			// Gets the size (in bytes) beyond which the run at level one is merged into the level below
+			boost::uint64_t getLevelLimit() const { return memtableBudget * 10; }
+
+			// Performs every compaction that is warranted (invoked in the background)
+			void compact();
+
+			// Appends the changes of the current holder of the lock to the log (and flushes it per the configured durability)
+			virtual void persist();
+
+		protected:
+			virtual void onRelease(const bool committed);
+
+		private:
+			typedef std::map<std::string, boost::shared_ptr<LsmTree> > Names;
+			typedef std::map<boost::uint64_t, boost::shared_ptr<LsmTree> > Trees;
+
+			LsmStorage(const std::string& directory, const DatabaseConfiguration& configuration);
+
+			const std::string directory;
+			const DatabaseConfiguration::Durability durability;
+			const boost::uint64_t memtableBudget;
+			const size_t blockSize;
+
+			// The log, and the records logged by the current holder of the lock
+			FILE* logFile;
+			std::vector<unsigned char> pending;
+			// The approximate size (in bytes) of the memtables
+			boost::uint64_t memtableSize;
+
+			// Every tree that has not been removed, by identifier; the trees by name (as changed by the holder of
+			// the lock, and as of the most recent release)
+			Trees trees;
+			Names names;
+			Names committedNames;
+			boost::uint64_t nextTable;
+			boost::uint64_t nextRun;
+
+			// Used to synchronize access to the trees, the run counter and the manifest
+			boost::mutex synchronization;
+			// Merges runs in the background (declared last, so that it is stopped first)
+			std::auto_ptr<LsmCompaction> compaction;
+
+			// Recovery: loads the manifest (returns false if there is none) and replays the log
+			bool readManifest(const std::string& path);
+			void replay();
+			// Removes run files not referenced by any tree (e.g. those written by an interrupted compaction)
+			void removeOrphans();
+
+			// Writes the committed trees (and their runs) to the manifest
+			void writeManifest();
+			// Drops trees that are no longer named by the database
+			void collect();
+			// Flushes every memtable to a new run, and truncates the log
+			void checkpoint();
+			void openLog(const char* mode);
+
+			std::string getPath(const std::string& fileName) const;
+			boost::shared_ptr<LsmTree> getTree(const boost::uint64_t identifier);
+
+			// Record types in the log
+			enum RecordType { PUT = 1, REMOVE = 2, CREATE = 3, DROP = 4 };
+
+			// The file names of the log and manifest, and the default memtable budget and run block size
+			static const std::string logName;
+			static const std::string manifestName;
+			static const boost::uint32_t manifestMagic;
+			static const boost::uint64_t defaultMemtableBudget;
+			static const size_t defaultBlockSize;
+
+			// All storage open in this process, keyed by directory
+			static std::map<std::string, boost::weak_ptr<LsmStorage> > instances;
+			static boost::mutex instancesSynchronization;
+		};
+	}
+}
+}
+}
+
+#endif
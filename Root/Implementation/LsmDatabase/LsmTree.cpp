@@ -0,0 +1,316 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include "LsmTree.h"
+#include "LsmStorage.h"
+
+using std::string;
+using std::vector;
+using boost::mutex;
+using boost::lock_guard;
+using boost::optional;
+using boost::uint64_t;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Lsm
+	{
+	const size_t LsmTree::levelZeroLimit = 4;
+	const size_t LsmTree::levelGrowth = 10;
+
+	LsmTree::LsmTree(LsmStorage& storage, const uint64_t identifier)
+		: storage(storage), identifier(identifier), levels(1), isDropped(false)
+		{ }
+
+	optional<Entry> LsmTree::next(const Entry& entry, const bool inclusive) const
+		{
+		Levels snapshot = getLevels();
+		return seek(getSources(snapshot, NULL), entry, inclusive, true);
+		}
+
+	optional<Entry> LsmTree::previous(const Entry& entry, const bool inclusive) const
+		{
+		Levels snapshot = getLevels();
+		return seek(getSources(snapshot, NULL), entry, inclusive, false);
+		}
+
+	optional<Entry> LsmTree::last() const
+		{
+		Levels snapshot = getLevels();
+		Sources sources = getSources(snapshot, NULL);
+		optional<Record> greatest;
+
+		if(!memtable.empty())
+			greatest = *memtable.rbegin();
+		for(Sources::const_iterator source = sources.begin(); source != sources.end(); source++)
+			{
+			optional<Record> candidate = (*source)->last();
+			if(candidate.is_initialized() && (!greatest.is_initialized() || greatest->first < candidate->first))
+				greatest = candidate;
+			}
+
+		if(!greatest.is_initialized())
+			return optional<Entry>();
+		else if(greatest->second)
+			return greatest->first;
+		else
+			return seek(sources, greatest->first, false, false);
+		}
+
+	optional<Entry> LsmTree::find(const Data& key) const
+		{
+		Levels snapshot = getLevels();
+		optional<Entry> entry = seek(getSources(snapshot, &key), lowestEntry(key), true, true);
+		return entry.is_initialized() && entry->first == key ? entry : optional<Entry>();
+		}
+
+	bool LsmTree::insert(const Entry& entry)
+		{
+		optional<bool> existing = lookup(entry);
+
+		if(existing.is_initialized() && existing.get())
+			return false;
+
+		memtable[entry] = true;
+		storage.log(identifier, entry, true);
+		return true;
+		}
+
+	bool LsmTree::erase(const Entry& entry)
+		{
+		optional<bool> existing = lookup(entry);
+
+		if(!existing.is_initialized() || !existing.get())
+			return false;
+
+		// Older records for the entry may remain in the runs, so we record a tombstone rather than forgetting it
+		memtable[entry] = false;
+		storage.log(identifier, entry, false);
+		return true;
+		}
+
+	void LsmTree::apply(const Entry& entry, const bool live)
+		{ memtable[entry] = live; }
+
+	void LsmTree::flush()
+		{
+		if(memtable.empty())
+			return;
+
+		const string path = storage.allocateRunPath();
+		LsmRunWriter writer(path, storage.getBlockSize(), memtable.size());
+
+		for(Memtable::const_iterator record = memtable.begin(); record != memtable.end(); record++)
+			writer.add(record->first, record->second);
+		writer.finish();
+
+		LsmRunPtr run(new LsmRun(path));
+			{
+			lock_guard<mutex> guard(synchronization);
+			levels[0].insert(levels[0].begin(), run);
+			}
+
+		memtable.clear();
+		}
+
+	bool LsmTree::compact()
+		{
+		Levels current = getLevels();
+		vector<LsmRunPtr> inputs;
+		size_t output = 0;
+
+		if(current[0].size() >= levelZeroLimit)
+			{
+			inputs = current[0];
+			output = 1;
+			}
+		else
+			{
+			uint64_t limit = storage.getLevelLimit();
+			for(size_t level = 1; level < current.size() && inputs.empty(); level++, limit *= levelGrowth)
+				if(!current[level].empty() && current[level].front()->getSize() > limit)
+					{
+					inputs = current[level];
+					output = level + 1;
+					}
+			}
+
+		if(inputs.empty())
+			return false;
+		else if(output < current.size())
+			inputs.insert(inputs.end(), current[output].begin(), current[output].end());
+
+		// Tombstones mask nothing once there are no runs beneath the output level
+		bool isDeepest = true;
+		for(size_t level = output + 1; level < current.size(); level++)
+			isDeepest &= current[level].empty();
+
+		install(inputs, merge(inputs, isDeepest), output);
+		return true;
+		}
+
+	void LsmTree::drop()
+		{
+		lock_guard<mutex> guard(synchronization);
+
+		for(Levels::const_iterator level = levels.begin(); level != levels.end(); level++)
+			for(vector<LsmRunPtr>::const_iterator run = level->begin(); run != level->end(); run++)
+				(*run)->markObsolete();
+
+		levels = Levels(1);
+		isDropped = true;
+		}
+
+	Levels LsmTree::getLevels() const
+		{
+		lock_guard<mutex> guard(synchronization);
+		return levels;
+		}
+
+	void LsmTree::setLevels(const Levels& levels)
+		{
+		lock_guard<mutex> guard(synchronization);
+		this->levels = levels.empty() ? Levels(1) : levels;
+		}
+
+	LsmTree::Sources LsmTree::getSources(const Levels& levels, const Data* key) const
+		{
+		Sources sources;
+
+		for(Levels::const_iterator level = levels.begin(); level != levels.end(); level++)
+			for(vector<LsmRunPtr>::const_iterator run = level->begin(); run != level->end(); run++)
+				if(key == NULL || (*run)->mayContain(*key))
+					sources.push_back(run->get());
+
+		return sources;
+		}
+
+	optional<Entry> LsmTree::seek(const Sources& sources, Entry entry, bool inclusive, const bool forward) const
+		{
+		while(true)
+			{
+			optional<Record> nearest;
+
+			// The memtable is the newest source, followed by the runs (newest first); where several sources
+			// hold the same entry, we keep the record from the newest
+			Memtable::const_iterator position = forward
+				? (inclusive ? memtable.lower_bound(entry) : memtable.upper_bound(entry))
+				: (inclusive ? memtable.upper_bound(entry) : memtable.lower_bound(entry));
+			if(forward && position != memtable.end())
+				nearest = *position;
+			else if(!forward && position != memtable.begin())
+				nearest = *--position;
+
+			for(Sources::const_iterator source = sources.begin(); source != sources.end(); source++)
+				{
+				optional<Record> candidate = forward ? (*source)->next(entry, inclusive) : (*source)->previous(entry, inclusive);
+				if(candidate.is_initialized() && (!nearest.is_initialized() || 
+						(forward ? candidate->first < nearest->first : nearest->first < candidate->first)))
+					nearest = candidate;
+				}
+
+			if(!nearest.is_initialized())
+				return optional<Entry>();
+			else if(nearest->second)
+				return nearest->first;
+
+			// The nearest entry has been removed; continue beyond it
+			entry = nearest->first;
+			inclusive = false;
+			}
+		}
+
+	optional<bool> LsmTree::lookup(const Entry& entry) const
+		{
+		Memtable::const_iterator record = memtable.find(entry);
+		if(record != memtable.end())
+			return record->second;
+
+		Levels snapshot = getLevels();
+		Sources sources = getSources(snapshot, &entry.first);
+		for(Sources::const_iterator source = sources.begin(); source != sources.end(); source++)
+			{
+			optional<Record> candidate = (*source)->next(entry, true);
+			if(candidate.is_initialized() && candidate->first == entry)
+				return candidate->second;
+			}
+
+		return optional<bool>();
+		}
+
+	LsmRunPtr LsmTree::merge(const vector<LsmRunPtr>& inputs, const bool discardTombstones)
+		{
+		uint64_t expectedRecords = 0;
+		for(vector<LsmRunPtr>::const_iterator input = inputs.begin(); input != inputs.end(); input++)
+			expectedRecords += (*input)->getRecordCount();
+
+		const string path = storage.allocateRunPath();
+		LsmRunWriter writer(path, storage.getBlockSize(), static_cast<size_t>(expectedRecords));
+		vector<optional<Record> > positions;
+
+		for(vector<LsmRunPtr>::const_iterator input = inputs.begin(); input != inputs.end(); input++)
+			positions.push_back((*input)->first());
+
+		while(true)
+			{
+			// The least entry among the inputs; inputs are ordered newest first, so the first to hold it wins
+			size_t least = inputs.size();
+			for(size_t index = 0; index < inputs.size(); index++)
+				if(positions[index].is_initialized() && (least == inputs.size() || positions[index]->first < positions[least]->first))
+					least = index;
+
+			if(least == inputs.size())
+				break;
+
+			const Record record = positions[least].get();
+			if(record.second || !discardTombstones)
+				writer.add(record.first, record.second);
+
+			for(size_t index = 0; index < inputs.size(); index++)
+				if(positions[index].is_initialized() && positions[index]->first == record.first)
+					positions[index] = inputs[index]->next(record.first, false);
+			}
+
+		// Every record may have been a discarded tombstone (the writer removes the file it began)
+		if(writer.getRecordCount() == 0)
+			return LsmRunPtr();
+
+		writer.finish();
+		return LsmRunPtr(new LsmRun(path));
+		}
+
+	void LsmTree::install(const vector<LsmRunPtr>& inputs, const LsmRunPtr& output, const size_t level)
+		{
+			{
+			lock_guard<mutex> guard(synchronization);
+
+			if(isDropped)
+				{
+				if(output)
+					output->markObsolete();
+				}
+			else
+				{
+				// Runs flushed to level zero during the compaction are newer than its output, and remain
+				for(Levels::iterator current = levels.begin(); current != levels.end(); current++)
+					for(vector<LsmRunPtr>::const_iterator input = inputs.begin(); input != inputs.end(); input++)
+						current->erase(std::remove(current->begin(), current->end(), *input), current->end());
+
+				if(levels.size() <= level)
+					levels.resize(level + 1);
+				if(output)
+					levels[level].push_back(output);
+				}
+			}
+
+		for(vector<LsmRunPtr>::const_iterator input = inputs.begin(); input != inputs.end(); input++)
+			(*input)->markObsolete();
+		}
+	}
+}
+}
+}
@@ -0,0 +1,106 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMTREE_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_LSM_LSMTREE_H
+
+#include <map>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "LsmRun.h"
+#include "../MemoryDatabase/MemoryStorage.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Lsm {
+
+	class LsmStorage;
+
+	typedef boost::shared_ptr<LsmRun> LsmRunPtr;
+	// The runs in a tree, by level; level zero holds (possibly overlapping) flushed memtables, newest first,
+	// and each subsequent level holds at most a single run
+	typedef std::vector<std::vector<LsmRunPtr> > Levels;
+
+	///<summary>
+	/// This class represents a table (an object store, index or metadata store) in an LSM database.  Changes
+	/// are made to an in-memory table (the memtable), which is periodically flushed to a new run at level zero.
+	/// A read merges the memtable with the runs, where the newest record for an entry wins and tombstones mask
+	/// older records; runs whose Bloom filter excludes a key are skipped when looking up that key.
+	///
+	/// Runs are merged in the background: once level zero holds enough runs they are merged (with the run
+	/// at level one) into a new run at level one, and a level that grows beyond its limit (ten times that of
+	/// the level above it) is merged into the level below.  Tombstones are discarded once they reach the
+	/// deepest level.
+	///
+	/// The memtable is accessed only by the holder of the database lock; the runs may be replaced by a
+	/// compaction at any time, so readers take a snapshot of them.
+	///</summary>
+	class LsmTree : public Memory::Table
+		{
+		public:
+			LsmTree(LsmStorage& storage, const boost::uint64_t identifier);
+
+			virtual boost::optional<Entry> next(const Entry& entry, const bool inclusive) const;
+			virtual boost::optional<Entry> previous(const Entry& entry, const bool inclusive) const;
+			virtual boost::optional<Entry> last() const;
+			virtual boost::optional<Entry> find(const Data& key) const;
+
+			virtual bool insert(const Entry& entry);
+			virtual bool erase(const Entry& entry);
+
+			// Applies a change to the memtable without logging it (e.g. during recovery)
+			void apply(const Entry& entry, const bool live);
+			// Writes the memtable to a new run at level zero, and empties it; the caller must hold the database lock
+			void flush();
+			// Performs a single compaction, if one is warranted; returns false if there was nothing to do
+			bool compact();
+			// Marks every run in this (removed) tree as obsolete
+			void drop();
+
+			boost::uint64_t getIdentifier() const { return identifier; }
+			Levels getLevels() const;
+			void setLevels(const Levels& levels);
+
+		private:
+			typedef std::map<Entry, bool> Memtable;
+			typedef std::vector<const LsmRun*> Sources;
+
+			LsmStorage& storage;
+			const boost::uint64_t identifier;
+			Memtable memtable;
+			Levels levels;
+			bool isDropped;
+
+			// Used to synchronize access to the runs
+			mutable boost::mutex synchronization;
+
+			// Gets the runs that a read should consult, newest first (omitting those that cannot contain the given key)
+			Sources getSources(const Levels& levels, const Data* key) const;
+			// Merges the memtable and the given runs, skipping entries masked by a tombstone
+			boost::optional<Entry> seek(const Sources& sources, Entry entry, bool inclusive, const bool forward) const;
+			// Gets the newest record for the given entry, if any
+			boost::optional<bool> lookup(const Entry& entry) const;
+
+			// Merges the given runs (newest first) into a new run
+			LsmRunPtr merge(const std::vector<LsmRunPtr>& inputs, const bool discardTombstones);
+			// Replaces the given runs (which have been merged) with their merged result at the given level
+			void install(const std::vector<LsmRunPtr>& inputs, const LsmRunPtr& output, const size_t level);
+
+			// Number of runs at level zero that triggers a compaction
+			static const size_t levelZeroLimit;
+			// Growth in the size limit from one level to the next
+			static const size_t levelGrowth;
+		};
+	}
+}
+}
+}
+
+#endif
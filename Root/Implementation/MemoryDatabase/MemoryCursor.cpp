@@ -0,0 +1,211 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include "MemoryCursor.h"
+#include "MemoryTransaction.h"
+#include "../ImplementationException.h"
+
+using boost::mutex;
+using boost::lock_guard;
+using boost::optional;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory
+	{
+	MemoryCursor::MemoryCursor(MemoryStorage& storage, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, TransactionContext& transactionContext)
+		: Cursor(left, right, openLeft, openRight, isReversed, omitDuplicates),
+		  transactionContext(transactionContext),
+		  storage(storage),
+		  isRemoved(false),
+		  totalCount(-1),
+		  isOpen(true)
+		{ }
+
+	void MemoryCursor::start()
+		{
+		MemoryOperation operation(storage, transactionContext);
+		current = first(operation, *getTable());
+		operation.commit();
+
+		if(!current.is_initialized() || isOutOfRange(Key(current->first)))
+			{
+			close();
+			throw ImplementationException("NOT_FOUND_ERR", ImplementationException::NOT_FOUND_ERR);
+			}
+		}
+
+	Key MemoryCursor::getKey()
+		{
+		ensureOpen();
+		return getCurrent() != NULL ? Key(getCurrent()->first) : Key::getUndefinedKey();
+		}
+
+	bool MemoryCursor::next(TransactionContext& transactionContext)
+		{
+		ensureOpen();
+
+		if(!current.is_initialized())
+			return false;
+
+		MemoryOperation operation(storage, this->transactionContext);
+		TablePtr table = getTable();
+		optional<Entry> result = settle(operation, *table, step(*table, current.get()));
+		operation.commit();
+
+		if(!result.is_initialized())
+			return false;
+
+		current = result;
+		isRemoved = false;
+		return !isOutOfRange(Key(current->first));
+		}
+
+	bool MemoryCursor::next(const Key& key)
+		{
+		ensureOpen();
+
+		MemoryOperation operation(storage, transactionContext);
+		optional<Entry> position = getTable()->find(key);
+
+		if(!position.is_initialized())
+			return false;
+
+		current = position;
+		isRemoved = false;
+		return true;
+		}
+
+	unsigned long MemoryCursor::getCount(TransactionContext& transactionContext)
+		{
+		ensureOpen();
+
+		if(totalCount == -1)
+			{
+			MemoryOperation operation(storage, this->transactionContext);
+			TablePtr table = getTable();
+			long count = 0;
+
+			// TODO As with Berkeley DB, this is an O(n) iteration over the interval
+			for(optional<Entry> entry = first(operation, *table);
+				entry.is_initialized() && !isOutOfRange(Key(entry->first));
+				entry = settle(operation, *table, step(*table, entry.get())))
+				++count;
+
+			operation.commit();
+			totalCount = count;
+			}
+
+		return totalCount;
+		}
+
+	void MemoryCursor::remove()
+		{
+		ensureOpen();
+
+		if(getCurrent() == NULL)
+			throw ImplementationException("NOT_FOUND_ERR", ImplementationException::NOT_FOUND_ERR);
+
+		MemoryOperation operation(storage, transactionContext);
+		removeEntry(operation, current.get());
+		operation.commit();
+
+		isRemoved = true;
+		}
+
+	void MemoryCursor::close()
+		{
+		lock_guard<mutex> guard(synchronization);
+		isOpen = false;
+		}
+
+	void MemoryCursor::ensureOpen()
+		{
+		if(!isOpen)
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		}
+
+	optional<Entry> MemoryCursor::first(MemoryOperation& operation, const Table& table)
+		{ return settle(operation, table, initial(table)); }
+
+	optional<Entry> MemoryCursor::settle(MemoryOperation& operation, const Table& table, optional<Entry> position)
+		{
+		// An entry that is not valid may be erased as it is checked, so we step relative to it
+		while(position.is_initialized() && !isValid(operation, position.get()))
+			position = step(table, position.get());
+
+		return position;
+		}
+
+	optional<Entry> MemoryCursor::initial(const Table& table) const
+		{
+		optional<Entry> position;
+
+		if(isReversed && right.getType() == Data::Undefined)
+			position = table.last();
+		else if(isReversed)
+			{
+			// Find the first entry beyond the right bound (or at it, if it is open), and then go back one
+			position = table.next(Table::lowestEntry(right), true);
+			if(!openRight)
+				while(position.is_initialized() && position->first == right)
+					position = table.next(position.get(), false);
+			position = position.is_initialized() ? table.previous(position.get(), false) : table.last();
+			}
+		else if(left.getType() == Data::Undefined)
+			position = table.first();
+		else
+			{
+			position = table.next(Table::lowestEntry(left), true);
+			if(openLeft)
+				while(position.is_initialized() && position->first == left)
+					position = table.next(position.get(), false);
+			}
+
+		return position;
+		}
+
+	optional<Entry> MemoryCursor::step(const Table& table, const Entry& entry) const
+		{
+		optional<Entry> position;
+
+		// The entry need not still be in the table (e.g. following a removal); we seek relative to it
+		if(!isReversed)
+			{
+			position = table.next(entry, false);
+			if(omitDuplicates)
+				while(position.is_initialized() && position->first == entry.first)
+					position = table.next(position.get(), false);
+			}
+		else
+			{
+			position = table.previous(entry, false);
+			if(omitDuplicates)
+				while(position.is_initialized() && position->first == entry.first)
+					position = table.previous(position.get(), false);
+			}
+
+		return position;
+		}
+
+	bool MemoryCursor::isOutOfRange(const Key& key) const
+		{
+		if(isReversed)
+			return left.getType() != Data::Undefined &&
+					(openLeft
+						? left >= key
+						: left > key);
+		else
+			return right.getType() != Data::Undefined &&
+					(openRight
+						? right <= key
+						: right < key);
+		}
+	}
+}
+}
+}
@@ -0,0 +1,88 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYCURSOR_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYCURSOR_H
+
+#include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
+#include "MemoryStorage.h"
+#include "../Cursor.h"
+#include "../Key.h"
+#include "../Data.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory {
+
+	class MemoryOperation;
+
+	///<summary>
+	/// This abstract class represents a cursor over an in-memory table.  Rather than holding an iterator
+	/// (which other operations may invalidate), the cursor remembers the entry at its position and seeks
+	/// relative to it whenever it moves; each movement is a separate operation against the database.
+	///</summary>
+	class MemoryCursor : public Cursor
+		{
+		public:
+			virtual ~MemoryCursor() { }
+
+			virtual Key getKey();
+			virtual unsigned long getCount(TransactionContext& transactionContext);
+			virtual bool next(TransactionContext& transactionContext);
+			virtual bool next(const Key& key);
+			virtual void remove();
+			virtual void close();
+
+		protected:
+			/// Construct a cursor over an in-memory table with the given (left, right) interval (possibly open on one or both ends)
+			MemoryCursor(MemoryStorage& storage, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, TransactionContext& transactionContext);
+
+			/// Positions the cursor at the start of its interval; throws NOT_FOUND_ERR if the interval is empty.
+			/// Derived classes call this once constructed, so that their overrides are in effect.
+			void start();
+
+			/// Gets the table over which this cursor iterates
+			virtual TablePtr getTable() = 0;
+			/// Determines whether the cursor may rest on the given entry (entries that may not are skipped)
+			virtual bool isValid(MemoryOperation& operation, const Entry& entry) { return true; }
+			/// Removes the given entry from the underlying table
+			virtual void removeEntry(MemoryOperation& operation, const Entry& entry) = 0;
+
+			/// Gets the entry at the current cursor position (NULL if there is none, e.g. following a removal)
+			const Entry* getCurrent() const { return current.is_initialized() && !isRemoved ? &current.get() : NULL; }
+			MemoryStorage& getStorage() { return storage; }
+			/// The transaction context in which this cursor was opened (and in which it operates)
+			TransactionContext transactionContext;
+
+			/// Helper method to ensure that the cursor is open; throw otherwise
+			void ensureOpen();
+
+		private:
+			MemoryStorage& storage;
+			boost::optional<Entry> current;
+			bool isRemoved;
+			long totalCount;
+			volatile bool isOpen;
+
+			boost::mutex synchronization;
+
+			/// Utility methods used to find the first entry in the interval, and to step between entries
+			boost::optional<Entry> first(MemoryOperation& operation, const Table& table);
+			boost::optional<Entry> settle(MemoryOperation& operation, const Table& table, boost::optional<Entry> position);
+			boost::optional<Entry> initial(const Table& table) const;
+			boost::optional<Entry> step(const Table& table, const Entry& entry) const;
+
+			/// Utility method to determine if a key is outside of the cursor's defined interval
+			bool isOutOfRange(const Key& key) const;
+		};
+	}
+}
+}
+}
+
+#endif
@@ -0,0 +1,59 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include "MemoryDatabase.h"
+#include "MemoryDatabaseFactory.h"
+#include "MemoryObjectStore.h"
+#include "MemoryTransaction.h"
+#include "../ImplementationException.h"
+
+using std::string;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory
+	{
+	const string MemoryDatabase::metadataTableSuffix = "__metadata";
+
+	MemoryDatabase::MemoryDatabase(const string& origin, const string& name, const string& description, const bool modifyDatabase, const DatabaseConfiguration& configuration)
+		: storage(MemoryStorage::getInstance(origin, name))
+		{
+		metadata.reset(new MemoryObjectStore(*this, name + metadataTableSuffix,
+			ObjectStore::READ_WRITE, true, TransactionContext()));
+		}
+
+	MemoryDatabase::MemoryDatabase(const boost::shared_ptr<MemoryStorage>& storage, const string& name)
+		: storage(storage)
+		{
+		metadata.reset(new MemoryObjectStore(*this, name + metadataTableSuffix,
+			ObjectStore::READ_WRITE, true, TransactionContext()));
+		}
+
+	MemoryDatabase::~MemoryDatabase()
+		{
+		try
+			{ metadata->close(); }
+		catch(ImplementationException&) { }
+		}
+
+	void MemoryDatabase::removeObjectStore(const string& objectStoreName, TransactionContext& transactionContext)
+		{
+		MemoryOperation operation(getStorage(), transactionContext);
+
+		if(!getStorage().getTable(objectStoreName))
+			throw ImplementationException("NOT_FOUND_ERR", ImplementationException::NOT_FOUND_ERR);
+
+		operation.removeTable(objectStoreName);
+		operation.commit();
+		}
+
+	AbstractDatabaseFactory& MemoryDatabase::getFactory()
+		{ return AbstractDatabaseFactory::getInstance(MemoryDatabaseFactory::engineName); }
+	}
+}
+}
+}
@@ -0,0 +1,63 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYDATABASE_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYDATABASE_H
+
+#include <memory>
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include "MemoryStorage.h"
+#include "../Database.h"
+#include "../Transaction.h"
+#include "../DatabaseConfiguration.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+
+	class ObjectStore;
+
+	namespace Memory {
+
+		///<summary>
+		/// This class represents an Indexed Database API database that is held entirely in memory.  Each object
+		/// store and index is an ordered table in a storage instance shared by all handles on the database; the
+		/// contents last until the process (i.e. the browser session) ends.  Engine tuning (cache and page sizes,
+		/// durability and compression) has no meaning here, and is ignored.
+		///</summary>
+		class MemoryDatabase : public Database
+			{
+			public:
+				MemoryDatabase(const std::string& origin, const std::string& name, const std::string& description, const bool modifyDatabase, const DatabaseConfiguration& configuration);
+				virtual ~MemoryDatabase(void);
+
+				virtual void removeObjectStore(const std::string& objectStoreName, TransactionContext& transactionContext);
+				virtual ObjectStore& getMetadata() { return *metadata; }
+				virtual AbstractDatabaseFactory& getFactory();
+
+				// Gets the tables that make up this database
+				MemoryStorage& getStorage() { return *storage; }
+
+			protected:
+				// Used by derived engines that persist the tables (e.g. LsmDatabase)
+				MemoryDatabase(const boost::shared_ptr<MemoryStorage>& storage, const std::string& name);
+
+			private:
+				// The tables for this database (shared with any other handles open on it)
+				boost::shared_ptr<MemoryStorage> storage;
+				// An object store containing metdata for this database
+				std::auto_ptr<ObjectStore> metadata;
+
+				// An fixed suffix for metadata table naming (e.g. "__metadata")
+				static const std::string metadataTableSuffix;
+			};
+		}
+	}
+}
+}
+
+#endif
@@ -0,0 +1,58 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include "MemoryDatabaseFactory.h"
+#include "MemoryDatabase.h"
+#include "MemoryObjectStore.h"
+#include "MemoryObjectStoreCursor.h"
+#include "MemoryIndex.h"
+#include "MemoryIndexCursor.h"
+#include "MemoryTransaction.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory
+	{
+	using ::std::auto_ptr;
+	using ::std::string;
+	using ::boost::optional;
+
+	const string MemoryDatabaseFactory::engineName = "memory";
+
+	auto_ptr<Database> MemoryDatabaseFactory::createDatabase(const string& origin, const string& name, const string& description, const bool modifyDatabase, const DatabaseConfiguration& configuration)
+		{ return auto_ptr<Database>(new MemoryDatabase(origin, name, description, modifyDatabase, configuration)); }
+
+	auto_ptr<ObjectStore> MemoryDatabaseFactory::createObjectStore(Database& database, const string& name, const bool autoIncrement, const ObjectStore::AccessMethod accessMethod, TransactionContext& transactionContext)
+		{ return auto_ptr<ObjectStore>(new MemoryObjectStore(static_cast<MemoryDatabase&>(database), name, autoIncrement, transactionContext)); }
+
+	auto_ptr<ObjectStore> MemoryDatabaseFactory::openObjectStore(Database& database, const string& name, const ObjectStore::Mode mode, TransactionContext& transactionContext)
+		{ return auto_ptr<ObjectStore>(new MemoryObjectStore(static_cast<MemoryDatabase&>(database), name, mode, false, transactionContext)); }
+
+	auto_ptr<Transaction> MemoryDatabaseFactory::createTransaction(Database& database, const ObjectStoreImplementationList& objectStores, const optional<ObjectStore::Mode>& mode, const optional<unsigned int>& timeout, const optional<DatabaseConfiguration::Durability>& durability, TransactionContext& transactionContext)
+		{ return auto_ptr<Transaction>(new MemoryTransaction(static_cast<MemoryDatabase&>(database), timeout, transactionContext)); }
+
+	auto_ptr<Index> MemoryDatabaseFactory::createIndex(ObjectStore& objectStore, const string& name, const auto_ptr<KeyGenerator>& keyGenerator, const bool unique, TransactionContext& transactionContext)
+		{ return auto_ptr<Index>(new MemoryIndex(static_cast<MemoryObjectStore&>(objectStore), name, keyGenerator, unique, transactionContext, true)); }
+
+	auto_ptr<Index> MemoryDatabaseFactory::createIndex(ObjectStore& objectStore, const string& name, const bool unique, TransactionContext& transactionContext)
+		{ return auto_ptr<Index>(new MemoryIndex(static_cast<MemoryObjectStore&>(objectStore), name, unique, transactionContext, true)); }
+
+	auto_ptr<Index> MemoryDatabaseFactory::openIndex(ObjectStore& objectStore, const string& name, const auto_ptr<KeyGenerator>& keyGenerator, const bool unique, TransactionContext& transactionContext)
+		{ return auto_ptr<Index>(new MemoryIndex(static_cast<MemoryObjectStore&>(objectStore), name, keyGenerator, unique, transactionContext, false)); }
+
+	auto_ptr<Index> MemoryDatabaseFactory::openIndex(ObjectStore& objectStore, const string& name, const bool unique, TransactionContext& transactionContext)
+		{ return auto_ptr<Index>(new MemoryIndex(static_cast<MemoryObjectStore&>(objectStore), name, unique, transactionContext, false)); }
+
+	auto_ptr<Cursor> MemoryDatabaseFactory::openCursor(ObjectStore& objectStore, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const Cursor::Isolation isolation, TransactionContext& transactionContext)
+		{ return auto_ptr<Cursor>(new MemoryObjectStoreCursor(static_cast<MemoryObjectStore&>(objectStore), left, right, openLeft, openRight, isReversed, omitDuplicates, transactionContext)); }
+
+	auto_ptr<Cursor> MemoryDatabaseFactory::openCursor(Index& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool returnKeys, const Cursor::Isolation isolation, TransactionContext& transactionContext)
+		{ return auto_ptr<Cursor>(new MemoryIndexCursor(static_cast<MemoryIndex&>(index), left, right, openLeft, openRight, isReversed, omitDuplicates, returnKeys, transactionContext)); }
+	}
+}
+}
+}
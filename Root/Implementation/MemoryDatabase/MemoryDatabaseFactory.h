@@ -0,0 +1,49 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYDATABASEFACTORY_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYDATABASEFACTORY_H
+
+#include "../AbstractDatabaseFactory.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory {
+
+	///<summary>
+	/// This class is a concrete realization of the abstract implementation factory; it produces instances
+	/// that are held entirely in memory (and so do not outlive the browser session).
+	///</summary>
+	class MemoryDatabaseFactory : public AbstractDatabaseFactory
+		{
+		public:
+			MemoryDatabaseFactory(void) { }
+			~MemoryDatabaseFactory(void) { }
+
+			// The name by which this engine is selected (e.g. "memory")
+			static const std::string engineName;
+
+			virtual std::auto_ptr<Database> createDatabase(const std::string& origin, const std::string& name, const std::string& description, const bool modifyDatabase = true, const DatabaseConfiguration& configuration = DatabaseConfiguration());
+			virtual std::auto_ptr<ObjectStore> createObjectStore(Database& database, const std::string& name, const bool autoIncrement = true, const ObjectStore::AccessMethod accessMethod = ObjectStore::ORDERED, TransactionContext& transactionContext = TransactionContext());
+			virtual std::auto_ptr<ObjectStore> openObjectStore(Database& database, const std::string& name, const ObjectStore::Mode mode, TransactionContext& transactionContext);
+
+			virtual std::auto_ptr<Index> createIndex(ObjectStore& objectStore, const std::string& name, const std::auto_ptr<KeyGenerator>& keyGenerator, const bool unique, TransactionContext& transactionContext);
+			virtual std::auto_ptr<Index> createIndex(ObjectStore& objectStore, const std::string& name, const bool unique, TransactionContext& transactionContext);
+			virtual std::auto_ptr<Index> openIndex(ObjectStore& objectStore, const std::string& name, const std::auto_ptr<KeyGenerator>& keyGenerator, const bool unique, TransactionContext& transactionContext);
+			virtual std::auto_ptr<Index> openIndex(ObjectStore& objectStore, const std::string& name, const bool unique, TransactionContext& transactionContext);
+
+			virtual std::auto_ptr<Cursor> openCursor(ObjectStore& objectStore, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const Cursor::Isolation isolation, TransactionContext& transactionContext);
+			virtual std::auto_ptr<Cursor> openCursor(Index& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool returnkeys, const Cursor::Isolation isolation, TransactionContext& transactionContext);
+
+			virtual std::auto_ptr<Transaction> createTransaction(Database& database, const ObjectStoreImplementationList& objectStores, const boost::optional<ObjectStore::Mode>& mode, const boost::optional<unsigned int>& timeout, const boost::optional<DatabaseConfiguration::Durability>& durability, TransactionContext& transactionContext);
+		};
+	}
+}
+}
+}
+
+#endif
@@ -0,0 +1,218 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <vector>
+#include "MemoryIndex.h"
+#include "MemoryDatabase.h"
+#include "MemoryObjectStore.h"
+#include "MemoryTransaction.h"
+#include "../Key.h"
+#include "../KeyGenerator.h"
+#include "../ImplementationException.h"
+
+using std::string;
+using std::vector;
+using boost::mutex;
+using boost::lock_guard;
+using boost::optional;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory
+	{
+	MemoryIndex::MemoryIndex(MemoryObjectStore& objectStore, const string& name, const std::auto_ptr<KeyGenerator>& keyGenerator, const bool unique, TransactionContext& transactionContext, const bool create)
+		: objectStore(objectStore), name(name), keyGenerator(keyGenerator.get()), unique(unique), isOpen(true)
+		{ open(transactionContext, create); }
+
+	MemoryIndex::MemoryIndex(MemoryObjectStore& objectStore, const string& name, const bool unique, TransactionContext& transactionContext, const bool create)
+		: objectStore(objectStore), name(name), keyGenerator(NULL), unique(unique), isOpen(true)
+		{ open(transactionContext, create); }
+
+	MemoryIndex::~MemoryIndex(void)
+		{
+		try
+			{ close(); }
+		catch(ImplementationException&)
+			{ }
+		}
+
+	void MemoryIndex::open(TransactionContext& transactionContext, const bool create)
+		{
+		MemoryOperation operation(objectStore.getDatabase().getStorage(), transactionContext);
+
+		if(!objectStore.getDatabase().getStorage().getTable(name))
+			{
+			if(!create)
+				throw ImplementationException("NOT_FOUND_ERR", ImplementationException::NOT_FOUND_ERR);
+
+			operation.createTable(name);
+
+			// A new index with a key generator is populated from the existing contents of its object store
+			if(isAutomatic())
+				{
+				TablePtr values = objectStore.getTable();
+				for(optional<Entry> value = values->first(); value.is_initialized(); value = values->next(value.get(), false))
+					addEntry(operation, Key(value->first), value->second);
+				}
+			}
+
+		operation.commit();
+
+		if(isAutomatic())
+			objectStore.attach(*this);
+		}
+
+	Key MemoryIndex::getPrimaryKey(const Key& secondaryKey, TransactionContext& transactionContext)
+		{
+		ensureOpen();
+
+		MemoryOperation operation(objectStore.getDatabase().getStorage(), transactionContext);
+		optional<Entry> entry = find(operation, secondaryKey);
+		operation.commit();
+
+		return entry.is_initialized() ? Key(entry->second) : Key::getUndefinedKey();
+		}
+
+	Data MemoryIndex::get(const Key& secondaryKey, TransactionContext& transactionContext)
+		{
+		ensureOpen();
+
+		MemoryOperation operation(objectStore.getDatabase().getStorage(), transactionContext);
+		optional<Entry> entry = find(operation, secondaryKey);
+		Data data = entry.is_initialized() ? objectStore.read(operation, Key(entry->second)) : Data::getUndefinedData();
+		operation.commit();
+
+		return data;
+		}
+
+	void MemoryIndex::put(const Key& secondaryKey, const Data& primaryKey, const bool noOverwrite, TransactionContext& transactionContext)
+		{
+		if(isAutomatic())
+			throw ImplementationException(ImplementationException::NOT_ALLOWED_ERR);
+
+		ensureOpen();
+
+		MemoryOperation operation(objectStore.getDatabase().getStorage(), transactionContext);
+		TablePtr table = getTable();
+		optional<Entry> existing = table->find(secondaryKey);
+
+		if(!objectStore.contains(operation, Key(primaryKey)))
+			throw ImplementationException("CONSTRAINT_ERR", ImplementationException::CONSTRAINT_ERR);
+		else if(existing.is_initialized() && noOverwrite)
+			throw ImplementationException("CONSTRAINT_ERR", ImplementationException::CONSTRAINT_ERR);
+		// A unique index holds a single primary key for each secondary key, which a put replaces
+		else if(existing.is_initialized() && unique)
+			operation.erase(table, existing.get());
+
+		operation.insert(table, Entry(secondaryKey, primaryKey));
+		operation.commit();
+		}
+
+	void MemoryIndex::remove(const Key& secondaryKey, TransactionContext& transactionContext)
+		{
+		ensureOpen();
+
+		MemoryOperation operation(objectStore.getDatabase().getStorage(), transactionContext);
+		TablePtr table = getTable();
+		vector<Entry> entries;
+
+		for(optional<Entry> entry = table->find(secondaryKey);
+			entry.is_initialized() && entry->first == secondaryKey;
+			entry = table->next(entry.get(), false))
+			entries.push_back(entry.get());
+
+		if(entries.empty() && !isAutomatic())
+			throw ImplementationException("NOT_FOUND_ERR", ImplementationException::NOT_FOUND_ERR);
+
+		// Removing through an index with a key generator removes the associated values (and thus the index
+		// entries), as it does for a Berkeley DB secondary; otherwise only the index entries are removed
+		for(vector<Entry>::const_iterator entry = entries.begin(); entry != entries.end(); entry++)
+			if(isAutomatic())
+				objectStore.erase(operation, Key(entry->second));
+			else
+				operation.erase(table, *entry);
+
+		operation.commit();
+		}
+
+	void MemoryIndex::close()
+		{
+		lock_guard<mutex> guard(synchronization);
+
+		if(isOpen)
+			{
+			isOpen = false;
+			if(isAutomatic())
+				objectStore.detach(*this);
+			}
+		}
+
+	void MemoryIndex::addEntry(MemoryOperation& operation, const Key& primaryKey, const Data& data)
+		{
+		TablePtr table = objectStore.getDatabase().getStorage().getTable(name);
+
+		// The index may have been removed while still open
+		if(table)
+			{
+			Key secondaryKey(keyGenerator->generateKey(data));
+
+			if(unique && table->find(secondaryKey).is_initialized())
+				throw ImplementationException("CONSTRAINT_ERR", ImplementationException::CONSTRAINT_ERR);
+
+			operation.insert(table, Entry(secondaryKey, primaryKey));
+			}
+		}
+
+	void MemoryIndex::removeEntry(MemoryOperation& operation, const Key& primaryKey, const Data& data)
+		{
+		TablePtr table = objectStore.getDatabase().getStorage().getTable(name);
+
+		if(table)
+			operation.erase(table, Entry(keyGenerator->generateKey(data), primaryKey));
+		}
+
+	bool MemoryIndex::ensurePrimaryKeyExists(MemoryOperation& operation, const Entry& entry)
+		{
+		if(isAutomatic() || objectStore.contains(operation, Key(entry.second)))
+			return true;
+
+		operation.erase(getTable(), entry);
+		return false;
+		}
+
+	optional<Entry> MemoryIndex::find(MemoryOperation& operation, const Key& secondaryKey)
+		{
+		TablePtr table = getTable();
+
+		// We seek relative to each entry, since a stale entry is erased as it is checked
+		for(optional<Entry> entry = table->find(secondaryKey);
+			entry.is_initialized() && entry->first == secondaryKey;
+			entry = table->next(entry.get(), false))
+			if(ensurePrimaryKeyExists(operation, entry.get()))
+				return entry;
+
+		return optional<Entry>();
+		}
+
+	TablePtr MemoryIndex::getTable()
+		{
+		TablePtr table = objectStore.getDatabase().getStorage().getTable(name);
+
+		if(!table)
+			throw ImplementationException("NOT_FOUND_ERR", ImplementationException::NOT_FOUND_ERR);
+		return table;
+		}
+
+	void MemoryIndex::ensureOpen()
+		{
+		if(!isOpen)
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		}
+	}
+}
+}
+}
@@ -0,0 +1,87 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYINDEX_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYINDEX_H
+
+#include <memory>
+#include <string>
+#include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
+#include "MemoryStorage.h"
+#include "../Index.h"
+#include "../Transaction.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+
+	class KeyGenerator;
+	class Key;
+	class Data;
+
+	namespace Memory {
+
+		class MemoryObjectStore;
+		class MemoryOperation;
+
+		///<summary>
+		/// This class represents an index held in memory; its table maps secondary keys to primary keys.  An
+		/// index with a key generator is kept synchronized with its object store as values are put and removed.
+		/// An index without one (the spec calls them non-auto-populated indices) is populated explicitly, and
+		/// entries whose primary key no longer exists are discarded as they are encountered (as we do for
+		/// Berkeley DB manual indexes).
+		///</summary>
+		class MemoryIndex : public Index
+			{
+			public:
+				MemoryIndex(MemoryObjectStore& objectStore, const std::string& name, const std::auto_ptr<KeyGenerator>& keyGenerator, const bool unique, TransactionContext& transactionContext, const bool create);
+				MemoryIndex(MemoryObjectStore& objectStore, const std::string& name, const bool unique, TransactionContext& transactionContext, const bool create);
+				virtual ~MemoryIndex(void);
+
+				virtual Data get(const Key& secondaryKey, TransactionContext& transactionContext);
+				virtual Key getPrimaryKey(const Key& secondaryKey, TransactionContext& transactionContext);
+				virtual void put(const Key& secondaryKey, const Data& primaryKey, const bool noOverwrite, TransactionContext& transactionContext);
+				virtual void remove(const Key& secondaryKey, TransactionContext& transactionContext);
+				virtual void close();
+
+				// Synchronizes this index with a change to its object store (used only when there is a key generator)
+				void addEntry(MemoryOperation& operation, const Key& primaryKey, const Data& data);
+				void removeEntry(MemoryOperation& operation, const Key& primaryKey, const Data& data);
+
+				// Determines whether the given entry refers to an existing primary key, discarding it if not
+				bool ensurePrimaryKeyExists(MemoryOperation& operation, const Entry& entry);
+
+				MemoryObjectStore& getObjectStore() { return objectStore; }
+				TablePtr getTable();
+				bool isAutomatic() const { return keyGenerator != NULL; }
+
+			private:
+				// The object store over which this index is defined
+				MemoryObjectStore& objectStore;
+				// The name of this index (and of its table)
+				const std::string name;
+				// Generates secondary keys from values (NULL for a manual index)
+				const KeyGenerator* keyGenerator;
+				// Flag indicating whether secondary keys must be unique
+				const bool unique;
+				// Flag indicating whether the index is open
+				volatile bool isOpen;
+
+				// Some of our operations must be synchronized for thread safety
+				boost::mutex synchronization;
+
+				void open(TransactionContext& transactionContext, const bool create);
+				// Finds the first (live) entry for the given secondary key
+				boost::optional<Entry> find(MemoryOperation& operation, const Key& secondaryKey);
+				void ensureOpen();
+			};
+		}
+	}
+}
+}
+
+#endif
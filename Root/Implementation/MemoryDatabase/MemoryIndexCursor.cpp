@@ -0,0 +1,54 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include "MemoryIndexCursor.h"
+#include "MemoryIndex.h"
+#include "MemoryDatabase.h"
+#include "MemoryObjectStore.h"
+#include "MemoryTransaction.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory
+	{
+	MemoryIndexCursor::MemoryIndexCursor(MemoryIndex& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool dataArePrimaryKeys, TransactionContext& transactionContext)
+		: MemoryCursor(index.getObjectStore().getDatabase().getStorage(), left, right, openLeft, openRight, isReversed, omitDuplicates, transactionContext),
+		  index(index),
+		  dataArePrimaryKeys(dataArePrimaryKeys)
+		{ start(); }
+
+	Data MemoryIndexCursor::getData(TransactionContext& transactionContext)
+		{
+		ensureOpen();
+
+		if(getCurrent() == NULL)
+			return Data::getUndefinedData();
+		else if(dataArePrimaryKeys)
+			return getCurrent()->second;
+
+		MemoryOperation operation(getStorage(), this->transactionContext);
+		return index.getObjectStore().read(operation, Key(getCurrent()->second));
+		}
+
+	TablePtr MemoryIndexCursor::getTable()
+		{ return index.getTable(); }
+
+	bool MemoryIndexCursor::isValid(MemoryOperation& operation, const Entry& entry)
+		{ return index.ensurePrimaryKeyExists(operation, entry); }
+
+	void MemoryIndexCursor::removeEntry(MemoryOperation& operation, const Entry& entry)
+		{
+		// As with a Berkeley DB secondary, removing through an index with a key generator removes the value
+		if(index.isAutomatic())
+			index.getObjectStore().erase(operation, Key(entry.second));
+		else
+			operation.erase(index.getTable(), entry);
+		}
+	}
+}
+}
+}
@@ -0,0 +1,46 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYINDEXCURSOR_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYINDEXCURSOR_H
+
+#include "MemoryCursor.h"
+#include "../Transaction.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory {
+
+	class MemoryIndex;
+
+	///<summary>
+	/// This class represents a cursor over an index held in memory.  Over a manual index, entries whose
+	/// primary key no longer exists are discarded as the cursor encounters them.
+	///</summary>
+	class MemoryIndexCursor : public MemoryCursor
+		{
+		public:
+			MemoryIndexCursor(MemoryIndex& index, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, const bool dataArePrimaryKeys, TransactionContext& transactionContext);
+
+			virtual Data getData(TransactionContext& transactionContext);
+
+		protected:
+			virtual TablePtr getTable();
+			virtual bool isValid(MemoryOperation& operation, const Entry& entry);
+			virtual void removeEntry(MemoryOperation& operation, const Entry& entry);
+
+		private:
+			MemoryIndex& index;
+			// Cursor must be configured at creation to return primary keys or primary values
+			const bool dataArePrimaryKeys;
+		};
+	}
+}
+}
+}
+
+#endif
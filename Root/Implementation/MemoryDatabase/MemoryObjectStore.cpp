@@ -0,0 +1,209 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include "MemoryObjectStore.h"
+#include "MemoryDatabase.h"
+#include "MemoryIndex.h"
+#include "MemoryTransaction.h"
+#include "../ImplementationException.h"
+#include "../Key.h"
+#include "../Data.h"
+
+using std::list;
+using std::string;
+using std::vector;
+using boost::mutex;
+using boost::lock_guard;
+using boost::optional;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory
+	{
+	MemoryObjectStore::MemoryObjectStore(MemoryDatabase& database, const string& name, const bool autoIncrement, TransactionContext& transactionContext)
+		: database(database), name(name), readOnly(false), isOpen(true)
+		{
+		MemoryOperation operation(database.getStorage(), transactionContext);
+
+		if(database.getStorage().getTable(name))
+			throw ImplementationException("UNKNOWN_ERR", ImplementationException::UNKNOWN_ERR);
+
+		operation.createTable(name);
+		operation.commit();
+		}
+
+	MemoryObjectStore::MemoryObjectStore(MemoryDatabase& database, const string& name, const Mode mode, const bool create, TransactionContext& transactionContext)
+		: database(database), name(name), readOnly(mode != ObjectStore::READ_WRITE), isOpen(true)
+		{
+		MemoryOperation operation(database.getStorage(), transactionContext);
+
+		if(database.getStorage().getTable(name))
+			return;
+		else if(!create)
+			throw ImplementationException("NOT_FOUND_ERR", ImplementationException::NOT_FOUND_ERR);
+
+		operation.createTable(name);
+		operation.commit();
+		}
+
+	MemoryObjectStore::~MemoryObjectStore()
+		{ close(); }
+
+	Data MemoryObjectStore::get(const Key& key, TransactionContext& transactionContext)
+		{
+		ensureOpen(false);
+
+		MemoryOperation operation(database.getStorage(), transactionContext);
+		return read(operation, key);
+		}
+
+	bool MemoryObjectStore::exists(const Key& key, TransactionContext& transactionContext)
+		{
+		ensureOpen(false);
+
+		MemoryOperation operation(database.getStorage(), transactionContext);
+		return contains(operation, key);
+		}
+
+	void MemoryObjectStore::put(const Key& key, const Data& data, const bool noOverwrite, TransactionContext& transactionContext)
+		{
+		ensureOpen(true);
+
+		MemoryOperation operation(database.getStorage(), transactionContext);
+		write(operation, key, data, noOverwrite);
+		operation.commit();
+		}
+
+	void MemoryObjectStore::remove(const Key& key, TransactionContext& transactionContext)
+		{
+		ensureOpen(true);
+
+		MemoryOperation operation(database.getStorage(), transactionContext);
+		erase(operation, key);
+		operation.commit();
+		}
+
+	void MemoryObjectStore::enableCompression(TransactionContext& transactionContext)
+		{
+		// Values are held as-is; compression trades CPU for I/O we never perform
+		ensureOpen(true);
+		}
+
+	void MemoryObjectStore::freeze(const vector<string>& indexNames, TransactionContext& transactionContext)
+		{
+		// Tables are already ordered in memory, so a frozen copy would offer nothing that they do not
+		ensureOpen(true);
+		if(transactionContext.is_initialized())
+			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
+		}
+
+	void MemoryObjectStore::thaw(TransactionContext& transactionContext)
+		{ 
+		ensureOpen(true); 
+		if(transactionContext.is_initialized())
+			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
+		}
+
+	void MemoryObjectStore::close()
+		{
+		lock_guard<mutex> guard(synchronization);
+		isOpen = false;
+		}
+
+	void MemoryObjectStore::removeIndex(const string& name, TransactionContext& transactionContext)
+		{
+		ensureOpen(false);
+
+		MemoryOperation operation(database.getStorage(), transactionContext);
+		operation.removeTable(name);
+		operation.commit();
+		}
+
+	Data MemoryObjectStore::read(MemoryOperation& operation, const Key& key)
+		{
+		optional<Entry> entry = getTable()->find(key);
+		return entry.is_initialized() ? entry->second : Data::getUndefinedData();
+		}
+
+	bool MemoryObjectStore::contains(MemoryOperation& operation, const Key& key)
+		{
+		return getTable()->find(key).is_initialized();
+		}
+
+	void MemoryObjectStore::write(MemoryOperation& operation, const Key& key, const Data& data, const bool noOverwrite)
+		{
+		ensureOpen(true);
+
+		TablePtr table = getTable();
+		optional<Entry> existing = table->find(key);
+		lock_guard<mutex> guard(synchronization);
+
+		if(existing.is_initialized())
+			{
+			// As with Berkeley DB, a put that may not overwrite an existing value is silently ignored
+			if(noOverwrite)
+				return;
+
+			for(list<MemoryIndex*>::const_iterator index = indexes.begin(); index != indexes.end(); index++)
+				(*index)->removeEntry(operation, key, existing->second);
+			operation.erase(table, existing.get());
+			}
+
+		operation.insert(table, Entry(key, data));
+		for(list<MemoryIndex*>::const_iterator index = indexes.begin(); index != indexes.end(); index++)
+			(*index)->addEntry(operation, key, data);
+		}
+
+	void MemoryObjectStore::erase(MemoryOperation& operation, const Key& key)
+		{
+		ensureOpen(true);
+
+		TablePtr table = getTable();
+		optional<Entry> existing = table->find(key);
+		lock_guard<mutex> guard(synchronization);
+
+		if(existing.is_initialized())
+			{
+			for(list<MemoryIndex*>::const_iterator index = indexes.begin(); index != indexes.end(); index++)
+				(*index)->removeEntry(operation, key, existing->second);
+			operation.erase(table, existing.get());
+			}
+		}
+
+	TablePtr MemoryObjectStore::getTable()
+		{
+		TablePtr table = database.getStorage().getTable(name);
+
+		// The object store may have been removed (by another handle) since it was opened
+		if(!table)
+			throw ImplementationException("NOT_FOUND_ERR", ImplementationException::NOT_FOUND_ERR);
+		return table;
+		}
+
+	void MemoryObjectStore::attach(MemoryIndex& index)
+		{
+		lock_guard<mutex> guard(synchronization);
+		indexes.push_back(&index);
+		}
+
+	void MemoryObjectStore::detach(MemoryIndex& index)
+		{
+		lock_guard<mutex> guard(synchronization);
+		indexes.remove(&index);
+		}
+
+	void MemoryObjectStore::ensureOpen(const bool writable)
+		{
+		if(!isOpen)
+			throw ImplementationException("NON_TRANSIENT_ERR", ImplementationException::NON_TRANSIENT_ERR);
+		else if(writable && readOnly)
+			throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
+		}
+	}
+}
+}
+}
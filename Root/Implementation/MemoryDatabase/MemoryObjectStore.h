@@ -0,0 +1,91 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYOBJECTSTORE_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYOBJECTSTORE_H
+
+#include <list>
+#include <string>
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include "MemoryStorage.h"
+#include "../ObjectStore.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+
+	class Key;
+	class Data;
+
+	namespace Memory {
+
+		class MemoryDatabase;
+		class MemoryIndex;
+		class MemoryOperation;
+
+		///<summary>
+		/// This class represents an Indexed Database API object store held in memory.  Indexes with a key
+		/// generator that are open on this handle are kept synchronized with it (as with an associated
+		/// Berkeley DB secondary, maintenance is the responsibility of the handle that opened the index).
+		///</summary>
+		class MemoryObjectStore : public ObjectStore
+			{
+			public:
+				MemoryObjectStore(MemoryDatabase& database, const std::string& name, const bool autoIncrement, TransactionContext& transactionContext);
+				MemoryObjectStore(MemoryDatabase& database, const std::string& name, const Mode mode, const bool create, TransactionContext& transactionContext);
+				~MemoryObjectStore(void);
+
+				virtual Data get(const Key& key, TransactionContext& transactionContext);
+				virtual void put(const Key& key, const Data& data, const bool noOverwrite, TransactionContext& transactionContext);
+				virtual bool exists(const Key& key, TransactionContext& transactionContext);
+				virtual void remove(const Key& key, TransactionContext& transactionContext);
+				virtual void enableCompression(TransactionContext& transactionContext);
+				virtual void freeze(const std::vector<std::string>& indexNames, TransactionContext& transactionContext);
+				virtual void thaw(TransactionContext& transactionContext);
+				virtual void close();
+
+				virtual void removeIndex(const std::string& name, TransactionContext& transactionContext);
+
+				// Operations used by indexes and cursors over this object store, which must already be within the
+				// scope of an operation (and thus hold the database lock)
+				Data read(MemoryOperation& operation, const Key& key);
+				bool contains(MemoryOperation& operation, const Key& key);
+				void write(MemoryOperation& operation, const Key& key, const Data& data, const bool noOverwrite);
+				void erase(MemoryOperation& operation, const Key& key);
+				TablePtr getTable();
+
+				// Registers (or unregisters) an index to be kept synchronized with this object store
+				void attach(MemoryIndex& index);
+				void detach(MemoryIndex& index);
+
+				MemoryDatabase& getDatabase() { return database; }
+				const std::string& getName() const { return name; }
+
+			private:
+				// The database that owns this object store
+				MemoryDatabase& database;
+				// The name of this object store (and of its table)
+				const std::string name;
+				// Flag indicating whether this object store is read-only
+				const bool readOnly;
+				// Flag indicating whether this object store is still open
+				volatile bool isOpen;
+				// Indexes (with key generators) open over this object store
+				std::list<MemoryIndex*> indexes;
+
+				// Used to thread-synch critical sections
+				boost::mutex synchronization;
+
+				// Helper method to ensure that the object store is open (and writable, if required); throw otherwise
+				void ensureOpen(const bool writable);
+			};
+		}
+	}
+}
+}
+
+#endif
@@ -0,0 +1,42 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include "MemoryObjectStoreCursor.h"
+#include "MemoryDatabase.h"
+#include "MemoryObjectStore.h"
+#include "MemoryTransaction.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory
+	{
+	MemoryObjectStoreCursor::MemoryObjectStoreCursor(MemoryObjectStore& objectStore, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, TransactionContext& transactionContext)
+		: MemoryCursor(objectStore.getDatabase().getStorage(), left, right, openLeft, openRight, isReversed, omitDuplicates, transactionContext),
+		  objectStore(objectStore)
+		{ start(); }
+
+	Data MemoryObjectStoreCursor::getData(TransactionContext& transactionContext)
+		{
+		ensureOpen();
+
+		if(getCurrent() == NULL)
+			return Data::getUndefinedData();
+
+		// The value may have been replaced since we moved here, so read it afresh
+		MemoryOperation operation(getStorage(), this->transactionContext);
+		return objectStore.read(operation, Key(getCurrent()->first));
+		}
+
+	TablePtr MemoryObjectStoreCursor::getTable()
+		{ return objectStore.getTable(); }
+
+	void MemoryObjectStoreCursor::removeEntry(MemoryOperation& operation, const Entry& entry)
+		{ objectStore.erase(operation, Key(entry.first)); }
+	}
+}
+}
+}
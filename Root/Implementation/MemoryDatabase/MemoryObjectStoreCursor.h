@@ -0,0 +1,42 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYOBJECTSTORECURSOR_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYOBJECTSTORECURSOR_H
+
+#include "MemoryCursor.h"
+#include "../Transaction.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory {
+
+	class MemoryObjectStore;
+
+	///<summary>
+	/// This class represents a cursor over an object store held in memory
+	///</summary>
+	class MemoryObjectStoreCursor : public MemoryCursor
+		{
+		public:
+			MemoryObjectStoreCursor(MemoryObjectStore& objectStore, const Key& left, const Key& right, const bool openLeft, const bool openRight, const bool isReversed, const bool omitDuplicates, TransactionContext& transactionContext);
+
+			virtual Data getData(TransactionContext& transactionContext);
+
+		protected:
+			virtual TablePtr getTable();
+			virtual void removeEntry(MemoryOperation& operation, const Entry& entry);
+
+		private:
+			MemoryObjectStore& objectStore;
+		};
+	}
+}
+}
+}
+
+#endif
@@ -0,0 +1,128 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <boost/make_shared.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include "MemoryStorage.h"
+#include "../ImplementationException.h"
+
+using std::map;
+using std::string;
+using boost::mutex;
+using boost::lock_guard;
+using boost::unique_lock;
+using boost::shared_ptr;
+using boost::optional;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory
+	{
+	map<string, shared_ptr<MemoryStorage> > MemoryStorage::instances;
+	mutex MemoryStorage::instancesSynchronization;
+
+	shared_ptr<MemoryStorage> MemoryStorage::getInstance(const string& origin, const string& name)
+		{
+		lock_guard<mutex> guard(instancesSynchronization);
+		shared_ptr<MemoryStorage>& instance = instances[origin + "/" + name];
+
+		if(!instance)
+			instance.reset(new MemoryStorage());
+		return instance;
+		}
+
+	optional<Entry> Table::find(const Data& key) const
+		{
+		optional<Entry> entry = next(lowestEntry(key), true);
+		return entry.is_initialized() && entry->first == key ? entry : optional<Entry>();
+		}
+
+	Entry Table::lowestEntry(const Data& key)
+		{
+		// An undefined value is encoded as a lone type byte of zero, which no other encoded value precedes
+		return Entry(key, Data::getUndefinedData());
+		}
+
+	optional<Entry> MemoryTable::next(const Entry& entry, const bool inclusive) const
+		{
+		std::set<Entry>::const_iterator position = inclusive ? entries.lower_bound(entry) : entries.upper_bound(entry);
+		return position != entries.end() ? *position : optional<Entry>();
+		}
+
+	optional<Entry> MemoryTable::previous(const Entry& entry, const bool inclusive) const
+		{
+		std::set<Entry>::const_iterator position = inclusive ? entries.upper_bound(entry) : entries.lower_bound(entry);
+		return position != entries.begin() ? *--position : optional<Entry>();
+		}
+
+	optional<Entry> MemoryTable::last() const
+		{ return !entries.empty() ? *entries.rbegin() : optional<Entry>(); }
+
+	TablePtr MemoryStorage::getTable(const string& name) const
+		{
+		map<string, TablePtr>::const_iterator table = tables.find(name);
+		return table != tables.end() ? table->second : TablePtr();
+		}
+
+	TablePtr MemoryStorage::createTable()
+		{ return boost::make_shared<MemoryTable>(); }
+
+	void MemoryStorage::setTable(const string& name, const TablePtr& table)
+		{ tables[name] = table; }
+
+	void MemoryStorage::removeTable(const string& name)
+		{ tables.erase(name); }
+
+	void MemoryStorage::lock(const void* owner, const unsigned int timeout)
+		{
+		unique_lock<mutex> guard(synchronization);
+		boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(timeout);
+
+		while(this->owner != NULL)
+			// Waiting on ourselves would only run out the timeout
+			if(ownerThread == boost::this_thread::get_id() ||
+			   (!released.timed_wait(guard, deadline) && this->owner != NULL))
+				throw ImplementationException("DEADLOCK_ERR", ImplementationException::DEADLOCK_ERR);
+
+		this->owner = owner;
+		ownerThread = boost::this_thread::get_id();
+		}
+
+	void MemoryStorage::unlock(const void* owner, const bool committed)
+		{
+			{
+			lock_guard<mutex> guard(synchronization);
+			if(this->owner != owner)
+				return;
+			}
+
+		// The lock is released even if the derived storage fails in what it does upon release
+		try
+			{ onRelease(committed); }
+		catch(ImplementationException&)
+			{
+			release();
+			throw;
+			}
+
+		release();
+		}
+
+	void MemoryStorage::release()
+		{
+			{
+			lock_guard<mutex> guard(synchronization);
+			this->owner = NULL;
+			ownerThread = boost::thread::id();
+			}
+
+		released.notify_one();
+		}
+	}
+}
+}
+}
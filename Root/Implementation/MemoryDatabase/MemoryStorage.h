@@ -0,0 +1,145 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYSTORAGE_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYSTORAGE_H
+
+#include <set>
+#include <map>
+#include <string>
+#include <utility>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include "../Data.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory {
+
+	// An entry in a table: a key and its value (or, for an index, a secondary key and its primary key).  Entries
+	// are ordered by their encoded key and then by their encoded value, which matches a Berkeley DB btree with
+	// sorted duplicates.
+	typedef std::pair<Data, Data> Entry;
+
+	///<summary>
+	/// This abstract class represents an ordered table of entries.  Rather than exposing iterators (which other
+	/// operations may invalidate), a table is traversed by seeking relative to an entry; the entry need not
+	/// itself be present in the table.
+	///</summary>
+	class Table
+		{
+		public:
+			virtual ~Table() { }
+
+			// Gets the first entry ordered after the given entry (or at it, if inclusive)
+			virtual boost::optional<Entry> next(const Entry& entry, const bool inclusive) const = 0;
+			// Gets the last entry ordered before the given entry (or at it, if inclusive)
+			virtual boost::optional<Entry> previous(const Entry& entry, const bool inclusive) const = 0;
+			// Gets the last entry in the table
+			virtual boost::optional<Entry> last() const = 0;
+			// Finds the first entry in the table with the given key
+			virtual boost::optional<Entry> find(const Data& key) const;
+
+			// Adds the given entry; returns false if it was already present
+			virtual bool insert(const Entry& entry) = 0;
+			// Removes the given entry; returns false if it was not present
+			virtual bool erase(const Entry& entry) = 0;
+
+			// Gets the first entry in the table
+			boost::optional<Entry> first() const 
+				{ return next(lowestEntry(Data::getUndefinedData()), true); }
+
+			// Gets an entry that is ordered before every entry with the given key
+			static Entry lowestEntry(const Data& key);
+		};
+
+	typedef boost::shared_ptr<Table> TablePtr;
+
+	///<summary>
+	/// This class represents a table held entirely in memory.
+	///</summary>
+	class MemoryTable : public Table
+		{
+		public:
+			virtual boost::optional<Entry> next(const Entry& entry, const bool inclusive) const;
+			virtual boost::optional<Entry> previous(const Entry& entry, const bool inclusive) const;
+			virtual boost::optional<Entry> last() const;
+
+			virtual bool insert(const Entry& entry) { return entries.insert(entry).second; }
+			virtual bool erase(const Entry& entry) { return entries.erase(entry) > 0; }
+
+		private:
+			std::set<Entry> entries;
+		};
+
+	///<summary>
+	/// This class holds the tables (object stores, indexes and metadata) that make up an in-memory database.
+	/// Storage is shared by every handle opened on the same database in this process, and lives for the
+	/// duration of the process (i.e. the browser session).  Nothing is written to disk, though derived storage
+	/// may persist the tables (each holder of the lock asks it to persist its changes before they are committed,
+	/// and it is notified as each holder completes).
+	///
+	/// Access to the tables is serialized by a single database-wide lock, which is held by a transaction
+	/// (or by a single non-transactional operation) until it completes.  A waiter that cannot acquire the
+	/// lock within its timeout fails with DEADLOCK_ERR, as it would under Berkeley DB.  A waiter on the thread
+	/// that already holds the lock (e.g. a second transaction begun on the browser thread while the first is
+	/// outstanding) could never see it released, and so fails with DEADLOCK_ERR at once rather than waiting.
+	///</summary>
+	class MemoryStorage
+		{
+		public:
+			// Gets the storage associated with the given database, creating it if necessary
+			static boost::shared_ptr<MemoryStorage> getInstance(const std::string& origin, const std::string& name);
+			virtual ~MemoryStorage() { }
+
+			// Table management; the caller must hold the database lock
+			TablePtr getTable(const std::string& name) const;
+			virtual TablePtr createTable();
+			virtual void setTable(const std::string& name, const TablePtr& table);
+			virtual void removeTable(const std::string& name);
+
+			// Acquires the database lock on behalf of the given owner, waiting at most the given number of milliseconds
+			// (but not at all if the lock is held by the calling thread)
+			void lock(const void* owner, const unsigned int timeout);
+			// Releases the database lock held by the given owner.  The owner's changes are either committed or
+			// have already been undone.
+			void unlock(const void* owner, const bool committed);
+			// Invoked (while the lock is still held, and before its undo actions are discarded) as the owner of the lock
+			// commits.  Throws if the owner's changes could not be made durable, in which case the owner undoes them.
+			virtual void persist() { }
+
+		protected:
+			MemoryStorage() : owner(NULL) { }
+
+			// Invoked (while the lock is still held) as the owner of the lock releases it
+			virtual void onRelease(const bool committed) { }
+
+		private:
+			std::map<std::string, TablePtr> tables;
+
+			// The owner of the database lock (if any), the thread on which it was acquired, and the synchronization
+			// primitives used to wait on it
+			const void* owner;
+			boost::thread::id ownerThread;
+			boost::mutex synchronization;
+			boost::condition_variable released;
+
+			void release();
+
+			// All storage created in this process, keyed by origin and database name
+			static std::map<std::string, boost::shared_ptr<MemoryStorage> > instances;
+			static boost::mutex instancesSynchronization;
+		};
+	}
+}
+}
+}
+
+#endif
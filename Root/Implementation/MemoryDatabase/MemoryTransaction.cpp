@@ -0,0 +1,184 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <boost/bind.hpp>
+#include "MemoryTransaction.h"
+#include "MemoryDatabase.h"
+#include "../ImplementationException.h"
+
+using std::string;
+using std::vector;
+using boost::mutex;
+using boost::lock_guard;
+using boost::optional;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory
+	{
+	const unsigned int MemoryTransaction::defaultTimeout = 2500;
+
+	MemoryTransaction::MemoryTransaction(MemoryDatabase& database, const optional<unsigned int>& timeout, TransactionContext& transactionContext)
+		: storage(database.getStorage()), parent(FromContext(transactionContext)), isActive(false)
+		{
+		if(parent == NULL)
+			storage.lock(this, timeout.is_initialized() ? timeout.get() : defaultTimeout);
+		isActive = true;
+		}
+
+	MemoryTransaction::~MemoryTransaction()
+		{
+		try
+			{ if(isActive) abort(); }
+		// Shouldn't be throwing in destructors, and there's really nothing that can be done here anyway
+		catch(ImplementationException&)
+			{ }
+		}
+
+	void MemoryTransaction::commit()
+		{
+		lock_guard<mutex> guard(synchronization);
+
+		if(!isActive)
+			throw ImplementationException(ImplementationException::NON_TRANSIENT_ERR);
+
+		// A nested transaction's changes become part of its parent, which may yet be aborted
+		if(parent != NULL)
+			for(vector<UndoAction>::const_iterator action = undoLog.begin(); action != undoLog.end(); action++)
+				parent->logUndo(*action);
+		// A top-level transaction's changes must be durable before we let go of the means to undo them
+		else
+			try
+				{ storage.persist(); }
+			catch(ImplementationException&)
+				{
+				undo();
+				complete(false);
+				throw;
+				}
+
+		complete(true);
+		}
+
+	void MemoryTransaction::abort()
+		{
+		lock_guard<mutex> guard(synchronization);
+
+		if(!isActive)
+			throw ImplementationException(ImplementationException::NON_TRANSIENT_ERR);
+
+		undo();
+		complete(false);
+		}
+
+	void MemoryTransaction::logUndo(const UndoAction& action)
+		{ undoLog.push_back(action); }
+
+	MemoryTransaction* MemoryTransaction::FromContext(TransactionContext& transactionContext)
+		{ return transactionContext.is_initialized()
+			&& static_cast<MemoryTransaction&>(transactionContext.get()).isActive
+				? &static_cast<MemoryTransaction&>(transactionContext.get())
+				: NULL; }
+
+	void MemoryTransaction::undo()
+		{
+		for(vector<UndoAction>::reverse_iterator action = undoLog.rbegin(); action != undoLog.rend(); action++)
+			(*action)();
+		}
+
+	void MemoryTransaction::complete(const bool committed)
+		{
+		isActive = false;
+		undoLog.clear();
+
+		if(parent == NULL)
+			storage.unlock(this, committed);
+		}
+
+	MemoryOperation::MemoryOperation(MemoryStorage& storage, TransactionContext& transactionContext)
+		: storage(storage), transaction(MemoryTransaction::FromContext(transactionContext)), isCommitted(false)
+		{
+		if(transaction == NULL)
+			storage.lock(this, MemoryTransaction::defaultTimeout);
+		}
+
+	MemoryOperation::~MemoryOperation()
+		{
+		if(!isCommitted)
+			{
+			for(vector<UndoAction>::reverse_iterator action = undoLog.rbegin(); action != undoLog.rend(); action++)
+				(*action)();
+
+			try
+				{ if(transaction == NULL) storage.unlock(this, false); }
+			// Shouldn't be throwing in destructors, and there's really nothing that can be done here anyway
+			catch(ImplementationException&)
+				{ }
+			}
+		}
+
+	bool MemoryOperation::insert(const TablePtr& table, const Entry& entry)
+		{
+		if(!table->insert(entry))
+			return false;
+
+		undoLog.push_back(boost::bind(&MemoryOperation::eraseEntry, table, entry));
+		return true;
+		}
+
+	void MemoryOperation::erase(const TablePtr& table, const Entry& entry)
+		{
+		// The given entry may be the very element we are about to erase
+		Entry erased(entry);
+
+		if(table->erase(erased))
+			undoLog.push_back(boost::bind(&MemoryOperation::insertEntry, table, erased));
+		}
+
+	void MemoryOperation::createTable(const string& name)
+		{
+		storage.setTable(name, storage.createTable());
+		undoLog.push_back(boost::bind(&MemoryStorage::removeTable, &storage, name));
+		}
+
+	void MemoryOperation::removeTable(const string& name)
+		{
+		TablePtr table = storage.getTable(name);
+
+		if(table)
+			{
+			storage.removeTable(name);
+			undoLog.push_back(boost::bind(&MemoryStorage::setTable, &storage, name, table));
+			}
+		}
+
+	void MemoryOperation::commit()
+		{
+		if(transaction != NULL)
+			for(vector<UndoAction>::const_iterator action = undoLog.begin(); action != undoLog.end(); action++)
+				transaction->logUndo(*action);
+		// Outside of a transaction the changes must first be durable; if they cannot be, they are undone as we leave scope
+		else
+			storage.persist();
+
+		undoLog.clear();
+		isCommitted = true;
+
+		// Outside of a transaction, the operation's changes are permanent once the lock is released
+		if(transaction == NULL)
+			storage.unlock(this, true);
+		}
+
+	void MemoryOperation::eraseEntry(const TablePtr& table, const Entry& entry)
+		{ table->erase(entry); }
+
+	void MemoryOperation::insertEntry(const TablePtr& table, const Entry& entry)
+		{ table->insert(entry); }
+	}
+}
+}
+}
@@ -0,0 +1,101 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYTRANSACTION_H
+#define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_MEMORY_MEMORYTRANSACTION_H
+
+#include <vector>
+#include <string>
+#include <boost/function.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
+#include "MemoryStorage.h"
+#include "../Transaction.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace Implementation {
+namespace Memory {
+
+	class MemoryDatabase;
+
+	// An action that reverses a single change to the storage
+	typedef boost::function<void ()> UndoAction;
+
+	///<summary>
+	/// This class represents a transaction over an in-memory database.  Changes are applied in place, and
+	/// each records an undo action; aborting a transaction applies its undo actions in reverse order.  A
+	/// top-level transaction holds the database lock until it completes; nested transactions share the lock
+	/// of their parent and, when committed, hand their undo actions to it.
+	///</summary>
+	class MemoryTransaction : public Transaction
+		{
+		public:
+			MemoryTransaction(MemoryDatabase& database, const boost::optional<unsigned int>& timeout, TransactionContext& transactionContext);
+			virtual ~MemoryTransaction();
+
+			virtual void commit();
+			virtual void abort();
+
+			// Records an action that reverses a change made within this transaction
+			void logUndo(const UndoAction& action);
+
+			/// Utility method to convert a transaction context into an active memory transaction (or NULL if there is none)
+			static MemoryTransaction* FromContext(TransactionContext& transactionContext);
+
+			// Number of milliseconds to wait for the database lock when no timeout is specified
+			static const unsigned int defaultTimeout;
+
+		private:
+			MemoryStorage& storage;
+			// The transaction in which this one is nested (NULL for a top-level transaction)
+			MemoryTransaction* const parent;
+			std::vector<UndoAction> undoLog;
+			bool isActive;
+
+			// Used for thread safety within critical sections
+			boost::mutex synchronization;
+
+			void undo();
+			void complete(const bool committed);
+		};
+
+	///<summary>
+	/// This class scopes a single operation against an in-memory database, so that the operation is atomic.
+	/// Within a transaction, the operation's changes are handed to the transaction once the operation commits;
+	/// otherwise, the operation acquires the database lock for its own duration and its changes are permanent
+	/// once it commits.  An operation that does not commit (e.g. because an exception was thrown) is undone
+	/// when it leaves scope.
+	///</summary>
+	class MemoryOperation
+		{
+		public:
+			MemoryOperation(MemoryStorage& storage, TransactionContext& transactionContext);
+			~MemoryOperation();
+
+			// Changes to the storage, each of which is recorded so that it may be undone
+			bool insert(const TablePtr& table, const Entry& entry);
+			void erase(const TablePtr& table, const Entry& entry);
+			void createTable(const std::string& name);
+			void removeTable(const std::string& name);
+
+			void commit();
+
+		private:
+			MemoryStorage& storage;
+			MemoryTransaction* const transaction;
+			std::vector<UndoAction> undoLog;
+			bool isCommitted;
+
+			static void eraseEntry(const TablePtr& table, const Entry& entry);
+			static void insertEntry(const TablePtr& table, const Entry& entry);
+		};
+	}
+}
+}
+}
+
+#endif
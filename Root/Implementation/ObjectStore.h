@@ -8,6 +8,8 @@ GNU Lesser General Public License
 #define BRANDONHAYNES_INDEXEDDB_IMPLEMENTATION_OBJECTSTORE_H
 
 #include <list>
+#include <string>
+#include <vector>
 #include <boost/optional.hpp>
 #include "Transaction.h"
 
@@ -26,6 +28,9 @@ namespace Implementation {
 		public:
 			// An enumeration representing the available object store read/write modes
 			enum Mode { READ_WRITE = 0, READ_ONLY = 1, SNAPSHOT_READ = 2 };
+			// An enumeration representing the ways in which an object store may organize its keys; a hashed object
+			// store offers faster point lookups, but its keys have no order (and so it supports no key ranges)
+			enum AccessMethod { ORDERED = 0, HASHED = 1 };
 
 			virtual ~ObjectStore() { }
 
@@ -35,6 +40,13 @@ namespace Implementation {
 			virtual void put(const Key& key, const Data& data, const bool noOverwrite, TransactionContext& transactionContext) = 0;
 			// Remove an item from the object store as identified by a key
 			virtual void remove(const Key& key, TransactionContext& transactionContext) = 0;
+			// Compress the values in this object store, using a dictionary trained from its current contents
+			virtual void enableCompression(TransactionContext& transactionContext) = 0;
+			// Freeze the object store (and the given indexes) into an immutable form optimized for reading; writes
+			// are not allowed until it is thawed.  Neither freezing nor thawing is allowed within a transaction.
+			virtual void freeze(const std::vector<std::string>& indexNames, TransactionContext& transactionContext) = 0;
+			// Return a frozen object store to its ordinary (writable) form
+			virtual void thaw(TransactionContext& transactionContext) = 0;
 			// Close this object store
 			virtual void close() = 0;
 
@@ -4,23 +4,62 @@ http://code.google.com/p/indexeddb
 GNU Lesser General Public License
 \**********************************************************/
 
+#include <variant_list.h>
+#include <boost/type_traits/is_same.hpp>
 #include "Convert.h"
 #include "BrowserObjectAPI.h"
 #include "BrowserHost.h"
 #include "DOM.h"
 #include "../API/DatabaseException.h"
+#include "../Implementation/KeyEncoding.h"
 
+using std::map;
 using std::string;
 using std::wstring;
+using boost::mutex;
+using boost::lock_guard;
 
 namespace BrandonHaynes {
 namespace IndexedDB { 
 
 using Implementation::Key;
 using Implementation::Data;
+using Implementation::KeyEncoding;
+using Implementation::ImplementationException;
 
 namespace API { 
 
+const char* const Convert::helperParameters[HELPER_COUNT] = { "bytes", "s", "key, value", "key, value" };
+const char* const Convert::helperBodies[HELPER_COUNT] = {
+	// BYTES_TO_STRING: one character per byte (fromCharCode is applied in chunks, to stay within argument limits)
+	"var s = ''; for (var i = 0; i < bytes.length; i += 8192) s += String.fromCharCode.apply(null, bytes.subarray(i, i + 8192)); return s;",
+	// STRING_TO_BYTES: the reverse
+	"var bytes = new Uint8Array(s.length); for (var i = 0; i < s.length; i++) bytes[i] = s.charCodeAt(i); return bytes;",
+	// DATE_REPLACER: tags a date with its timestamp (rather than leaving it to Date.toJSON), and escapes property names
+	// beginning with a tilde so that no user property may be mistaken for the '~date' tag
+	"var date = this[key];"
+	"if (Object.prototype.toString.call(date) === '[object Date]') {"
+	"  if (isNaN(date.getTime())) throw new RangeError('Invalid dates may not be stored.');"
+	"  return { '~date': date.getTime() }; }"
+	"if (value === null || typeof value !== 'object' || Object.prototype.toString.call(value) === '[object Array]') return value;"
+	"var escaped = null;"
+	"for (var name in value) if (Object.prototype.hasOwnProperty.call(value, name) && name.charAt(0) === '~') { escaped = {}; break; }"
+	"if (escaped === null) return value;"
+	"for (var name in value) if (Object.prototype.hasOwnProperty.call(value, name)) escaped[name.charAt(0) === '~' ? '~' + name : name] = value[name];"
+	"return escaped;",
+	// DATE_REVIVER: the reverse; revives tagged dates and drops the escaping tilde
+	"if (value === null || typeof value !== 'object' || Object.prototype.toString.call(value) === '[object Array]') return value;"
+	"if (Object.prototype.hasOwnProperty.call(value, '~date')) return new Date(value['~date']);"
+	"var unescaped = null;"
+	"for (var name in value) if (Object.prototype.hasOwnProperty.call(value, name) && name.charAt(0) === '~') { unescaped = {}; break; }"
+	"if (unescaped === null) return value;"
+	"for (var name in value) if (Object.prototype.hasOwnProperty.call(value, name)) unescaped[name.charAt(0) === '~' ? name.substring(1) : name] = value[name];"
+	"return unescaped;" };
+map<const FB::BrowserHost*, Convert::Helpers> Convert::helpers;
+mutex Convert::helpersSynchronization;
+const char* const Convert::binaryConstructors[] = { "ArrayBuffer", "DataView", "Int8Array", "Uint8Array", "Uint8ClampedArray",
+	"Int16Array", "Uint16Array", "Int32Array", "Uint32Array", "Float32Array", "Float64Array", NULL };
+
 Data Convert::toData(const FB::BrowserHostPtr& host, const FB::variant& variant)
 	{ return convert<Data>(host, variant); }
 
@@ -45,6 +84,75 @@ T Convert::convert(const FB::BrowserHostPtr& host, const FB::variant& variant)
 			string stringifiedObject = stringify(host, variant.cast<FB::JSObjectPtr>());
 			return T((void *)stringifiedObject.c_str(), stringifiedObject.size() + 1, Data::Object);
 			}
+		case Data::Date:
+			{
+			double milliseconds = variant.cast<FB::JSObjectPtr>()->Invoke("getTime", FB::VariantList()).convert_cast<double>();
+
+			// An invalid date has no timestamp (NaN), and so no meaningful order
+			if(milliseconds != milliseconds)
+				throw DatabaseException("Invalid dates may not be stored.", DatabaseException::DATA_ERR);
+
+			return T(KeyEncoding::fromMilliseconds(static_cast<boost::int64_t>(milliseconds)));
+			}
+		case Data::Binary:
+			{
+			// Typed arrays may use wider elements, so we always read through a byte view of the buffer
+			FB::JSObjectPtr binary = variant.cast<FB::JSObjectPtr>();
+			FB::VariantList arguments(1, binary->HasProperty("buffer") ? binary->GetProperty("buffer") : FB::variant(binary));
+			if(binary->HasProperty("byteOffset"))
+				{
+				arguments.push_back(binary->GetProperty("byteOffset"));
+				arguments.push_back(binary->GetProperty("byteLength"));
+				}
+			
+			FB::JSObjectPtr bytes = construct(host, "Uint8Array", arguments);
+
+			// The bytes cross the plugin boundary in one call, as a string with one character per byte; it reaches
+			// us UTF-8 encoded, so each character above 0x7F arrives as a two-byte sequence
+			const string characters = getHelper(host, BYTES_TO_STRING)->Invoke("", FB::variant_list_of(bytes)).convert_cast<string>();
+
+			// The characters are decoded straight into the encoded buffer, which the result then adopts
+			std::vector<unsigned char> buffer;
+			buffer.reserve(characters.size() + 1);
+			buffer.push_back(Data::Binary);
+			for(string::const_iterator character = characters.begin(); character != characters.end(); character++)
+				{
+				const unsigned char lead = static_cast<unsigned char>(*character);
+				if(lead < 0x80)
+					buffer.push_back(lead);
+				else if((lead == 0xC2 || lead == 0xC3) && character + 1 != characters.end())
+					buffer.push_back(static_cast<unsigned char>(((lead & 0x03) << 6) | (static_cast<unsigned char>(*++character) & 0x3F)));
+				else
+					throw DatabaseException("Binary conversion failed.", DatabaseException::DATA_ERR);
+				}
+
+			return T(buffer);
+			}
+		case Data::Array:
+			{
+			FB::JSObjectPtr array = variant.cast<FB::JSObjectPtr>();
+			int length = array->GetProperty("length").convert_cast<int>();
+			std::vector<unsigned char> buffer(1, Data::Array);
+
+			try
+				{
+				// Each element is converted as usual and then appended in its order-preserving form
+				for(int index = 0; index < length; index++)
+					KeyEncoding::appendElement(buffer, convert<T>(host, array->GetProperty(index)));
+				KeyEncoding::appendTerminator(buffer);
+				}
+			catch(ImplementationException& e)
+				{
+				// Only keys are restricted; any other array is stored as an ordinary (JSON) object
+				if(boost::is_same<T, Key>::value)
+					throw DatabaseException("Array keys may not contain undefined or null elements.", e);
+
+				string stringifiedArray = stringify(host, array);
+				return T((void *)stringifiedArray.c_str(), stringifiedArray.size() + 1, Data::Object);
+				}
+
+			return T(buffer);
+			}
 		case Data::Undefined:
 			return T::getUndefinedData();
 		case Data::Null:
@@ -68,6 +176,37 @@ FB::variant Convert::toVariant(const FB::BrowserHostPtr& host, const Data& data)
 			return *static_cast<const double *>(data.getRawValue());
 		case Data::Object:
 			return parse(host, string(static_cast<const char*>(data.getRawValue())));
+		case Data::Array:
+			{
+			FB::JSObjectPtr array = parse(host, "[]").cast<FB::JSObjectPtr>();
+			std::vector<Data> elements = KeyEncoding::decodeArray(data);
+
+			for(std::vector<Data>::const_iterator iterator = elements.begin(); iterator != elements.end(); iterator++)
+				array->Invoke("push", FB::VariantList(1, toVariant(host, *iterator)));
+
+			return array;
+			}
+		case Data::Date:
+			return construct(host, "Date", FB::VariantList(1, static_cast<double>(KeyEncoding::toMilliseconds(data))));
+		case Data::Binary:
+			{
+			// As above, the bytes are handed across in one call as a (UTF-8 encoded) string with one character per byte
+			const unsigned char* value = static_cast<const unsigned char*>(data.getRawValue());
+			const size_t length = data.getSize() - 1;
+			string characters;
+
+			characters.reserve(2 * length);
+			for(size_t index = 0; index < length; index++)
+				if(value[index] < 0x80)
+					characters.push_back(static_cast<char>(value[index]));
+				else
+					{
+					characters.push_back(static_cast<char>(0xC0 | (value[index] >> 6)));
+					characters.push_back(static_cast<char>(0x80 | (value[index] & 0x3F)));
+					}
+
+			return getHelper(host, STRING_TO_BYTES)->Invoke("", FB::variant_list_of(characters));
+			}
 		case Data::Null:
 			return FB::FBNull();
 		case Data::Undefined:
@@ -88,13 +227,92 @@ Data::ECMAType Convert::getType(const FB::variant& variant)
 	else if(variant.is_of_type<double>())
 		return Data::Number;
 	else if(variant.is_of_type<FB::JSObjectPtr>())
-		return Data::Object;
+		{
+		FB::JSObjectPtr object = variant.cast<FB::JSObjectPtr>();
+		return isBinary(object) ? Data::Binary
+			: isArray(object) ? Data::Array 
+			: isDate(object) ? Data::Date
+			: Data::Object;
+		}
 	else if(variant.empty())
 		return Data::Undefined;
 	else
 		throw DatabaseException("An unexpected variant type was encountered.", DatabaseException::UNKNOWN_ERR);
 	}
 
+bool Convert::isArray(const FB::JSObjectPtr& object)
+	{
+	// We can't reach Array.isArray without a host, so we settle for recognizing the array shape
+	return object != NULL && object->HasProperty("length") && object->HasMethod("push") && object->HasMethod("join");
+	}
+
+// Dates are recognized by their accessors, since instanceof is not available to us here
+bool Convert::isDate(const FB::JSObjectPtr& object)
+	{ return object != NULL && object->HasMethod("getTime") && object->HasMethod("getTimezoneOffset"); }
+
+// Binary values are recognized by their constructor, since any object might have a byteLength
+bool Convert::isBinary(const FB::JSObjectPtr& object)
+	{
+	if(object == NULL || !object->HasProperty("byteLength"))
+		return false;
+
+	const FB::variant constructor = object->GetProperty("constructor");
+	if(!constructor.is_of_type<FB::JSObjectPtr>())
+		return false;
+
+	const string name = constructor.cast<FB::JSObjectPtr>()->GetProperty("name").convert_cast<string>();
+	for(const char* const* binaryConstructor = binaryConstructors; *binaryConstructor != NULL; binaryConstructor++)
+		if(name == *binaryConstructor)
+			return true;
+	return false;
+	}
+
+FB::JSObjectPtr Convert::construct(const FB::BrowserHostPtr& host, const std::string& constructor, const FB::VariantList& arguments)
+	{
+	if(host == NULL)
+		throw DatabaseException("Browser host was null.", DatabaseException::NOT_FOUND_ERR);
+	else if(!host->getDOMWindow()->getProperty<FB::variant>(constructor).is_of_type<FB::JSObjectPtr>())
+		throw DatabaseException("window." + constructor + " support not available.", DatabaseException::NOT_FOUND_ERR);
+
+	FB::variant result = host->getDOMWindow()->getProperty<FB::JSObjectPtr>(constructor)->Construct(arguments);
+
+	if(!result.is_of_type<FB::JSObjectPtr>())
+		throw DatabaseException("Construction of " + constructor + " failed.", DatabaseException::RECOVERABLE_ERR);
+	else
+		return result.cast<FB::JSObjectPtr>();
+	}
+
+FB::JSObjectPtr Convert::compile(const FB::BrowserHostPtr& host, const std::string& parameter, const std::string& body)
+	{
+	FB::VariantList arguments;
+	arguments.push_back(parameter);
+	arguments.push_back(body);
+	return construct(host, "Function", arguments);
+	}
+
+FB::JSObjectPtr Convert::getHelper(const FB::BrowserHostPtr& host, const Helper helper)
+	{
+	lock_guard<mutex> guard(helpersSynchronization);
+
+	// The helpers of hosts that have gone are released (another host may since occupy the same address)
+	for(map<const FB::BrowserHost*, Helpers>::iterator current = helpers.begin(); current != helpers.end(); )
+		if(current->second.host.expired())
+			helpers.erase(current++);
+		else
+			current++;
+
+	Helpers& cached = helpers[host.get()];
+	if(cached.host.lock() != host)
+		{
+		cached = Helpers();
+		cached.host = host;
+		}
+
+	if(!cached.functions[helper])
+		cached.functions[helper] = compile(host, helperParameters[helper], helperBodies[helper]);
+	return cached.functions[helper];
+	}
+
 std::string Convert::stringify(const FB::BrowserHostPtr& host, const FB::JSObjectPtr& object)
 	{
 	if(host == NULL)
@@ -108,8 +326,15 @@ std::string Convert::stringify(const FB::BrowserHostPtr& host, const FB::JSObjec
 		throw DatabaseException("window.JSON support not available.", DatabaseException::NOT_FOUND_ERR);
 	else if(json->HasMethod("stringify"))
 		{
+		// Nested dates are tagged with their timestamp so that parse may revive them
 		FB::VariantList arguments(1, object);
-		FB::variant result = json->Invoke("stringify", arguments);
+		arguments.push_back(getHelper(host, DATE_REPLACER));
+		FB::variant result;
+
+		try
+			{ result = json->Invoke("stringify", arguments); }
+		catch(const FB::script_error&)
+			{ throw DatabaseException("JSON Stringification failed; the object contains an invalid date or a cycle.", DatabaseException::DATA_ERR); }
 
 		if(result.empty())
 			throw DatabaseException("JSON Stringification failed.", DatabaseException::RECOVERABLE_ERR);
@@ -133,7 +358,9 @@ FB::variant Convert::parse(const FB::BrowserHostPtr& host, const std::string& st
 		throw DatabaseException("window.JSON support not available.", DatabaseException::NOT_FOUND_ERR);
 	else if(json->HasMethod("parse"))
 		{
+		// Revive the dates tagged during stringification
 		FB::VariantList arguments(1, string);
+		arguments.push_back(getHelper(host, DATE_REVIVER));
 		FB::variant result = json->Invoke("parse", arguments);
 
 		if(result.empty())
@@ -7,6 +7,9 @@ GNU Lesser General Public License
 #ifndef BRANDONHAYNES_INDEXEDDB_SUPPORT_CONVERT_H
 #define BRANDONHAYNES_INDEXEDDB_SUPPORT_CONVERT_H
 
+#include <map>
+#include <boost/weak_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include <JSAPIAuto.h>
 #include "../Implementation/Key.h"
 #include "../Implementation/Data.h"
@@ -41,7 +44,9 @@ namespace API {
 		/// Given a variant, returns the ECMAType associated with that value (in a form digestiable by the implementation)
 		static Implementation::Data::ECMAType getType(const FB::variant& variant);
 
-		/// Stringifies the given object (requires a host instance to access the browser JSON implementation)
+		/// Stringifies the given object (requires a host instance to access the browser JSON implementation).  Dates nested
+		/// within the object are tagged so that they survive the round trip through parse; property names beginning with
+		/// a tilde are escaped (by a second tilde) so that they are never mistaken for that tag.
 		static std::string stringify(const FB::BrowserHostPtr& host, const FB::JSObjectPtr& object);
 		/// Parses a given string into a FireBreath JSOutObject instance (requires a host instance to access the browser JSON implementation)
 		static FB::variant parse(const FB::BrowserHostPtr& host, const std::string& string);
@@ -51,6 +56,35 @@ namespace API {
 
 		template<class T>
 		static T convert(const FB::BrowserHostPtr& host, const FB::variant& variant);
+		// Determines whether the given object is a script array (and so should be treated as a compound key)
+		static bool isArray(const FB::JSObjectPtr& object);
+		// Determines whether the given object is an ArrayBuffer or typed array (and so should be stored as binary)
+		static bool isBinary(const FB::JSObjectPtr& object);
+		// Determines whether the given object is a script Date (and so should be stored as a timestamp)
+		static bool isDate(const FB::JSObjectPtr& object);
+		// Constructs a new instance of the named window-level constructor (e.g. Uint8Array) with the given arguments
+		static FB::JSObjectPtr construct(const FB::BrowserHostPtr& host, const std::string& constructor, const FB::VariantList& arguments);
+		// Compiles a script function taking the named parameter(s), so that work may be done on the browser side of the plugin boundary
+		static FB::JSObjectPtr compile(const FB::BrowserHostPtr& host, const std::string& parameter, const std::string& body);
+
+		// The script functions we compile, once per host, to do work on the browser side of the plugin boundary
+		enum Helper { BYTES_TO_STRING = 0, STRING_TO_BYTES = 1, DATE_REPLACER = 2, DATE_REVIVER = 3, HELPER_COUNT = 4 };
+		struct Helpers
+			{
+			boost::weak_ptr<FB::BrowserHost> host;
+			FB::JSObjectPtr functions[HELPER_COUNT];
+			};
+		// The parameters and body of each helper, by Helper
+		static const char* const helperParameters[HELPER_COUNT];
+		static const char* const helperBodies[HELPER_COUNT];
+		// The helpers compiled for each live host
+		static std::map<const FB::BrowserHost*, Helpers> helpers;
+		static boost::mutex helpersSynchronization;
+		// Gets the given helper for the given host, compiling it on first use
+		static FB::JSObjectPtr getHelper(const FB::BrowserHostPtr& host, const Helper helper);
+
+		// The constructors of the binary types (ArrayBuffer, DataView and the typed arrays)
+		static const char* const binaryConstructors[];
 	};
 
 }
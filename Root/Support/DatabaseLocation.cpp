@@ -58,6 +58,13 @@ const string DatabaseLocation::getObjectStorePath(const string& origin, const st
 	return (userHome / databaseHome / (origin.size() != 0 ? origin : "local_filesystem") / databaseName / objectStoreName).file_string();
 	}
 
+const string DatabaseLocation::getConfigurationPath(const string& origin, const string& fileName)
+	{
+	ensurePathValid(origin);
+	ensurePathValid(fileName);
+	return (userHome / databaseHome / (origin.size() != 0 ? origin : "local_filesystem") / fileName).file_string();
+	}
+
 void DatabaseLocation::ensurePathValid(const std::string& path)
 	{
 	if(path.find("..") != string::npos || path.find_first_of(illegalFilenameCharacters) != string::npos)
@@ -25,6 +25,8 @@ class DatabaseLocation
 		static const std::string getDatabasePath(const std::string& origin, const std::string& databaseName);
 		// Gets a valid object storage path for this origin, specific to a given user (and underneath the database path)
 		static const std::string getObjectStorePath(const std::string& origin, const std::string& databaseName, const std::string& objectStoreName);
+		// Gets the path of a configuration file shared by all databases in this origin (which need not exist)
+		static const std::string getConfigurationPath(const std::string& origin, const std::string& fileName);
 		// Given a path, performs some sanity checks on it to ensure that there is no cross-origin or naming issues
 		static void ensurePathValid(const std::string& path);
 
@@ -0,0 +1,50 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include "ReadSet.h"
+#include "../API/Synchronized/ObjectStoreSync.h"
+#include "../Implementation/ObjectStore.h"
+
+using boost::mutex;
+using boost::lock_guard;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+
+using Implementation::Key;
+using Implementation::Data;
+using Implementation::TransactionContext;
+
+namespace API {
+namespace Support {
+
+void ReadSet::record(const boost::shared_ptr<ObjectStoreSync>& objectStore, const Key& key, const Data& data)
+	{
+	lock_guard<mutex> guard(synchronization);
+	reads.insert(Reads::value_type(Location(objectStore->getName(), key), Read(objectStore, data)));
+	}
+
+bool ReadSet::validate(TransactionContext& transactionContext)
+	{
+	lock_guard<mutex> guard(synchronization);
+
+	for(Reads::const_iterator read = reads.begin(); read != reads.end(); read++)
+		if(!(read->second.first->getImplementation().get(read->first.second, transactionContext) == read->second.second))
+			return false;
+
+	return true;
+	}
+
+void ReadSet::clear()
+	{
+	lock_guard<mutex> guard(synchronization);
+	reads.clear();
+	}
+
+}
+}
+}
+}
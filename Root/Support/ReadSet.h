@@ -0,0 +1,57 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_SUPPORT_READSET_H
+#define BRANDONHAYNES_INDEXEDDB_SUPPORT_READSET_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "../Implementation/Key.h"
+#include "../Implementation/Data.h"
+#include "../Implementation/Transaction.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace API {
+
+class ObjectStoreSync;
+
+namespace Support {
+
+///<summary>
+/// This class represents the values read by an optimistic transaction, as they were when each was first read
+/// (undefined for a key that was absent).  A value serves as its own version: the reads are valid so long as
+/// each key still holds the value that was read.
+///</summary>
+class ReadSet
+	{
+	public:
+		// Records the value read for the given key of the given object store (unless a value is already recorded)
+		void record(const boost::shared_ptr<ObjectStoreSync>& objectStore, const Implementation::Key& key, const Implementation::Data& data);
+
+		// Determines whether every recorded key still holds the value that was read, reading within the given transaction
+		bool validate(Implementation::TransactionContext& transactionContext);
+		// Discards the recorded reads
+		void clear();
+
+	private:
+		typedef std::pair<std::string, Implementation::Key> Location;
+		typedef std::pair<boost::shared_ptr<ObjectStoreSync>, Implementation::Data> Read;
+		typedef std::map<Location, Read> Reads;
+
+		Reads reads;
+		boost::mutex synchronization;
+	};
+
+}
+}
+}
+}
+
+#endif
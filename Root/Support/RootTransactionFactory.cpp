@@ -26,6 +26,20 @@ Implementation::TransactionContext RootTransactionFactory::getTransactionContext
 		: TransactionContext();
 	}
 
+Support::WriteSet* RootTransactionFactory::getWriteSet() const
+	{ 
+	return database->currentTransaction
+		? database->currentTransaction->getWriteSet()
+		: NULL;
+	}
+
+Support::ReadSet* RootTransactionFactory::getReadSet() const
+	{ 
+	return database->currentTransaction
+		? database->currentTransaction->getReadSet()
+		: NULL;
+	}
+
 void RootTransactionFactory::setDatabaseSync( const DatabaseSyncPtr& ptr )
 {
     database = ptr;
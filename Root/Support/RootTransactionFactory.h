@@ -29,6 +29,8 @@ namespace API {
 			virtual Implementation::TransactionContext getTransactionContext() const;
 			virtual Implementation::Database& getDatabaseContext() const
 				{ return implementation; }
+			virtual Support::WriteSet* getWriteSet() const;
+			virtual Support::ReadSet* getReadSet() const;
 
 			// Associate a new transaction factory with the given database and underlying implementation
 			RootTransactionFactory(Implementation::Database& implementation) 
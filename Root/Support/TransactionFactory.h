@@ -10,7 +10,10 @@ GNU Lesser General Public License
 #include <vector>
 #include <string>
 #include "../Implementation/Transaction.h"
+#include "../Implementation/Database.h"
 #include "../Implementation/AbstractDatabaseFactory.h"
+#include "WriteSet.h"
+#include "ReadSet.h"
 
 typedef std::vector<std::string> StringVector;
 
@@ -36,16 +39,39 @@ class TransactionFactory
 			{ return transactionFactory->getTransactionContext(); }
 		virtual Implementation::Database& getDatabaseContext() const
 			{ return transactionFactory->getDatabaseContext(); }
+		// The writes buffered by the current transaction (NULL unless it is buffered; see TransactionSync)
+		virtual Support::WriteSet* getWriteSet() const
+			{ return transactionFactory->getWriteSet(); }
+		// The reads recorded by the current transaction (NULL unless it is optimistic; see TransactionSync)
+		virtual Support::ReadSet* getReadSet() const
+			{ return transactionFactory->getReadSet(); }
+		// The factory for the engine that backs the current database
+		Implementation::AbstractDatabaseFactory& getFactory() const
+			{ return getDatabaseContext().getFactory(); }
+
+		// Applies (and then discards) the writes buffered by the current transaction (if any), for operations that do
+		// not read them; this is not allowed until an optimistic transaction commits
+		void applyWrites() const
+			{
+			Support::WriteSet* writeSet = getWriteSet();
+			if(writeSet != NULL)
+				{
+				writeSet->apply(getTransactionContext());
+				writeSet->clear();
+				}
+			}
 
 		std::auto_ptr<Implementation::Transaction> createTransaction() const
 			{ return createTransaction(getTransactionContext()); }
 
 		// We know how to initiate a new transaction, so do it here
 		std::auto_ptr<Implementation::Transaction> createTransaction(Implementation::TransactionContext& transactionContext) const
-			{ return Implementation::AbstractDatabaseFactory::getInstance()
+			{ return getFactory()
 				.createTransaction(getDatabaseContext(), 
 					Implementation::ObjectStoreImplementationList(), 
+					boost::optional<Implementation::ObjectStore::Mode>(), 
 					boost::optional<unsigned int>(), 
+					boost::optional<Implementation::DatabaseConfiguration::Durability>(), 
 					transactionContext); }
 
 	protected:
@@ -0,0 +1,108 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include <boost/bind.hpp>
+#include "WorkerPool.h"
+
+using boost::mutex;
+using boost::lock_guard;
+using boost::unique_lock;
+
+namespace BrandonHaynes {
+namespace IndexedDB { 
+namespace API { 
+namespace Support {
+
+WorkerPool::WorkerPool(const size_t workers)
+	: isStopping(false)
+	{
+	for(size_t index = 0; index < workers; index++)
+		this->workers.create_thread(boost::bind(&WorkerPool::run, this));
+	}
+
+WorkerPool::~WorkerPool()
+	{
+		{
+		lock_guard<mutex> guard(synchronization);
+		isStopping = true;
+		available.notify_all();
+		}
+
+	workers.join_all();
+	}
+
+void WorkerPool::schedule(const Work& work)
+	{
+	lock_guard<mutex> guard(synchronization);
+	pending.push_back(work);
+	available.notify_one();
+	}
+
+void WorkerPool::run()
+	{
+	while(true)
+		{
+		Work work;
+
+			{
+			unique_lock<mutex> lock(synchronization);
+			while(pending.empty() && !isStopping)
+				available.wait(lock);
+
+			if(pending.empty())
+				return;
+
+			work = pending.front();
+			pending.pop_front();
+			}
+
+		try
+			{ work(); }
+		catch(...) { }
+		}
+	}
+
+void WorkerPool::Strand::schedule(const Work& work)
+	{
+	lock_guard<mutex> guard(synchronization);
+	pending.push_back(work);
+
+	// The pool holds a reference to this strand for as long as it has work to run
+	if(!isScheduled)
+		{
+		isScheduled = true;
+		pool.schedule(boost::bind(&Strand::run, shared_from_this()));
+		}
+	}
+
+void WorkerPool::Strand::run()
+	{
+	while(true)
+		{
+		Work work;
+
+			{
+			lock_guard<mutex> guard(synchronization);
+			if(pending.empty())
+				{
+				isScheduled = false;
+				return;
+				}
+
+			work = pending.front();
+			pending.pop_front();
+			}
+
+		try
+			{ work(); }
+		catch(...) { }
+		}
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,80 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_SUPPORT_WORKERPOOL_H
+#define BRANDONHAYNES_INDEXEDDB_SUPPORT_WORKERPOOL_H
+
+#include <deque>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace BrandonHaynes {
+namespace IndexedDB { 
+namespace API { 
+namespace Support {
+
+///<summary>
+/// This class represents a pool of worker threads on which (blocking) database work is executed, away from the
+/// browser thread.  Work is expected to report its own errors; anything it throws is discarded.  Work that remains
+/// when the pool is destroyed is finished before the workers are joined, so work must not hold the last reference
+/// to the owner of its pool (a pool cannot be destroyed from one of its own workers).
+///</summary>
+class WorkerPool
+	{
+	public:
+		typedef boost::function<void ()> Work;
+
+		explicit WorkerPool(const size_t workers);
+		~WorkerPool();
+
+		// Schedules work to be executed on the next available worker
+		void schedule(const Work& work);
+
+		///<summary>
+		/// This class represents a sequence of work executed on a pool one item at a time, in the order in which
+		/// it was scheduled (though not necessarily always on the same worker).
+		///</summary>
+		class Strand : public boost::enable_shared_from_this<Strand>
+			{
+			public:
+				explicit Strand(WorkerPool& pool)
+					: pool(pool), isScheduled(false)
+					{ }
+
+				// Schedules work to be executed once all work previously scheduled on this strand has finished
+				void schedule(const Work& work);
+
+			private:
+				WorkerPool& pool;
+				std::deque<Work> pending;
+				// Flag indicating whether this strand is currently queued on (or running in) the pool
+				bool isScheduled;
+				boost::mutex synchronization;
+
+				void run();
+			};
+
+	private:
+		std::deque<Work> pending;
+		boost::thread_group workers;
+		boost::mutex synchronization;
+		boost::condition_variable available;
+		bool isStopping;
+
+		// Method executed by each worker; runs work until the pool is stopped and no work remains
+		void run();
+	};
+
+}
+}
+}
+}
+
+#endif
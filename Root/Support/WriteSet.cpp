@@ -0,0 +1,75 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#include "WriteSet.h"
+#include "../API/Synchronized/ObjectStoreSync.h"
+#include "../Implementation/ObjectStore.h"
+#include "../Implementation/ImplementationException.h"
+
+using std::string;
+using boost::optional;
+using boost::mutex;
+using boost::lock_guard;
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+
+using Implementation::Key;
+using Implementation::Data;
+using Implementation::TransactionContext;
+using Implementation::ImplementationException;
+
+namespace API {
+namespace Support {
+
+void WriteSet::put(const boost::shared_ptr<ObjectStoreSync>& objectStore, const Key& key, const Data& data)
+	{
+	lock_guard<mutex> guard(synchronization);
+
+	const Location location(objectStore->getName(), key);
+	writes.erase(location);
+	writes.insert(Writes::value_type(location, Write(objectStore, data)));
+	}
+
+void WriteSet::remove(const boost::shared_ptr<ObjectStoreSync>& objectStore, const Key& key)
+	{ put(objectStore, key, Data::getUndefinedData()); }
+
+optional<Data> WriteSet::find(const string& objectStoreName, const Key& key)
+	{
+	lock_guard<mutex> guard(synchronization);
+
+	Writes::const_iterator write = writes.find(Location(objectStoreName, key));
+	return write != writes.end()
+		? optional<Data>(write->second.second)
+		: optional<Data>();
+	}
+
+void WriteSet::apply(TransactionContext& transactionContext)
+	{
+	// Outside of a transaction (e.g. before an optimistic transaction commits) our writes could not be undone
+	if(!transactionContext.is_initialized())
+		throw ImplementationException("NOT_ALLOWED_ERR", ImplementationException::NOT_ALLOWED_ERR);
+
+	lock_guard<mutex> guard(synchronization);
+
+	// Keys are visited in order, so that locks are acquired in a consistent order across transactions
+	for(Writes::const_iterator write = writes.begin(); write != writes.end(); write++)
+		if(write->second.second.getType() == Data::Undefined)
+			write->second.first->getImplementation().remove(write->first.second, transactionContext);
+		else
+			write->second.first->getImplementation().put(write->first.second, write->second.second, false, transactionContext);
+	}
+
+void WriteSet::clear()
+	{
+	lock_guard<mutex> guard(synchronization);
+	writes.clear();
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,64 @@
+/**********************************************************\
+Copyright Brandon Haynes
+http://code.google.com/p/indexeddb
+GNU Lesser General Public License
+\**********************************************************/
+
+#ifndef BRANDONHAYNES_INDEXEDDB_SUPPORT_WRITESET_H
+#define BRANDONHAYNES_INDEXEDDB_SUPPORT_WRITESET_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "../Implementation/Key.h"
+#include "../Implementation/Data.h"
+#include "../Implementation/Transaction.h"
+
+namespace BrandonHaynes {
+namespace IndexedDB {
+namespace API {
+
+class ObjectStoreSync;
+
+namespace Support {
+
+///<summary>
+/// This class represents the writes buffered by a transaction, ordered by object store name and then by key.
+/// Nothing is written to (nor locked in) the underlying object stores until the set is applied, which happens
+/// in key order; until then, the transaction reads its own writes from this set.  A removal is buffered as
+/// undefined data.
+///</summary>
+class WriteSet
+	{
+	public:
+		// Buffers a put of the given key/value pair into the given object store
+		void put(const boost::shared_ptr<ObjectStoreSync>& objectStore, const Implementation::Key& key, const Implementation::Data& data);
+		// Buffers the removal of the given key from the given object store
+		void remove(const boost::shared_ptr<ObjectStoreSync>& objectStore, const Implementation::Key& key);
+		// Gets the data buffered for the given key (undefined if it was removed), or nothing if no write is buffered
+		boost::optional<Implementation::Data> find(const std::string& objectStoreName, const Implementation::Key& key);
+
+		// Applies the buffered writes in order within the given transaction (there must be one); they remain buffered
+		// (so that they may be applied again, should that transaction fail) until cleared
+		void apply(Implementation::TransactionContext& transactionContext);
+		// Discards the buffered writes
+		void clear();
+
+	private:
+		typedef std::pair<std::string, Implementation::Key> Location;
+		typedef std::pair<boost::shared_ptr<ObjectStoreSync>, Implementation::Data> Write;
+		typedef std::map<Location, Write> Writes;
+
+		Writes writes;
+		boost::mutex synchronization;
+	};
+
+}
+}
+}
+}
+
+#endif
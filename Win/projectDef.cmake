@@ -45,6 +45,7 @@ set_target_properties (${PROJNAME} PROPERTIES
 target_link_libraries(${PROJNAME}
     ${PLUGIN_INTERNAL_DEPS}
     ${BERKELEYDB_LIBRARIES}
+    ${ZLIB_LIBRARIES}
     )
 
 set(WIX_HEAT_FLAGS
@@ -37,6 +37,7 @@ set_target_properties (${PROJNAME} PROPERTIES
 # add library dependencies here; leave ${PLUGIN_INTERNAL_DEPS} there unless you know what you're doing!
 target_link_libraries(${PROJNAME}
     ${PLUGIN_INTERNAL_DEPS}
+    ${ZLIB_LIBRARIES}
     )
 
 add_dependencies(${PROJNAME}